@@ -0,0 +1,59 @@
+#include "backgroundjob.h"
+
+BackgroundJob::BackgroundJob(QObject *owner)
+    : m_owner(owner)
+{
+}
+
+BackgroundJob::~BackgroundJob()
+{
+    cancel();
+}
+
+void BackgroundJob::start(Work work)
+{
+    cancel();
+
+    const quint64 generation = ++m_generation;
+    const quint64 job = ++m_job;
+    m_jobGeneration = generation;
+    m_cancelled = false;
+
+    m_thread = QThread::create([this, work, generation, job]() {
+        const Done done = work();
+        QMetaObject::invokeMethod(m_owner, [this, done, generation, job]() {
+            // 被 cancel() 回收的线程不再处理；discard() 过的线程在这里回收
+            if (job == m_job && m_thread) {
+                m_thread->wait();
+                delete m_thread;
+                m_thread = nullptr;
+            }
+            if (generation == m_generation && done) done();
+            if (m_idle && !m_thread) m_idle();
+        }, Qt::QueuedConnection);
+    });
+    m_thread->start();
+}
+
+void BackgroundJob::cancel()
+{
+    ++m_generation;
+    if (!m_thread) return;
+    m_cancelled = true;
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+}
+
+void BackgroundJob::discard()
+{
+    ++m_generation;
+}
+
+void BackgroundJob::post(Done fn)
+{
+    const quint64 generation = m_jobGeneration;
+    QMetaObject::invokeMethod(m_owner, [this, fn, generation]() {
+        if (generation == m_generation) fn();
+    }, Qt::QueuedConnection);
+}
@@ -0,0 +1,48 @@
+#ifndef BACKGROUNDJOB_H
+#define BACKGROUNDJOB_H
+
+#include <QObject>
+#include <QThread>
+#include <atomic>
+#include <functional>
+
+// 单个后台任务
+// 工作函数在专用线程上执行，返回的完成函数在所属对象的线程上执行；中途的进度用 post() 投递。
+// 开始新任务、cancel() 或 discard() 后，旧任务尚未执行的投递和完成函数都被丢弃。
+// 同一时刻至多一个任务，start() 会先取消并等待上一个任务。
+class BackgroundJob
+{
+public:
+    using Done = std::function<void()>;
+    using Work = std::function<Done()>;
+
+    explicit BackgroundJob(QObject *owner);
+    ~BackgroundJob();
+
+    void start(Work work);
+    // 设置取消标志并等待线程结束
+    void cancel();
+    // 丢弃当前任务的结果但不等待，线程结束后自行清理；用于模型重置等不能阻塞界面的场合
+    void discard();
+
+    bool isRunning() const { return m_thread != nullptr; }
+    bool isCancelled() const { return m_cancelled.load(std::memory_order_relaxed); }
+    const std::atomic<bool> *cancelFlag() const { return &m_cancelled; }
+
+    // 只在工作线程中调用：任务仍有效时在所属对象的线程上执行 fn
+    void post(Done fn);
+
+    // 每个任务结束后（包括被丢弃的任务）在所属对象的线程上调用，用于接着处理排队的工作
+    void setIdleHandler(Done handler) { m_idle = std::move(handler); }
+
+private:
+    QObject *m_owner;
+    QThread *m_thread = nullptr;
+    std::atomic<bool> m_cancelled{false};
+    quint64 m_generation = 0;       // 只在所属对象的线程上修改
+    quint64 m_jobGeneration = 0;    // 当前任务开始时的 m_generation，任务运行期间不变
+    quint64 m_job = 0;              // 任务序号，区分已被 cancel() 回收的线程
+    Done m_idle;
+};
+
+#endif // BACKGROUNDJOB_H
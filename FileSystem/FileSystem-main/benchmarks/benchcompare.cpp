@@ -0,0 +1,182 @@
+// 基准结果与基线比较
+// 读取 FileSysBench 输出的结果和仓库中的基线，按基线中 tolerances 给出的允许增幅逐项比较，
+// 有一项超出即返回 1。未列在 tolerances 中的项只打印不判断。
+//
+//   FileSysBenchCompare baseline.json result.json             比较
+//   FileSysBenchCompare baseline.json result.json --update    用本次结果更新基线，保留 tolerances
+//
+// 基线中没有记录结果时返回 2，检查不会因为还没有基线而一直通过；--allow-empty-baseline 时只提示并返回 0。
+//
+// 基线格式与 FileSysBench 的输出相同，另加：
+//   "tolerances":   {"load": 0.25, "memory.rss_per_node_bytes": 0.15, ...}  允许的相对增幅
+//   "min_delta_ms": 计时项的绝对容差，增量小于它时不算回归，避免毫秒以下的抖动误报
+// 计时项比较 median_ms，内存项比较 memory 中的同名字段。
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <cstdio>
+
+enum { Passed = 0, Regressed = 1, Failed = 2 };
+
+static bool readJson(const QString &fileName, QJsonObject &out)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        fprintf(stderr, "无法打开 %s\n", qPrintable(fileName));
+        return false;
+    }
+    QJsonParseError error;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
+    if (!doc.isObject()) {
+        fprintf(stderr, "%s 不是有效的 JSON：%s\n", qPrintable(fileName), qPrintable(error.errorString()));
+        return false;
+    }
+    out = doc.object();
+    return true;
+}
+
+// 计时项取各基准的 median_ms，内存项以 "memory." 为前缀
+static QHash<QString, double> metrics(const QJsonObject &result)
+{
+    QHash<QString, double> values;
+    const QJsonArray benchmarks = result["benchmarks"].toArray();
+    for (const QJsonValue &value : benchmarks) {
+        const QJsonObject bench = value.toObject();
+        values.insert(bench["name"].toString(), bench["median_ms"].toDouble());
+    }
+    const QJsonObject memory = result["memory"].toObject();
+    for (auto it = memory.begin(); it != memory.end(); ++it) {
+        values.insert("memory." + it.key(), it.value().toDouble());
+    }
+    return values;
+}
+
+static int update(const QString &baselineFile, const QJsonObject &baseline, QJsonObject result)
+{
+    result["tolerances"] = baseline["tolerances"];
+    result["min_delta_ms"] = baseline["min_delta_ms"];
+    QSaveFile file(baselineFile);
+    if (!file.open(QIODevice::WriteOnly)) {
+        fprintf(stderr, "无法写入 %s\n", qPrintable(baselineFile));
+        return Failed;
+    }
+    file.write(QJsonDocument(result).toJson());
+    if (!file.commit()) {
+        fprintf(stderr, "无法写入 %s\n", qPrintable(baselineFile));
+        return Failed;
+    }
+    printf("已更新基线 %s\n", qPrintable(baselineFile));
+    return Passed;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("FileSysBenchCompare");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("基准结果与基线比较");
+    parser.addHelpOption();
+    parser.addPositionalArgument("baseline", "基线文件");
+    parser.addPositionalArgument("result", "FileSysBench 的输出");
+    QCommandLineOption updateOption("update", "用本次结果更新基线");
+    QCommandLineOption scaleOption("scale", "所有容差乘以该系数，用于噪声较大的机器", "factor", "1");
+    QCommandLineOption allowEmptyOption("allow-empty-baseline", "基线中没有记录结果时视为通过");
+    parser.addOptions({updateOption, scaleOption, allowEmptyOption});
+    parser.process(app);
+
+    const QStringList files = parser.positionalArguments();
+    if (files.size() != 2) {
+        parser.showHelp(Failed);
+    }
+    QJsonObject baseline, result;
+    if (!readJson(files[0], baseline) || !readJson(files[1], result)) return Failed;
+    if (result["schema"].toInt() != 1) {
+        fprintf(stderr, "不支持的结果格式\n");
+        return Failed;
+    }
+    if (parser.isSet(updateOption)) return update(files[0], baseline, result);
+
+    const QJsonArray recorded = baseline["benchmarks"].toArray();
+    if (recorded.isEmpty()) {
+        if (parser.isSet(allowEmptyOption)) {
+            printf("基线中还没有记录结果，跳过比较\n");
+            return Passed;
+        }
+        fprintf(stderr, "基线中还没有记录结果，在参考机器上构建 bench_baseline 目标后提交基线文件\n");
+        return Failed;
+    }
+    // 形状不同时数字没有可比性，直接报错而不是误报回归
+    const QJsonObject baseTree = baseline["tree"].toObject();
+    const QJsonObject resultTree = result["tree"].toObject();
+    for (const char *key : {"depth", "folders", "files", "names", "seed", "nodes"}) {
+        if (baseTree[key] != resultTree[key]) {
+            fprintf(stderr, "结果与基线的树形状不同（%s），请用相同参数运行或更新基线\n", key);
+            return Failed;
+        }
+    }
+    if (baseline["threads"] != result["threads"] || baseline["qt"] != result["qt"]) {
+        printf("注意：线程数或 Qt 版本与基线不同（基线 %d 线程 Qt %s，本次 %d 线程 Qt %s）\n",
+               baseline["threads"].toInt(), qPrintable(baseline["qt"].toString()),
+               result["threads"].toInt(), qPrintable(result["qt"].toString()));
+    }
+
+    const double scale = parser.value(scaleOption).toDouble();
+    if (scale <= 0) {
+        fprintf(stderr, "无效的容差系数\n");
+        return Failed;
+    }
+    const QJsonObject tolerances = baseline["tolerances"].toObject();
+    const double minDelta = baseline["min_delta_ms"].toDouble();
+    const QHash<QString, double> before = metrics(baseline);
+    const QHash<QString, double> after = metrics(result);
+
+    // 按基线中的顺序输出，先计时项后内存项
+    QStringList names;
+    for (const QJsonValue &value : recorded) {
+        names.append(value.toObject()["name"].toString());
+    }
+    const QJsonObject memory = baseline["memory"].toObject();
+    for (auto it = memory.begin(); it != memory.end(); ++it) {
+        names.append("memory." + it.key());
+    }
+
+    int regressions = 0;
+    printf("%-30s %14s %14s %9s %8s  %s\n", "项目", "基线", "本次", "变化", "上限", "结果");
+    for (const QString &name : names) {
+        const double old = before.value(name);
+        if (!after.contains(name)) {
+            // 受检项缺失视为失败，防止基准被删掉后检查悄悄失效
+            printf("%-30s %14.3f %14s %9s %8s  缺少\n", qPrintable(name), old, "-", "-", "-");
+            regressions += tolerances.contains(name);
+            continue;
+        }
+        const double now = after.value(name);
+        const double change = old > 0 ? (now - old) / old : 0.0;
+        QString limit = "-";
+        QString status = "仅记录";
+        if (tolerances.contains(name)) {
+            const double allowed = tolerances[name].toDouble() * scale;
+            const bool timing = !name.startsWith("memory.");
+            const bool regressed = change > allowed && !(timing && now - old < minDelta);
+            limit = QString("+%1%").arg(allowed * 100, 0, 'f', 0);
+            status = regressed ? "回归" : "通过";
+            regressions += regressed;
+        }
+        printf("%-30s %14.3f %14.3f %+8.1f%% %8s  %s\n", qPrintable(name), old, now, change * 100,
+               qPrintable(limit), qPrintable(status));
+    }
+
+    if (regressions > 0) {
+        printf("%d 项超出容差\n", regressions);
+        return Regressed;
+    }
+    printf("全部在容差范围内\n");
+    return Passed;
+}
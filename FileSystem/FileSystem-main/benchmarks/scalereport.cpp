@@ -0,0 +1,577 @@
+// 规模报告
+// 按递增的节点数生成合成树，对每种文件格式和每个后端测量加载、保存耗时、内存和分配次数，输出 Markdown 表格，
+// 用于估算容量，并比较不同版本、不同后端。
+//
+//   FileSysScale --sizes 10k,100k,1M,10M,50M --formats json,json-compact,cbor --output scale.json
+//   FileSysScale --sizes 1M --compare scale-old.json
+//
+// 后端：
+//   engine  只用 TreeEngine，即命令行工具和基准程序的路径；
+//   model   界面程序的路径：文件先读入 TreeEngine 再转换为 QStandardItemModel（与 Widget::showTree 的数据布局相同，
+//           不设图标，也不含界面上各统计表的开销），引擎随即释放；保存时转换回 TreeEngine 再写出。
+// 格式：json 为 filesystem.json 的写法（缩进），json-compact 为紧凑 JSON，cbor 为同一结构的 CBOR 编码；
+// 界面程序只读写 json，其余两种用来评估更换格式的收益。
+//
+// 每个组合在单独的子进程中测量，常驻内存和峰值互不影响：先由一个子进程生成树并写出文件，
+// 再对每个后端各启动一个子进程加载、保存。表中：
+//   堆内存    加载后仍在使用的堆（glibc mallinfo2），不含已释放但未还给系统的部分，最能反映树本身的占用；
+//   常驻内存  加载前后 RSS 之差，含分配器保留的空闲内存；
+//   峰值内存  子进程的最大 RSS，含加载过程中的临时数据；
+//   分配次数  加载和保存期间 malloc/calloc/realloc 的调用次数，只在 glibc 上统计。
+// --output 保存全部原始结果，之后用 --compare 与新结果对照。
+
+#include <QCoreApplication>
+#include <QCborMap>
+#include <QCborValue>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QSaveFile>
+#include <QStandardItemModel>
+#include <QTemporaryDir>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "processmemory.h"
+#include "treeengine.h"
+#include "treegenerator.h"
+
+// 分配计数：在本程序中定义 malloc 等函数，覆盖 glibc 的同名函数（Qt 库中的分配也会经过这里），计数后转交 glibc
+#ifdef __GLIBC__
+static std::atomic<qint64> s_allocations{0};
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+
+void *malloc(size_t size) noexcept
+{
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) noexcept
+{
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size) noexcept
+{
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(pointer, size);
+}
+}
+
+static qint64 allocations() { return s_allocations.load(std::memory_order_relaxed); }
+#else
+static qint64 allocations() { return -1; }
+#endif
+
+// 正在使用的堆（字节），取不到时返回 -1
+static qint64 heapBytes()
+{
+#ifdef __GLIBC__
+#if __GLIBC_PREREQ(2, 33)
+    const struct mallinfo2 info = mallinfo2();
+    return qint64(info.uordblks + info.hblkhd);
+#endif
+#endif
+    return -1;
+}
+
+static QStringList fileFormats() { return {"json", "json-compact", "cbor"}; }
+
+static bool writeTree(const TreeEngine &engine, const QString &format, const QString &fileName)
+{
+    // json 与界面程序的保存完全相同
+    if (format == "json") return engine.save(fileName);
+    const QByteArray bytes = format == "cbor" ? QCborMap::fromJsonObject(engine.toJson()).toCborValue().toCbor()
+                                              : QJsonDocument(engine.toJson()).toJson(QJsonDocument::Compact);
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    file.write(bytes);
+    return file.commit();
+}
+
+static bool readTree(TreeEngine &engine, const QString &format, const QString &fileName)
+{
+    if (format == "json") return engine.load(fileName);
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    const QByteArray bytes = file.readAll();
+    if (format == "cbor") {
+        QCborParserError error;
+        const QCborValue value = QCborValue::fromCbor(bytes, &error);
+        if (error.error != QCborError::NoError || !value.isMap()) return false;
+        return engine.fromJson(value.toMap().toJsonObject());
+    }
+    const QJsonDocument doc = QJsonDocument::fromJson(bytes);
+    return !doc.isNull() && engine.fromJson(doc.object());
+}
+
+// 一种树的存放方式；新的后端实现这个接口并加入 makeBackend 即可出现在报告中
+class Backend
+{
+public:
+    virtual ~Backend() = default;
+    virtual bool load(const QString &format, const QString &fileName) = 0;
+    virtual bool save(const QString &format, const QString &fileName) = 0;
+    virtual qint64 count() const = 0;
+};
+
+class EngineBackend : public Backend
+{
+public:
+    explicit EngineBackend(int threads) : m_engine(threads) {}
+
+    bool load(const QString &format, const QString &fileName) override
+    {
+        return readTree(m_engine, format, fileName);
+    }
+    bool save(const QString &format, const QString &fileName) override
+    {
+        return writeTree(m_engine, format, fileName);
+    }
+    qint64 count() const override { return m_engine.count(); }
+
+private:
+    TreeEngine m_engine;
+};
+
+// 与 Widget::showTree、Widget::saveToJson 相同：引擎负责并行的解析和写出，
+// QStandardItem 只在调用线程上创建和读取
+class ModelBackend : public Backend
+{
+public:
+    explicit ModelBackend(int threads) : m_threads(threads) {}
+
+    bool load(const QString &format, const QString &fileName) override
+    {
+        TreeEngine engine(m_threads);
+        if (!readTree(engine, format, fileName)) return false;
+        m_model = std::make_unique<QStandardItemModel>();
+        m_model->setHorizontalHeaderLabels(QStringList() << "名称" << "类型" << "大小" << "文件数" << "修改时间" << "权限");
+        const TreeNode *root = engine.root();
+        for (int i = 0; i < root->childCount(); ++i) {
+            m_model->appendRow(row(root->child(i)));
+        }
+        return true;
+    }
+
+    bool save(const QString &format, const QString &fileName) override
+    {
+        TreeEngine engine(m_threads);
+        for (int i = 0; i < m_model->rowCount(); ++i) {
+            engine.root()->append(nodeFromItem(m_model->item(i, 0)));
+        }
+        return writeTree(engine, format, fileName);
+    }
+
+    qint64 count() const override
+    {
+        qint64 total = 0;
+        auto children = [](QStandardItem *item, std::vector<QStandardItem*> &out) {
+            for (int i = 0; i < item->rowCount(); ++i) {
+                out.push_back(item->child(i, 0));
+            }
+        };
+        TreeWalker(1).walk(m_model->invisibleRootItem(), children, [&total](QStandardItem *item, int) {
+            ++total;
+            return item->hasChildren();
+        });
+        return total;
+    }
+
+private:
+    // 第0列是名称，带类型、真实路径和存储编号；第1列是类型
+    static QList<QStandardItem*> row(const TreeNode *node)
+    {
+        QStandardItem *typeItem = new QStandardItem(node->type);
+        typeItem->setData(node->type, Qt::UserRole + 1);
+        return {itemFromNode(node), typeItem};
+    }
+
+    static QStandardItem *itemFromNode(const TreeNode *node)
+    {
+        QStandardItem *item = new QStandardItem(node->name);
+        item->setData(node->type, Qt::UserRole + 1);
+        if (!node->blob.isEmpty()) {
+            item->setData(node->blob, Qt::UserRole + 3);
+        } else if (!node->path.isEmpty()) {
+            item->setData(node->path, Qt::UserRole + 2);
+        }
+        for (int i = 0; i < node->childCount(); ++i) {
+            item->appendRow(row(node->child(i)));
+        }
+        return item;
+    }
+
+    static std::unique_ptr<TreeNode> nodeFromItem(QStandardItem *item)
+    {
+        auto node = std::make_unique<TreeNode>();
+        node->name = item->text();
+        node->type = item->data(Qt::UserRole + 1).toString();
+        node->blob = item->data(Qt::UserRole + 3).toString();
+        if (node->blob.isEmpty()) {
+            node->path = item->data(Qt::UserRole + 2).toString();
+        }
+        for (int i = 0; i < item->rowCount(); ++i) {
+            node->append(nodeFromItem(item->child(i, 0)));
+        }
+        return node;
+    }
+
+    int m_threads;
+    std::unique_ptr<QStandardItemModel> m_model;
+};
+
+static QStringList backendNames() { return {"engine", "model"}; }
+
+static std::unique_ptr<Backend> makeBackend(const QString &name, int threads)
+{
+    if (name == "engine") return std::make_unique<EngineBackend>(threads);
+    if (name == "model") return std::make_unique<ModelBackend>(threads);
+    return nullptr;
+}
+
+// 子进程：生成树并按格式写出
+static QJsonObject prepare(const TreeShape &shape, const QString &format, const QString &fileName, int threads)
+{
+    QJsonObject result;
+    TreeEngine engine(threads);
+    QElapsedTimer timer;
+    timer.start();
+    TreeGenerator(shape).generate(engine);
+    result["generate_ms"] = timer.nsecsElapsed() / 1e6;
+    result["nodes"] = engine.count();
+    result["ok"] = writeTree(engine, format, fileName);
+    result["file_bytes"] = QFileInfo(fileName).size();
+    return result;
+}
+
+// 子进程：用一个后端加载、保存，测量各阶段
+static QJsonObject measure(const QString &backendName, const QString &format, const QString &fileName, int threads)
+{
+    QJsonObject result;
+    std::unique_ptr<Backend> backend = makeBackend(backendName, threads);
+    if (!backend) {
+        result["ok"] = false;
+        result["error"] = "未知后端 " + backendName;
+        return result;
+    }
+    const qint64 residentBefore = ProcessMemory::residentBytes();
+    const qint64 heapBefore = heapBytes();
+    qint64 allocationsBefore = allocations();
+    QElapsedTimer timer;
+    timer.start();
+    if (!backend->load(format, fileName)) {
+        result["ok"] = false;
+        result["error"] = "加载失败";
+        return result;
+    }
+    result["load_ms"] = timer.nsecsElapsed() / 1e6;
+    result["load_allocations"] = allocations() < 0 ? -1 : allocations() - allocationsBefore;
+    result["resident_bytes"] = ProcessMemory::residentBytes() - residentBefore;
+    result["heap_bytes"] = heapBefore < 0 ? -1 : heapBytes() - heapBefore;
+    const qint64 nodes = backend->count();
+    result["nodes"] = nodes;
+
+    // 写到另一个文件，保存结果的大小可与输入文件核对
+    const QString saved = fileName + ".saved";
+    allocationsBefore = allocations();
+    timer.restart();
+    const bool ok = backend->save(format, saved);
+    result["save_ms"] = timer.nsecsElapsed() / 1e6;
+    result["save_allocations"] = allocations() < 0 ? -1 : allocations() - allocationsBefore;
+    result["saved_bytes"] = QFileInfo(saved).size();
+    QFile::remove(saved);
+    result["peak_resident_bytes"] = ProcessMemory::peakResidentBytes();
+    result["ok"] = ok;
+    if (!ok) result["error"] = "保存失败";
+    return result;
+}
+
+// 以子进程运行本程序，返回其输出的 JSON 对象
+static QJsonObject runChild(const QStringList &arguments)
+{
+    QProcess process;
+    process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    process.start(QCoreApplication::applicationFilePath(), arguments);
+    if (!process.waitForStarted() || !process.waitForFinished(-1)) {
+        return QJsonObject{{"ok", false}, {"error", "无法运行子进程"}};
+    }
+    const QJsonDocument doc = QJsonDocument::fromJson(process.readAllStandardOutput());
+    if (process.exitStatus() != QProcess::NormalExit || !doc.isObject()) {
+        // 多半是内存不足被系统终止
+        return QJsonObject{{"ok", false}, {"error", QString("子进程异常退出（%1）").arg(process.exitCode())}};
+    }
+    return doc.object();
+}
+
+// "10k"、"1M"、"50M" → 节点数
+static qint64 parseSize(QString text)
+{
+    qint64 scale = 1;
+    if (text.endsWith('k', Qt::CaseInsensitive)) scale = 1000;
+    if (text.endsWith('M')) scale = 1000 * 1000;
+    if (scale > 1) text.chop(1);
+    bool ok = false;
+    const double value = text.toDouble(&ok);
+    return ok && value > 0 ? qint64(value * scale) : 0;
+}
+
+static QString formatSize(qint64 nodes)
+{
+    if (nodes >= 1000 * 1000 && nodes % (1000 * 1000) == 0) return QString("%1M").arg(nodes / (1000 * 1000));
+    if (nodes >= 1000 && nodes % 1000 == 0) return QString("%1k").arg(nodes / 1000);
+    return QString::number(nodes);
+}
+
+static QString formatBytes(double bytes)
+{
+    if (bytes < 0) return "-";
+    if (bytes >= 1024.0 * 1024 * 1024) return QString::number(bytes / (1024.0 * 1024 * 1024), 'f', 2) + " GB";
+    if (bytes >= 1024.0 * 1024) return QString::number(bytes / (1024.0 * 1024), 'f', 1) + " MB";
+    if (bytes >= 1024.0) return QString::number(bytes / 1024.0, 'f', 1) + " KB";
+    return QString::number(bytes, 'f', 0) + " B";
+}
+
+static QString formatCount(qint64 count)
+{
+    return count < 0 ? "-" : QString::number(count);
+}
+
+static QString key(const QJsonObject &row)
+{
+    return row["target"].toString() + '/' + row["backend"].toString() + '/' + row["format"].toString();
+}
+
+static void printTable(const QJsonArray &rows)
+{
+    printf("| 节点数 | 后端 | 格式 | 文件大小 | 加载 ms | 保存 ms | 堆内存 | 每节点 | 常驻内存 | 峰值内存 | 加载分配 | 保存分配 |\n");
+    printf("|---:|---|---|---:|---:|---:|---:|---:|---:|---:|---:|---:|\n");
+    for (const QJsonValue &value : rows) {
+        const QJsonObject row = value.toObject();
+        const QString head = QString("| %1 | %2 | %3 |").arg(row["target"].toString(), row["backend"].toString(),
+                                                                row["format"].toString());
+        if (!row["ok"].toBool()) {
+            printf("%s %s | | | | | | | | |\n", qPrintable(head), qPrintable(row["error"].toString()));
+            continue;
+        }
+        const qint64 nodes = row["nodes"].toVariant().toLongLong();
+        const double heap = row["heap_bytes"].toDouble();
+        printf("%s %s | %.1f | %.1f | %s | %s | %s | %s | %s | %s |\n", qPrintable(head),
+               qPrintable(formatBytes(row["file_bytes"].toDouble())), row["load_ms"].toDouble(), row["save_ms"].toDouble(),
+               qPrintable(formatBytes(heap)), qPrintable(heap < 0 || nodes == 0 ? "-" : QString::number(heap / nodes, 'f', 0) + " B"),
+               qPrintable(formatBytes(row["resident_bytes"].toDouble())),
+               qPrintable(formatBytes(row["peak_resident_bytes"].toDouble())),
+               qPrintable(formatCount(row["load_allocations"].toVariant().toLongLong())),
+               qPrintable(formatCount(row["save_allocations"].toVariant().toLongLong())));
+    }
+}
+
+// 与之前保存的结果逐行对照，给出相对变化
+static void printComparison(const QJsonArray &rows, const QJsonObject &previous, const QString &name)
+{
+    QHash<QString, QJsonObject> old;
+    for (const QJsonValue &value : previous["rows"].toArray()) {
+        old.insert(key(value.toObject()), value.toObject());
+    }
+    auto change = [](const QJsonObject &now, const QJsonObject &before, const char *field) -> QString {
+        const double a = before[field].toDouble();
+        const double b = now[field].toDouble();
+        if (a <= 0 || b < 0) return "-";
+        return QString::asprintf("%+.1f%%", (b - a) * 100.0 / a);
+    };
+
+    printf("\n与 %s（%s）相比：\n\n", qPrintable(name), qPrintable(previous["version"].toString()));
+    printf("| 节点数 | 后端 | 格式 | 文件大小 | 加载 | 保存 | 堆内存 | 峰值内存 | 加载分配 |\n");
+    printf("|---:|---|---|---:|---:|---:|---:|---:|---:|\n");
+    for (const QJsonValue &value : rows) {
+        const QJsonObject row = value.toObject();
+        const QJsonObject before = old.value(key(row));
+        if (before.isEmpty() || !row["ok"].toBool() || !before["ok"].toBool()) continue;
+        printf("| %s | %s | %s | %s | %s | %s | %s | %s | %s |\n", qPrintable(row["target"].toString()),
+               qPrintable(row["backend"].toString()), qPrintable(row["format"].toString()),
+               qPrintable(change(row, before, "file_bytes")), qPrintable(change(row, before, "load_ms")),
+               qPrintable(change(row, before, "save_ms")), qPrintable(change(row, before, "heap_bytes")),
+               qPrintable(change(row, before, "peak_resident_bytes")),
+               qPrintable(change(row, before, "load_allocations")));
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("FileSysScale");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("按树的规模测量各格式、各后端的加载、保存耗时和内存");
+    parser.addHelpOption();
+    QCommandLineOption sizesOption("sizes", "节点数，逗号分隔，可用 k、M 后缀", "list", "10k,100k,1M");
+    QCommandLineOption formatsOption("formats", "文件格式：" + fileFormats().join("、"), "list", fileFormats().join(','));
+    QCommandLineOption backendsOption("backends", "后端：" + backendNames().join("、"), "list", backendNames().join(','));
+    QCommandLineOption foldersOption("folders", "每个文件夹的子文件夹数", "n", "10");
+    QCommandLineOption filesOption("files", "每个文件夹的文件数", "n", "10");
+    QCommandLineOption namesOption("names", "名称分布：unique、words 或 zipf", "kind", "unique");
+    QCommandLineOption seedOption("seed", "随机种子", "n", "1");
+    QCommandLineOption threadsOption("threads", "并行线程数，0 为硬件线程数", "n", "0");
+    QCommandLineOption directoryOption("directory", "存放生成文件的目录，默认为临时目录；大规模时需要足够的磁盘空间", "dir");
+    QCommandLineOption outputOption("output", "全部结果写入 JSON 文件", "file");
+    QCommandLineOption compareOption("compare", "与之前 --output 保存的结果对照", "file");
+    // 以下由本程序启动子进程时使用
+    QCommandLineOption prepareOption("prepare", "生成树并写出到文件", "file");
+    QCommandLineOption measureOption("measure", "加载、保存文件并测量", "file");
+    QCommandLineOption nodesOption("nodes", "节点数", "n");
+    QCommandLineOption formatOption("format", "文件格式", "name");
+    QCommandLineOption backendOption("backend", "后端", "name");
+    for (QCommandLineOption *option : {&prepareOption, &measureOption, &nodesOption, &formatOption, &backendOption}) {
+        option->setFlags(QCommandLineOption::HiddenFromHelp);
+    }
+    parser.addOptions({sizesOption, formatsOption, backendsOption, foldersOption, filesOption, namesOption, seedOption,
+                       threadsOption, directoryOption, outputOption, compareOption,
+                       prepareOption, measureOption, nodesOption, formatOption, backendOption});
+    parser.process(app);
+
+    const int threads = parser.value(threadsOption).toInt();
+    TreeShape shape;
+    shape.folders = parser.value(foldersOption).toInt();
+    shape.files = parser.value(filesOption).toInt();
+    shape.names = parser.value(namesOption);
+    shape.seed = parser.value(seedOption).toULongLong();
+    if (!TreeGenerator::nameDistributions().contains(shape.names) || shape.folders < 1 || shape.files < 0) {
+        fprintf(stderr, "无效的树形状参数\n");
+        return 2;
+    }
+
+    if (parser.isSet(prepareOption) || parser.isSet(measureOption)) {
+        QJsonObject result;
+        if (parser.isSet(prepareOption)) {
+            shape.limit = parser.value(nodesOption).toLongLong();
+            shape.depth = shape.depthFor(shape.limit);
+            result = prepare(shape, parser.value(formatOption), parser.value(prepareOption), threads);
+        } else {
+            result = measure(parser.value(backendOption), parser.value(formatOption), parser.value(measureOption), threads);
+        }
+        const QByteArray json = QJsonDocument(result).toJson(QJsonDocument::Compact);
+        fwrite(json.constData(), 1, size_t(json.size()), stdout);
+        return 0;
+    }
+
+    QVector<qint64> sizes;
+    for (const QString &text : parser.value(sizesOption).split(',', Qt::SkipEmptyParts)) {
+        const qint64 nodes = parseSize(text.trimmed());
+        if (nodes < 3) {
+            fprintf(stderr, "无效的节点数 %s\n", qPrintable(text));
+            return 2;
+        }
+        sizes.append(nodes);
+    }
+    const QStringList formats = parser.value(formatsOption).split(',', Qt::SkipEmptyParts);
+    const QStringList backends = parser.value(backendsOption).split(',', Qt::SkipEmptyParts);
+    for (const QString &format : formats) {
+        if (!fileFormats().contains(format)) {
+            fprintf(stderr, "未知格式 %s\n", qPrintable(format));
+            return 2;
+        }
+    }
+    for (const QString &backend : backends) {
+        if (!backendNames().contains(backend)) {
+            fprintf(stderr, "未知后端 %s\n", qPrintable(backend));
+            return 2;
+        }
+    }
+    QJsonObject previous;
+    if (parser.isSet(compareOption)) {
+        QFile file(parser.value(compareOption));
+        const QJsonDocument doc = file.open(QIODevice::ReadOnly) ? QJsonDocument::fromJson(file.readAll()) : QJsonDocument();
+        if (!doc.isObject()) {
+            fprintf(stderr, "无法读取 %s\n", qPrintable(parser.value(compareOption)));
+            return 2;
+        }
+        previous = doc.object();
+    }
+
+    QTemporaryDir temporary;
+    const QString directory = parser.isSet(directoryOption) ? parser.value(directoryOption) : temporary.path();
+    if (directory.isEmpty() || !QDir().mkpath(directory)) {
+        fprintf(stderr, "无法创建目录 %s\n", qPrintable(directory));
+        return 2;
+    }
+
+    const QStringList common = {"--folders", QString::number(shape.folders), "--files", QString::number(shape.files),
+                                "--names", shape.names, "--seed", QString::number(shape.seed),
+                                "--threads", QString::number(threads)};
+    QJsonArray rows;
+    for (qint64 size : sizes) {
+        for (const QString &format : formats) {
+            const QString fileName = QDir(directory).filePath(QString("tree-%1.%2").arg(formatSize(size), format));
+            fprintf(stderr, "生成 %s 个节点（%s）…\n", qPrintable(formatSize(size)), qPrintable(format));
+            const QJsonObject prepared = runChild(QStringList{"--prepare", fileName, "--nodes", QString::number(size),
+                                                              "--format", format} + common);
+            for (const QString &backend : backends) {
+                QJsonObject row = prepared["ok"].toBool()
+                        ? runChild(QStringList{"--measure", fileName, "--backend", backend, "--format", format} + common)
+                        : QJsonObject{{"ok", false}, {"error", prepared.value("error").toString("生成或写出失败")}};
+                row["target"] = formatSize(size);
+                row["backend"] = backend;
+                row["format"] = format;
+                row["file_bytes"] = prepared["file_bytes"];
+                row["generate_ms"] = prepared["generate_ms"];
+                fprintf(stderr, "  %-6s %s\n", qPrintable(backend),
+                        row["ok"].toBool() ? qPrintable(QString("加载 %1 ms，保存 %2 ms")
+                                                        .arg(row["load_ms"].toDouble(), 0, 'f', 1)
+                                                        .arg(row["save_ms"].toDouble(), 0, 'f', 1))
+                                           : qPrintable(row["error"].toString()));
+                rows.append(row);
+            }
+            // 大规模的文件可能有数 GB，测完即删
+            QFile::remove(fileName);
+        }
+    }
+
+    QJsonObject report;
+    report["schema"] = 1;
+    report["version"] = QString(FILESYS_VERSION);
+    report["qt"] = QString::fromLatin1(qVersion());
+    report["threads"] = TreeWalker(threads).threadCount();
+    report["shape"] = QJsonObject{{"folders", shape.folders}, {"files", shape.files}, {"names", shape.names},
+                                  {"seed", QString::number(shape.seed)}};
+    report["rows"] = rows;
+
+    printf("FileSys %s，Qt %s，%d 线程，每个文件夹 %d 个子文件夹、%d 个文件，名称 %s\n\n", FILESYS_VERSION, qVersion(),
+           report["threads"].toInt(), shape.folders, shape.files, qPrintable(shape.names));
+    printTable(rows);
+    if (!previous.isEmpty()) printComparison(rows, previous, parser.value(compareOption));
+    fflush(stdout);
+
+    if (parser.isSet(outputOption)) {
+        QSaveFile out(parser.value(outputOption));
+        if (!out.open(QIODevice::WriteOnly)) {
+            fprintf(stderr, "无法写入 %s\n", qPrintable(parser.value(outputOption)));
+            return 1;
+        }
+        out.write(QJsonDocument(report).toJson());
+        if (!out.commit()) {
+            fprintf(stderr, "无法写入 %s\n", qPrintable(parser.value(outputOption)));
+            return 1;
+        }
+    }
+    for (const QJsonValue &row : rows) {
+        if (!row.toObject()["ok"].toBool()) return 1;
+    }
+    return 0;
+}
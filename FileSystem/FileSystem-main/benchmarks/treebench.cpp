@@ -0,0 +1,324 @@
+// 树引擎基准测试
+// 按给定形状生成确定性的合成树，对加载、保存、搜索、复制、移动、重名检查和路径拼接分别计时，
+// 结果以 JSON 输出（标准输出或 --output 指定的文件），便于逐版本比较。
+//
+//   FileSysBench --depth 4 --folders 8 --files 16 --names zipf --iterations 5 --output result.json
+//   FileSysBench --calibrate      测量顺序与并行遍历的交叉点，作为 TreeWalker 顺序遍历上限的依据
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <random>
+
+#include "processmemory.h"
+#include "trace.h"
+#include "treeengine.h"
+#include "treegenerator.h"
+
+class Bench
+{
+public:
+    explicit Bench(int iterations) : m_iterations(iterations) {}
+
+    // setup 不计时，在每次计时前执行；ops 为一次执行的操作数，用于换算单次操作耗时
+    void run(const QString &name, const std::function<void()> &body, qint64 ops = 1,
+             const std::function<void()> &setup = {})
+    {
+        std::vector<double> samples;
+        for (int i = 0; i < m_iterations; ++i) {
+            if (setup) setup();
+            QElapsedTimer timer;
+            timer.start();
+            body();
+            samples.push_back(timer.nsecsElapsed() / 1e6);
+        }
+        std::sort(samples.begin(), samples.end());
+        double sum = 0;
+        for (double s : samples) {
+            sum += s;
+        }
+
+        QJsonObject result;
+        result["name"] = name;
+        result["iterations"] = m_iterations;
+        result["ops"] = ops;
+        result["min_ms"] = samples.front();
+        result["median_ms"] = samples[samples.size() / 2];
+        result["mean_ms"] = sum / samples.size();
+        result["max_ms"] = samples.back();
+        result["ns_per_op"] = samples[samples.size() / 2] * 1e6 / std::max<qint64>(ops, 1);
+        m_results.append(result);
+        fprintf(stderr, "%-16s median %10.3f ms  (%lld ops)\n", qPrintable(name), samples[samples.size() / 2],
+                static_cast<long long>(ops));
+    }
+
+    QJsonArray results() const { return m_results; }
+
+private:
+    int m_iterations;
+    QJsonArray m_results;
+};
+
+// 先序收集 root 下的全部节点
+static void collect(TreeNode *node, std::vector<TreeNode*> &out, bool foldersOnly)
+{
+    for (int i = 0; i < node->childCount(); ++i) {
+        TreeNode *child = node->child(i);
+        if (!foldersOnly || child->type == "文件夹") out.push_back(child);
+        collect(child, out, foldersOnly);
+    }
+}
+
+static double medianMs(int iterations, const std::function<void()> &body)
+{
+    std::vector<double> samples;
+    for (int i = 0; i < iterations; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        body();
+        samples.push_back(timer.nsecsElapsed() / 1e6);
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+// 在一组节点数上分别以纯顺序和不做顺序前缀的并行方式执行搜索、计数和序列化。
+// 建议的顺序遍历上限是从该规模起并行总是更快的最小节点数；所测范围内并行都不更快时为 -1。
+static QJsonObject calibrate(const TreeShape &base, int threads, int iterations)
+{
+    static const qint64 sizes[] = {1000, 2000, 4000, 8000, 16000, 32000, 64000, 128000, 256000, 512000};
+    QJsonArray rows;
+    std::vector<std::pair<qint64, bool>> faster;
+    TreeEngine serial(1);
+    TreeEngine parallel(threads, 0);
+    for (qint64 size : sizes) {
+        TreeShape shape = base;
+        shape.limit = size;
+        shape.depth = shape.depthFor(size);
+        TreeGenerator(shape).generate(serial);
+        TreeGenerator generator(shape);
+        generator.generate(parallel);
+        const QString keyword = generator.sampleKeyword();
+        qint64 sink = 0;
+        auto workload = [&](const TreeEngine &engine) {
+            return [&] {
+                sink += qint64(engine.find(keyword).size());
+                sink += engine.count();
+                sink += engine.toJson().size();
+            };
+        };
+        const double serialMs = medianMs(iterations, workload(serial));
+        const double parallelMs = medianMs(iterations, workload(parallel));
+
+        QJsonObject row;
+        row["nodes"] = serial.count();
+        row["serial_ms"] = serialMs;
+        row["parallel_ms"] = parallelMs;
+        row["checksum"] = sink;
+        rows.append(row);
+        faster.emplace_back(serial.count(), parallelMs < serialMs);
+        fprintf(stderr, "%8lld 节点  顺序 %9.3f ms  并行 %9.3f ms\n", static_cast<long long>(serial.count()),
+                serialMs, parallelMs);
+    }
+
+    qint64 recommended = -1;
+    for (auto it = faster.rbegin(); it != faster.rend() && it->second; ++it) {
+        recommended = it->first;
+    }
+    QJsonObject result;
+    result["schema"] = 1;
+    result["qt"] = QString::fromLatin1(qVersion());
+    result["threads"] = parallel.walker().threadCount();
+    result["calibration"] = rows;
+    result["recommended_serial_limit"] = recommended;
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("FileSysBench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("树引擎基准测试");
+    parser.addHelpOption();
+    QCommandLineOption depthOption("depth", "文件夹层数", "n", "4");
+    QCommandLineOption foldersOption("folders", "每个文件夹的子文件夹数", "n", "8");
+    QCommandLineOption filesOption("files", "每个文件夹的文件数", "n", "16");
+    QCommandLineOption namesOption("names", "名称分布：unique、words 或 zipf", "kind", "unique");
+    QCommandLineOption seedOption("seed", "随机种子", "n", "1");
+    QCommandLineOption iterationsOption("iterations", "每项重复次数，取中位数", "n", "5");
+    QCommandLineOption threadsOption("threads", "并行线程数，0 为硬件线程数", "n", "0");
+    QCommandLineOption serialLimitOption("serial-limit", "节点数在此以内的遍历不启用多线程，负数为默认值", "n", "-1");
+    QCommandLineOption calibrateOption("calibrate", "测量顺序与并行遍历的交叉点，输出建议的 --serial-limit");
+    QCommandLineOption outputOption("output", "结果写入文件而不是标准输出", "file");
+    QCommandLineOption traceOption("trace", "记录跟踪并写出为 Chrome trace-event JSON", "file");
+    parser.addOptions({depthOption, foldersOption, filesOption, namesOption, seedOption,
+                       iterationsOption, threadsOption, serialLimitOption, calibrateOption, outputOption, traceOption});
+    parser.process(app);
+
+    TreeShape shape;
+    shape.depth = parser.value(depthOption).toInt();
+    shape.folders = parser.value(foldersOption).toInt();
+    shape.files = parser.value(filesOption).toInt();
+    shape.names = parser.value(namesOption);
+    shape.seed = parser.value(seedOption).toULongLong();
+    const int iterations = std::max(1, parser.value(iterationsOption).toInt());
+    if (!TreeGenerator::nameDistributions().contains(shape.names) || shape.depth < 0 || shape.folders < 1
+        || shape.files < 0) {
+        fprintf(stderr, "无效的树形状参数\n");
+        return 2;
+    }
+
+    Trace::setEnabled(parser.isSet(traceOption));
+
+    auto writeResult = [&parser, &outputOption](const QJsonObject &root) {
+        const QByteArray json = QJsonDocument(root).toJson();
+        if (parser.isSet(outputOption)) {
+            QFile out(parser.value(outputOption));
+            if (!out.open(QIODevice::WriteOnly) || out.write(json) != json.size()) {
+                fprintf(stderr, "无法写入 %s\n", qPrintable(parser.value(outputOption)));
+                return false;
+            }
+        } else {
+            fwrite(json.constData(), 1, size_t(json.size()), stdout);
+        }
+        return true;
+    };
+
+    if (parser.isSet(calibrateOption)) {
+        return writeResult(calibrate(shape, parser.value(threadsOption).toInt(), iterations)) ? 0 : 1;
+    }
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        fprintf(stderr, "无法创建临时目录\n");
+        return 1;
+    }
+    const QString jsonFile = dir.filePath("filesystem.json");
+
+    TreeEngine engine(parser.value(threadsOption).toInt(), parser.value(serialLimitOption).toInt());
+    Bench bench(iterations);
+
+    // 生成：同时测量每个节点的常驻内存
+    const qint64 rssBefore = ProcessMemory::residentBytes();
+    TreeGenerator generator(shape);
+    TreeNode *disk = generator.generate(engine);
+    const qint64 rssAfter = ProcessMemory::residentBytes();
+    const qint64 nodes = engine.count();
+    bench.run("generate", [&] { TreeGenerator(shape).generate(engine); }, nodes);
+    disk = engine.root()->child(0)->child(0);
+
+    // 加载与保存
+    bench.run("save", [&] { engine.save(jsonFile); }, nodes);
+    const qint64 jsonBytes = QFileInfo(jsonFile).size();
+    bench.run("load", [&] { engine.load(jsonFile); }, nodes);
+    disk = engine.root()->child(0)->child(0);
+
+    // 搜索
+    const QString keyword = generator.sampleKeyword();
+    qint64 matches = 0;
+    bench.run("search", [&] { matches = qint64(engine.find(keyword).size()); }, nodes);
+    bench.run("search_path", [&] { engine.findPath("C盘/**/*.txt"); }, nodes);
+    bench.run("count", [&] { engine.count(); }, nodes);
+
+    // 深度复制整个盘符
+    std::unique_ptr<TreeNode> copy;
+    bench.run("copy", [&] { copy = engine.copy(disk); }, nodes, [&] { copy.reset(); });
+    copy.reset();
+
+    // 拼接全部节点的显示路径，缓冲区复用
+    std::vector<TreeNode*> all;
+    collect(disk, all, false);
+    QString buffer;
+    qint64 pathChars = 0;
+    bench.run("path_build", [&] {
+        for (TreeNode *node : all) {
+            TreeEngine::buildPath(node, buffer);
+            pathChars += buffer.size();
+        }
+    }, qint64(all.size()));
+
+    // 重名检查：随机文件夹中一半查已有名称、一半查不存在的名称
+    std::vector<TreeNode*> folders;
+    folders.push_back(disk);
+    collect(disk, folders, true);
+    std::mt19937_64 random(shape.seed);
+    const int lookups = 100000;
+    std::vector<std::pair<TreeNode*, QString>> queries;
+    queries.reserve(lookups);
+    for (int i = 0; i < lookups; ++i) {
+        TreeNode *folder = folders[random() % folders.size()];
+        if ((i & 1) && folder->hasChildren()) {
+            queries.emplace_back(folder, folder->child(int(random() % folder->childCount()))->name);
+        } else {
+            queries.emplace_back(folder, QString("不存在的名称%1").arg(i));
+        }
+    }
+    qint64 duplicates = 0;
+    bench.run("duplicate_check", [&] {
+        for (const auto &query : queries) {
+            duplicates += TreeEngine::hasDuplicateName(query.first, query.second);
+        }
+    }, lookups);
+
+    // 移动：随机选文件移到另一个文件夹再移回，每次移动都包含循环检查和重名检查
+    const int moves = std::min<int>(10000, int(all.size()));
+    std::vector<std::pair<TreeNode*, TreeNode*>> plan;
+    for (int i = 0; i < moves; ++i) {
+        TreeNode *node = all[random() % all.size()];
+        TreeNode *target = folders[random() % folders.size()];
+        plan.emplace_back(node, target);
+    }
+    bench.run("move", [&] {
+        for (const auto &step : plan) {
+            TreeNode *from = step.first->parent();
+            if (engine.move(step.first, step.second)) {
+                engine.move(step.first, from);
+            }
+        }
+    }, moves * 2);
+
+    QJsonObject tree;
+    tree["depth"] = shape.depth;
+    tree["folders"] = shape.folders;
+    tree["files"] = shape.files;
+    tree["names"] = shape.names;
+    tree["seed"] = QString::number(shape.seed);
+    tree["nodes"] = nodes;
+    tree["search_matches"] = matches;
+
+    QJsonObject memory;
+    memory["rss_per_node_bytes"] = nodes > 0 ? double(rssAfter - rssBefore) / nodes : 0.0;
+    memory["peak_rss_bytes"] = ProcessMemory::peakResidentBytes();
+    memory["json_bytes"] = jsonBytes;
+    memory["json_bytes_per_node"] = nodes > 0 ? double(jsonBytes) / nodes : 0.0;
+    // 按数据结构推算的树本身的占用，与 RSS 之差是分配器和 Qt 的额外开销
+    const MemoryUsage usage = engine.memoryUsage();
+    memory["estimated_bytes_per_node"] = usage.nodes > 0 ? double(usage.total()) / usage.nodes : 0.0;
+
+    QJsonObject root;
+    root["schema"] = 1;
+    root["qt"] = QString::fromLatin1(qVersion());
+    root["threads"] = engine.walker().threadCount();
+    root["serial_limit"] = engine.walker().serialLimit();
+    root["tree"] = tree;
+    root["memory"] = memory;
+    root["benchmarks"] = bench.results();
+    if (!writeResult(root)) return 1;
+    if (parser.isSet(traceOption) && !Trace::writeChromeJson(parser.value(traceOption))) {
+        fprintf(stderr, "无法写入 %s\n", qPrintable(parser.value(traceOption)));
+        return 1;
+    }
+    // 防止编译器把只为计时而执行的结果优化掉
+    return (duplicates < 0 || pathChars < 0) ? 1 : 0;
+}
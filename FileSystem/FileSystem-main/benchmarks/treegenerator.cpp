@@ -0,0 +1,125 @@
+#include "treegenerator.h"
+
+#include <algorithm>
+
+static const char *const Syllables[] = {
+    "an", "bo", "chi", "de", "fa", "gu", "hai", "jin", "ka", "lu", "mei", "nan",
+    "ou", "pi", "qing", "ru", "shan", "tu", "wen", "xi", "yu", "zhe", "报告", "数据",
+    "项目", "照片", "备份", "文档", "草稿", "版本"};
+static const char *const Suffixes[] = {"txt", "pdf", "png", "doc", "gif", "ppt", "xls", "zip", "tar.gz"};
+static const int VocabularySize = 512;
+
+qint64 TreeShape::nodeCount() const
+{
+    // 第 level 层有 folders^level 个文件夹（level 从 0 开始，第 0 层是盘符）
+    qint64 total = 2;
+    qint64 layer = 1;
+    for (int level = 0; level <= depth; ++level) {
+        total += layer * files;
+        if (level == depth) break;
+        layer *= folders;
+        total += layer;
+    }
+    return limit > 0 ? std::min(total, limit) : total;
+}
+
+int TreeShape::depthFor(qint64 nodes) const
+{
+    TreeShape shape = *this;
+    shape.limit = 0;
+    shape.depth = 0;
+    while (shape.nodeCount() < nodes && shape.depth < 32) {
+        ++shape.depth;
+    }
+    return shape.depth;
+}
+
+TreeGenerator::TreeGenerator(const TreeShape &shape)
+    : m_shape(shape), m_random(shape.seed)
+{
+    if (m_shape.names == "zipf") {
+        // 不用 std::discrete_distribution：各标准库的实现不同，生成的树会随编译器变化
+        double sum = 0;
+        for (int i = 0; i < VocabularySize; ++i) {
+            sum += 1.0 / (i + 1);
+            m_zipf.push_back(sum);
+        }
+        for (int i = 0; i < VocabularySize; ++i) {
+            m_vocabulary.append(word());
+        }
+    }
+}
+
+TreeNode *TreeGenerator::generate(TreeEngine &engine)
+{
+    engine.clear();
+    auto computer = std::make_unique<TreeNode>();
+    computer->name = "我的电脑";
+    computer->type = "system";
+    computer->icon = "treeItem_Computer";
+    auto disk = std::make_unique<TreeNode>();
+    disk->name = "C盘";
+    disk->type = "驱动器";
+    disk->icon = "treeItem_Disk";
+    TreeNode *myDisk = engine.root()->append(std::move(computer))->append(std::move(disk));
+    m_generated = 2;
+    fill(engine, myDisk, 0);
+    return myDisk;
+}
+
+void TreeGenerator::fill(TreeEngine &engine, TreeNode *folder, int level)
+{
+    for (int i = 0; i < m_shape.files && !full(); ++i) {
+        QString name = makeName(i, false);
+        // 随机名称可能在同一文件夹内重复，追加序号后重试
+        for (int attempt = 1; !engine.addFile(folder, name); ++attempt) {
+            name = makeName(i, false) + QString::number(attempt);
+        }
+        ++m_generated;
+    }
+    if (level == m_shape.depth) return;
+    for (int i = 0; i < m_shape.folders && !full(); ++i) {
+        QString name = makeName(i, true);
+        TreeNode *child = nullptr;
+        for (int attempt = 1; !(child = engine.addFolder(folder, name)); ++attempt) {
+            name = makeName(i, true) + QString::number(attempt);
+        }
+        ++m_generated;
+        fill(engine, child, level + 1);
+    }
+}
+
+QString TreeGenerator::word()
+{
+    const int count = 1 + int(m_random() % 3);
+    QString w;
+    for (int i = 0; i < count; ++i) {
+        w += QString::fromUtf8(Syllables[m_random() % (sizeof(Syllables) / sizeof(Syllables[0]))]);
+    }
+    return w;
+}
+
+QString TreeGenerator::makeName(int index, bool folder)
+{
+    QString base;
+    if (m_shape.names == "words") {
+        base = word();
+    } else if (m_shape.names == "zipf") {
+        const double u = double(m_random() >> 11) / double(quint64(1) << 53) * m_zipf.back();
+        const int i = int(std::upper_bound(m_zipf.begin(), m_zipf.end(), u) - m_zipf.begin());
+        base = m_vocabulary[std::min(i, VocabularySize - 1)];
+    } else {
+        base = (folder ? "文件夹" : "文件") + QString::number(index + 1);
+    }
+    if (folder) return base;
+    // 后缀固定按序号轮换，名称分布不影响类型分布
+    const int suffixCount = sizeof(Suffixes) / sizeof(Suffixes[0]);
+    return base + "." + QString::fromLatin1(Suffixes[index % suffixCount]);
+}
+
+QString TreeGenerator::sampleKeyword()
+{
+    if (m_shape.names == "zipf") return m_vocabulary.first();
+    if (m_shape.names == "words") return QString::fromUtf8(Syllables[0]);
+    return "文件1";
+}
@@ -0,0 +1,61 @@
+#ifndef TREEGENERATOR_H
+#define TREEGENERATOR_H
+
+#include <QString>
+#include <QStringList>
+#include <random>
+#include <vector>
+
+#include "treeengine.h"
+
+// 合成树的形状
+// 我的电脑 → C盘 → depth 层文件夹，每个文件夹下 folders 个子文件夹和 files 个文件（最底层只有文件）。
+// names 决定名称分布：
+//   "unique"  各层按序号命名（文件夹3、文件17.txt），与程序新建的名称相似；
+//   "words"   由音节随机拼成的名称，长度不一；
+//   "zipf"    从固定词表按 Zipf 分布抽取，大量重名分布在不同文件夹中（同一文件夹内追加序号去重），
+//             模拟搜索关键字命中很多节点的情况。
+struct TreeShape
+{
+    int depth = 4;
+    int folders = 8;
+    int files = 16;
+    QString names = "unique";
+    quint64 seed = 1;
+    qint64 limit = 0;   // 节点数上限（含“我的电脑”和盘符），0 为不限；达到后停止生成，靠后的文件夹不满
+
+    // 按形状计算的节点数（含“我的电脑”和盘符）
+    qint64 nodeCount() const;
+    // 节点数不少于 nodes 时所需的最小层数
+    int depthFor(qint64 nodes) const;
+};
+
+// 确定性的合成树生成器：相同的形状和种子总是生成相同的树
+class TreeGenerator
+{
+public:
+    explicit TreeGenerator(const TreeShape &shape);
+
+    // 清空 engine 并生成整棵树，返回盘符节点
+    TreeNode *generate(TreeEngine &engine);
+
+    // 生成树中出现过的一个名称片段，用作搜索关键字
+    QString sampleKeyword();
+
+    static QStringList nameDistributions() { return {"unique", "words", "zipf"}; }
+
+private:
+    void fill(TreeEngine &engine, TreeNode *folder, int level);
+    QString makeName(int index, bool folder);
+    QString word();
+
+    bool full() const { return m_shape.limit > 0 && m_generated >= m_shape.limit; }
+
+    TreeShape m_shape;
+    qint64 m_generated = 0;
+    std::mt19937_64 m_random;
+    QStringList m_vocabulary;
+    std::vector<double> m_zipf;     // Zipf 分布的累计权重
+};
+
+#endif // TREEGENERATOR_H
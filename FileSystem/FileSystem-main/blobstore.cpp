@@ -0,0 +1,89 @@
+#include "blobstore.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QUuid>
+
+static const QString ObjectsDir = QStringLiteral("objects");
+static const QString WorkDir = QStringLiteral("work");
+
+BlobStore::BlobStore(const QString &root)
+{
+    setRoot(root);
+}
+
+void BlobStore::setRoot(const QString &root)
+{
+    m_root = root.isEmpty() ? QString() : QDir::cleanPath(QDir(root).absolutePath());
+}
+
+QString BlobStore::emptyId()
+{
+    static const QString id = QString::fromLatin1(QCryptographicHash::hash(QByteArray(), QCryptographicHash::Sha256).toHex());
+    return id;
+}
+
+bool BlobStore::isWorking(const QString &id)
+{
+    return id.startsWith(WorkDir + '/');
+}
+
+QString BlobStore::newWorkingId()
+{
+    return WorkDir + '/' + QUuid::createUuid().toString(QUuid::WithoutBraces);
+}
+
+QString BlobStore::pathFor(const QString &id) const
+{
+    if (isWorking(id)) {
+        return m_root + '/' + id;
+    }
+    // 按前两位分目录，避免单个目录下文件过多
+    return m_root + '/' + ObjectsDir + '/' + id.left(2) + '/' + id.mid(2);
+}
+
+QString BlobStore::idForPath(const QString &path) const
+{
+    const QString prefix = m_root + '/';
+    if (!path.startsWith(prefix)) return QString();
+
+    const QStringList parts = path.mid(prefix.size()).split('/');
+    if (parts.size() == 2 && parts[0] == WorkDir) {
+        return path.mid(prefix.size());
+    }
+    if (parts.size() == 3 && parts[0] == ObjectsDir) {
+        return parts[1] + parts[2];
+    }
+    return QString();
+}
+
+QString BlobStore::store(const QString &root, const QString &path, QString *error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = file.errorString();
+        return QString();
+    }
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    if (!hash.addData(&file)) {
+        *error = file.errorString();
+        return QString();
+    }
+    file.close();
+
+    const QString id = QString::fromLatin1(hash.result().toHex());
+    const QString target = BlobStore(root).pathFor(id);
+    if (QFile::exists(target)) {
+        // 内容已存在，直接丢弃副本
+        file.remove();
+        return id;
+    }
+    QDir().mkpath(QFileInfo(target).path());
+    if (!file.rename(target)) {
+        *error = file.errorString();
+        return QString();
+    }
+    return id;
+}
@@ -0,0 +1,35 @@
+#ifndef BLOBSTORE_H
+#define BLOBSTORE_H
+
+#include <QString>
+
+// 内容寻址的后备存储
+// 新建文件的内容按 SHA-256 存放在 root/objects/xx/yyyy...，相同内容只存一份，节点只记录内容编号，
+// 因此复制粘贴只复制编号，不产生文件，也不会因为同名而互相覆盖。
+// 存储中的内容不可修改：打开编辑前先检出为 root/work/ 下的独立副本，副本在下次启动时重新计算哈希存回。
+class BlobStore
+{
+public:
+    explicit BlobStore(const QString &root = QString());
+
+    void setRoot(const QString &root);
+    QString root() const { return m_root; }
+
+    // 空内容的编号，新建文件都引用它
+    static QString emptyId();
+    // 检出的工作副本编号形如 work/<uuid>
+    static bool isWorking(const QString &id);
+    static QString newWorkingId();
+
+    QString pathFor(const QString &id) const;
+    // pathFor 的逆运算，路径不在存储中时返回空字符串
+    QString idForPath(const QString &path) const;
+
+    // 计算 path 的内容编号并移入 root 下的存储，同内容已存在时删除 path；可在后台线程调用
+    static QString store(const QString &root, const QString &path, QString *error);
+
+private:
+    QString m_root;
+};
+
+#endif // BLOBSTORE_H
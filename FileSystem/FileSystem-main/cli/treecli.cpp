@@ -0,0 +1,338 @@
+// 树的命令行工具
+// 在一次 加载 → 修改 → 保存 中批量执行脚本里的命令，不启动界面，与 FileSys 读写同一个 filesystem.json。
+//
+//   FileSysCli [--file filesystem.json] [--keep-going] [--dry-run] [-c 命令]... [脚本文件|-]...
+//   FileSysCli --server 服务名 [--keep-going] [-c 命令]... [脚本文件|-]...
+//
+// 每行一条命令，# 开头为注释，含空格的名称加引号。路径以 / 分隔，可省略顶层的“我的电脑”：
+//   mkdir [-p] 路径          新建文件夹，-p 同时创建缺少的上级
+//   touch 路径 [真实路径]    新建文件，类型按后缀判断，可绑定真实文件；已存在时不做任何事
+//   mv 源 目标               目标是已有文件夹时移入其中，否则移到目标的上级并改名为目标的最后一级
+//   cp 源 目标               同 mv，复制整棵子树
+//   rm [-r] 路径             删除，非空文件夹需要 -r
+//   rename 路径 新名称       在原文件夹中改名
+//   find 关键字|路径模式     名称包含关键字的节点；含 / 时按路径模式匹配，如 "C盘/**/*.txt"
+//   ls 路径                  子项名称，文件夹以 / 结尾
+//   count [路径]             后代节点数
+//   stat 路径                类型、绑定路径、子项数和子树的节点数、内存占用
+// 任一命令失败时默认不保存并返回 1；--keep-going 时跳过失败的命令，其余照常执行并保存。
+// 给出 --server 时不读写文件，命令经本地服务交给正在运行的 FileSys 执行（见 TreeService），界面中立即可见。
+// 执行统计（各阶段耗时、每秒命令数）输出到标准错误。
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QLocalSocket>
+#include <QMap>
+#include <QProcess>
+#include <QTextStream>
+#include <cstdio>
+
+#include "treeengine.h"
+#include "treecommands.h"
+#include "treeprotocol.h"
+#include "pathpattern.h"
+
+struct Command
+{
+    QString source;     // 脚本名，-c 给出的命令为 "-c"
+    int line = 0;
+    QStringList args;
+};
+
+static bool isFolderType(const QString &type)
+{
+    return type == "文件夹" || type == "驱动器" || type == "system";
+}
+
+// 本地执行和通过服务执行的结果以同样的格式输出
+static void printResult(QTextStream &out, quint8 code, const TreeProtocol::Result &result)
+{
+    switch (code) {
+    case TreeProtocol::Find:
+        for (const TreeProtocol::Record &record : result.records) {
+            out << record.path << '\n';
+        }
+        break;
+    case TreeProtocol::List:
+        for (const TreeProtocol::Record &record : result.records) {
+            out << record.path.section('/', -1) << (isFolderType(record.type) ? "/" : "") << '\n';
+        }
+        break;
+    case TreeProtocol::Count:
+        out << result.value << '\n';
+        break;
+    case TreeProtocol::Stat:
+        for (const TreeProtocol::Record &record : result.records) {
+            out << "路径：" << record.path << '\n'
+                << "类型：" << record.type << '\n';
+            if (!record.realPath.isEmpty()) out << "绑定：" << record.realPath << '\n';
+            if (!record.blob.isEmpty()) out << "存储：" << record.blob << '\n';
+            out << "子项：" << record.children << '\n'
+                << "节点：" << result.value << '\n';
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+class Runner
+{
+public:
+    Runner(TreeEngine &engine, QTextStream &out) : m_engine(engine), m_commands(engine), m_out(out) {}
+
+    bool run(const QStringList &args, QString *error)
+    {
+        TreeProtocol::Operation op;
+        if (!TreeProtocol::parseCommand(args, &op, error)) return false;
+        const TreeProtocol::Result result = TreeProtocol::isReadOnly(op.code) ? TreeProtocol::read(m_engine, op)
+                                                                              : TreeProtocol::write(m_commands, op);
+        if (result.status != TreeProtocol::Ok) {
+            *error = result.message;
+            return false;
+        }
+        printResult(m_out, op.code, result);
+        // 本地执行时另外给出子树的内存占用
+        if (op.code == TreeProtocol::Stat) {
+            m_out << "内存：" << m_engine.memoryUsage(m_engine.nodeAt(PathPattern::splitPath(op.args[0]))).total() << " 字节\n";
+        }
+        return true;
+    }
+
+private:
+    TreeEngine &m_engine;
+    TreeCommands m_commands;
+    QTextStream &m_out;
+};
+
+static bool readScript(const QString &source, QVector<Command> &commands)
+{
+    QFile file;
+    if (source == "-") {
+        if (!file.open(stdin, QIODevice::ReadOnly | QIODevice::Text)) return false;
+    } else {
+        file.setFileName(source);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return false;
+    }
+    QTextStream in(&file);
+    for (int line = 1; !in.atEnd(); ++line) {
+        const QString text = in.readLine().trimmed();
+        if (text.isEmpty() || text.startsWith('#')) continue;
+        commands.append({source, line, QProcess::splitCommand(text)});
+    }
+    return true;
+}
+
+static void reportFailure(const Command &command, const QString &error)
+{
+    fprintf(stderr, "%s:%d: %s\n", qPrintable(command.source), command.line,
+            qPrintable(error.isEmpty() ? "操作失败：" + command.args.join(' ') : error));
+}
+
+// 通过本地服务执行，每 BatchSize 条命令一个请求。--keep-going 时全部请求连续发出不等回复，
+// 否则上一个请求全部成功后才发下一个，服务端在请求内遇到失败即停止
+static int runRemote(const QString &serverName, const QVector<Command> &commands, bool keepGoing)
+{
+    const int BatchSize = 1024;
+    QVector<TreeProtocol::Operation> ops;
+    QVector<const Command*> sources;    // 与 ops 同序
+    int failures = 0;
+    for (const Command &command : commands) {
+        if (command.args.isEmpty()) continue;
+        TreeProtocol::Operation op;
+        QString error;
+        if (!TreeProtocol::parseCommand(command.args, &op, &error)) {
+            ++failures;
+            reportFailure(command, error);
+            if (!keepGoing) return 1;
+            continue;
+        }
+        ops.append(op);
+        sources.append(&command);
+    }
+
+    QLocalSocket socket;
+    socket.connectToServer(serverName);
+    if (!socket.waitForConnected(3000)) {
+        fprintf(stderr, "无法连接服务 %s：%s\n", qPrintable(serverName), qPrintable(socket.errorString()));
+        return 2;
+    }
+
+    QTextStream out(stdout);
+    QElapsedTimer timer;
+    timer.start();
+    const int batches = (int(ops.size()) + BatchSize - 1) / BatchSize;
+    int sent = 0;
+    auto send = [&]() {
+        TreeProtocol::Request request;
+        request.id = quint32(sent);
+        request.flags = keepGoing ? quint8(TreeProtocol::ContinueOnError) : quint8(0);
+        request.ops = ops.mid(sent * BatchSize, BatchSize);
+        socket.write(TreeProtocol::encode(request));
+        ++sent;
+    };
+    if (batches > 0) send();
+    while (keepGoing && sent < batches) {
+        send();
+    }
+
+    // 只读请求的回复可能提前到达，按编号暂存，按命令顺序输出
+    QMap<quint32, TreeProtocol::Reply> replies;
+    QByteArray buffer;
+    int printed = 0;
+    int skipped = 0;
+    while (printed < sent) {
+        QByteArray frame;
+        bool tooLarge = false;
+        while (!TreeProtocol::takeFrame(buffer, &frame, &tooLarge)) {
+            if (tooLarge || !socket.waitForReadyRead(30000)) {
+                fprintf(stderr, "服务连接中断：%s\n", qPrintable(tooLarge ? "回复过大" : socket.errorString()));
+                return 2;
+            }
+            buffer += socket.readAll();
+        }
+        TreeProtocol::Reply reply;
+        if (!TreeProtocol::decode(frame, &reply)) {
+            fprintf(stderr, "无法解析服务的回复\n");
+            return 2;
+        }
+        replies.insert(reply.id, reply);
+
+        for (auto it = replies.find(quint32(printed)); it != replies.end(); it = replies.find(quint32(printed))) {
+            const int first = printed * BatchSize;
+            for (int i = 0; i < it->results.size(); ++i) {
+                const TreeProtocol::Result &result = it->results[i];
+                if (result.status == TreeProtocol::Ok) {
+                    printResult(out, ops[first + i].code, result);
+                } else if (result.status == TreeProtocol::Skipped) {
+                    ++skipped;
+                } else {
+                    ++failures;
+                    out.flush();
+                    reportFailure(*sources[first + i], result.message);
+                }
+            }
+            replies.erase(it);
+            ++printed;
+            if (!keepGoing && failures == 0 && sent < batches) send();
+        }
+    }
+    out.flush();
+
+    const double applyMs = timer.nsecsElapsed() / 1e6;
+    const qint64 executed = qMin(qint64(sent) * BatchSize, qint64(ops.size())) - skipped;
+    fprintf(stderr, "经服务 %s 执行 %lld 条命令 %.1f ms，%.0f 条/秒，失败 %d 条\n", qPrintable(serverName),
+            static_cast<long long>(executed), applyMs, applyMs > 0 ? executed * 1000.0 / applyMs : 0.0, failures);
+    return failures > 0 ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("FileSysCli");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("在一次加载、修改、保存中批量执行树操作");
+    parser.addHelpOption();
+    parser.addPositionalArgument("scripts", "命令脚本，- 为标准输入；未给出脚本和 -c 时读标准输入", "[脚本...]");
+    QCommandLineOption fileOption("file", "树文件", "file", "filesystem.json");
+    QCommandLineOption commandOption("c", "执行一条命令，可重复", "command");
+    QCommandLineOption keepGoingOption("keep-going", "跳过失败的命令，其余照常执行并保存");
+    QCommandLineOption dryRunOption("dry-run", "只执行不保存");
+    QCommandLineOption threadsOption("threads", "并行线程数，0 为硬件线程数", "n", "0");
+    QCommandLineOption serverOption("server", "经正在运行的 FileSys 的本地服务执行，不读写文件", "name");
+    parser.addOptions({fileOption, commandOption, keepGoingOption, dryRunOption, threadsOption, serverOption});
+    parser.process(app);
+
+    QVector<Command> commands;
+    int inlineCount = 0;
+    for (const QString &text : parser.values(commandOption)) {
+        commands.append({"-c", ++inlineCount, QProcess::splitCommand(text)});
+    }
+    QStringList scripts = parser.positionalArguments();
+    if (scripts.isEmpty() && commands.isEmpty()) scripts.append("-");
+    for (const QString &script : scripts) {
+        if (!readScript(script, commands)) {
+            fprintf(stderr, "无法读取脚本 %s\n", qPrintable(script));
+            return 2;
+        }
+    }
+
+    if (parser.isSet(serverOption)) {
+        if (parser.isSet(dryRunOption)) {
+            fprintf(stderr, "--dry-run 不能与 --server 同时使用\n");
+            return 2;
+        }
+        return runRemote(parser.value(serverOption), commands, parser.isSet(keepGoingOption));
+    }
+
+    // 与界面程序一致：文件不存在时从示例结构开始
+    const QString fileName = parser.value(fileOption);
+    TreeEngine engine(parser.value(threadsOption).toInt());
+    QElapsedTimer timer;
+    timer.start();
+    if (!QFile::exists(fileName)) {
+        fprintf(stderr, "%s 不存在，从示例结构开始\n", qPrintable(fileName));
+        engine.createSample();
+    } else if (!engine.load(fileName)) {
+        fprintf(stderr, "无法加载 %s\n", qPrintable(fileName));
+        return 2;
+    }
+    const double loadMs = timer.nsecsElapsed() / 1e6;
+    const qint64 loadedNodes = engine.count();
+
+    QTextStream out(stdout);
+    Runner runner(engine, out);
+    QMap<QString, QPair<qint64, qint64>> perCommand;    // 命令 → (次数, 纳秒)
+    int failures = 0;
+    timer.restart();
+    for (const Command &command : commands) {
+        if (command.args.isEmpty()) continue;
+        QElapsedTimer commandTimer;
+        commandTimer.start();
+        QString error;
+        const bool ok = runner.run(command.args, &error);
+        QPair<qint64, qint64> &stats = perCommand[command.args.first()];
+        ++stats.first;
+        stats.second += commandTimer.nsecsElapsed();
+        if (ok) continue;
+
+        ++failures;
+        out.flush();
+        reportFailure(command, error);
+        if (!parser.isSet(keepGoingOption)) break;
+    }
+    out.flush();
+    const double applyMs = timer.nsecsElapsed() / 1e6;
+
+    const bool save = !parser.isSet(dryRunOption) && (failures == 0 || parser.isSet(keepGoingOption));
+    double saveMs = 0;
+    if (save) {
+        timer.restart();
+        if (!engine.save(fileName)) {
+            fprintf(stderr, "无法保存 %s\n", qPrintable(fileName));
+            return 2;
+        }
+        saveMs = timer.nsecsElapsed() / 1e6;
+    }
+
+    qint64 executed = 0;
+    for (const auto &stats : perCommand) {
+        executed += stats.first;
+    }
+    fprintf(stderr, "加载 %.1f ms（%lld 个节点）\n", loadMs, static_cast<long long>(loadedNodes));
+    fprintf(stderr, "执行 %lld 条命令 %.1f ms，%.0f 条/秒，失败 %d 条\n", static_cast<long long>(executed), applyMs,
+            applyMs > 0 ? executed * 1000.0 / applyMs : 0.0, failures);
+    for (auto it = perCommand.cbegin(); it != perCommand.cend(); ++it) {
+        fprintf(stderr, "  %-6s %8lld 次 %10.1f ms\n", qPrintable(it.key()), static_cast<long long>(it.value().first),
+                it.value().second / 1e6);
+    }
+    if (save) {
+        fprintf(stderr, "保存 %.1f ms（%lld 个节点）\n", saveMs, static_cast<long long>(engine.count()));
+    } else {
+        fprintf(stderr, failures > 0 && !parser.isSet(dryRunOption) ? "有命令失败，未保存\n" : "未保存（--dry-run）\n");
+    }
+    return failures > 0 ? 1 : 0;
+}
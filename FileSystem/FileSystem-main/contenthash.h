@@ -0,0 +1,135 @@
+#ifndef CONTENTHASH_H
+#define CONTENTHASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// 流式 64 位内容散列（XXH64 算法），用于快速比较文件内容，不用于安全校验
+// 每次 update 处理任意长度的数据，不足 32 字节的尾部暂存到下次；digest 不改变内部状态。
+class ContentHash
+{
+public:
+    explicit ContentHash(uint64_t seed = 0)
+    {
+        m_acc[0] = seed + P1 + P2;
+        m_acc[1] = seed + P2;
+        m_acc[2] = seed;
+        m_acc[3] = seed - P1;
+        m_seed = seed;
+    }
+
+    void update(const void *data, size_t size)
+    {
+        const unsigned char *p = static_cast<const unsigned char*>(data);
+        const unsigned char *end = p + size;
+        m_total += size;
+
+        if (m_buffered + size < 32) {
+            std::memcpy(m_buffer + m_buffered, p, size);
+            m_buffered += size;
+            return;
+        }
+        if (m_buffered) {
+            const size_t fill = 32 - m_buffered;
+            std::memcpy(m_buffer + m_buffered, p, fill);
+            consume(m_buffer);
+            p += fill;
+            m_buffered = 0;
+        }
+        for (; p + 32 <= end; p += 32) {
+            consume(p);
+        }
+        m_buffered = static_cast<size_t>(end - p);
+        std::memcpy(m_buffer, p, m_buffered);
+    }
+
+    uint64_t digest() const
+    {
+        uint64_t h;
+        if (m_total >= 32) {
+            h = rotl(m_acc[0], 1) + rotl(m_acc[1], 7) + rotl(m_acc[2], 12) + rotl(m_acc[3], 18);
+            for (uint64_t acc : m_acc) {
+                h ^= round(0, acc);
+                h = h * P1 + P4;
+            }
+        } else {
+            h = m_seed + P5;
+        }
+        h += m_total;
+
+        const unsigned char *p = m_buffer;
+        const unsigned char *end = m_buffer + m_buffered;
+        for (; p + 8 <= end; p += 8) {
+            h ^= round(0, read64(p));
+            h = rotl(h, 27) * P1 + P4;
+        }
+        if (p + 4 <= end) {
+            h ^= uint64_t(read32(p)) * P1;
+            h = rotl(h, 23) * P2 + P3;
+            p += 4;
+        }
+        for (; p < end; ++p) {
+            h ^= *p * P5;
+            h = rotl(h, 11) * P1;
+        }
+
+        h ^= h >> 33;
+        h *= P2;
+        h ^= h >> 29;
+        h *= P3;
+        h ^= h >> 32;
+        return h;
+    }
+
+    static uint64_t hash(const void *data, size_t size, uint64_t seed = 0)
+    {
+        ContentHash h(seed);
+        h.update(data, size);
+        return h.digest();
+    }
+
+private:
+    static constexpr uint64_t P1 = 0x9E3779B185EBCA87ULL;
+    static constexpr uint64_t P2 = 0xC2B2AE3D27D4EB4FULL;
+    static constexpr uint64_t P3 = 0x165667B19E3779F9ULL;
+    static constexpr uint64_t P4 = 0x85EBCA77C2B2AE63ULL;
+    static constexpr uint64_t P5 = 0x27D4EB2F165667C5ULL;
+
+    static uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+    static uint64_t round(uint64_t acc, uint64_t input)
+    {
+        acc += input * P2;
+        return rotl(acc, 31) * P1;
+    }
+    // 按小端读取，与其他实现的结果一致
+    static uint64_t read64(const unsigned char *p)
+    {
+        uint64_t v;
+        std::memcpy(&v, p, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        v = __builtin_bswap64(v);
+#endif
+        return v;
+    }
+    static uint32_t read32(const unsigned char *p)
+    {
+        return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+    }
+
+    void consume(const unsigned char *p)
+    {
+        m_acc[0] = round(m_acc[0], read64(p));
+        m_acc[1] = round(m_acc[1], read64(p + 8));
+        m_acc[2] = round(m_acc[2], read64(p + 16));
+        m_acc[3] = round(m_acc[3], read64(p + 24));
+    }
+
+    uint64_t m_acc[4];
+    uint64_t m_seed = 0;
+    uint64_t m_total = 0;
+    unsigned char m_buffer[32];
+    size_t m_buffered = 0;
+};
+
+#endif // CONTENTHASH_H
@@ -0,0 +1,380 @@
+#include "contentindex.h"
+#include "contentsearch.h"
+#include "treewalker.h"
+
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QSet>
+#include <algorithm>
+#include <iterator>
+
+static const quint32 IndexMagic = 0x46534349;   // "FSCI"
+static const quint32 IndexVersion = 2;
+static const quint32 LogMagic = 0x4653434C;     // "FSCL"
+static const quint32 LogVersion = 1;
+static const qint64 MinLogSize = 8 << 20;       // 日志小于此大小时不因体积重写快照
+
+enum RecordKind : quint8 { AddRecord = 1, RemoveRecord = 2 };
+
+void ContentIndex::setFileName(const QString &fileName)
+{
+    m_fileName = fileName;
+    m_loaded = false;
+    m_log.close();
+}
+
+void ContentIndex::clear()
+{
+    m_files.clear();
+    m_byPath.clear();
+    m_postings.clear();
+    m_dead = 0;
+}
+
+void ContentIndex::trigrams(const char *data, qint64 size, std::vector<quint32> &out)
+{
+    // 用 2^24 位的位图去重，只清理用过的位，避免每个文件都排序或清空整张位图
+    thread_local std::vector<quint64> seen(size_t(1) << 18, 0);
+    const unsigned char *bytes = reinterpret_cast<const unsigned char*>(data);
+    for (qint64 i = 0; i + 2 < size; ++i) {
+        quint32 key = (quint32(bytes[i]) << 16) | (quint32(bytes[i + 1]) << 8) | bytes[i + 2];
+        quint64 bit = quint64(1) << (key & 63);
+        if (!(seen[key >> 6] & bit)) {
+            seen[key >> 6] |= bit;
+            out.push_back(key);
+        }
+    }
+    for (quint32 key : out) {
+        seen[key >> 6] = 0;
+    }
+    std::sort(out.begin(), out.end());
+}
+
+void ContentIndex::update(const QStringList &files, const TreeWalker &walker, const std::atomic<bool> *cancelled)
+{
+    if (!m_loaded) {
+        if (!load()) {
+            // 没有可用的索引，从空快照和空日志开始
+            clear();
+            save();
+        }
+        m_loaded = true;
+    }
+
+    // 找出新增或修改时间、大小变化的文件
+    QSet<QString> present;
+    std::vector<int> stale;
+    for (int i = 0; i < files.size(); ++i) {
+        const QString &path = files[i];
+        present.insert(path);
+        QFileInfo info(path);
+        if (!info.isFile()) continue;
+        auto it = m_byPath.constFind(path);
+        if (it != m_byPath.constEnd()) {
+            const FileEntry &entry = m_files[it.value()];
+            if (entry.modified == info.lastModified().toMSecsSinceEpoch() && entry.size == info.size()) continue;
+        }
+        stale.push_back(i);
+    }
+
+    // 已不在树中的文件直接作废
+    QStringList removed;
+    for (auto it = m_byPath.constBegin(); it != m_byPath.constEnd(); ++it) {
+        if (!present.contains(it.key())) removed.append(it.key());
+    }
+    for (const QString &path : removed) {
+        removeEntry(path);
+        QByteArray record;
+        QDataStream(&record, QIODevice::WriteOnly) << quint8(RemoveRecord) << path;
+        appendRecord(record);
+    }
+
+    // 并行切分变化的文件，每个文件切分完立即并入索引并写入日志，不在内存中攒下所有文件的三元组；
+    // 编号在锁内按写入顺序分配，倒排表仍保持升序，重放日志得到同样的编号
+    walker.map(stale, [&](int file) {
+        if (cancelled && cancelled->load(std::memory_order_relaxed)) return 0;
+        QFileInfo info(files[file]);
+        MappedFile mapped(files[file]);
+        if (!mapped.isOpen()) return 0;
+        FileEntry entry;
+        entry.path = files[file];
+        entry.modified = info.lastModified().toMSecsSinceEpoch();
+        entry.size = mapped.size();
+        entry.binary = mapped.size() > 0 && ContentSearch::looksBinary(mapped.data(), mapped.size());
+        thread_local std::vector<quint32> keys;
+        keys.clear();
+        if (!entry.binary) {
+            trigrams(mapped.data(), mapped.size(), keys);
+        }
+
+        QByteArray record;
+        QDataStream out(&record, QIODevice::WriteOnly);
+        out << quint8(AddRecord) << entry.path << entry.modified << entry.size << entry.binary << quint32(keys.size());
+        for (quint32 key : keys) {
+            out << key;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        addEntry(entry, keys.data(), keys.size());
+        appendRecord(record);
+        return 1;
+    });
+    m_log.flush();
+
+    // 日志超过快照大小时并入快照，作废编号过多时顺带压缩
+    if ((m_dead > 1024 && m_dead > m_byPath.size()) || m_log.size() > std::max(m_snapshotSize, MinLogSize)) {
+        compact();
+        save();
+    }
+}
+
+void ContentIndex::addEntry(const FileEntry &entry, const quint32 *keys, size_t count)
+{
+    removeEntry(entry.path);
+    const int id = m_files.size();
+    m_files.append(entry);
+    m_byPath.insert(entry.path, id);
+    for (size_t i = 0; i < count; ++i) {
+        m_postings[keys[i]].append(id);
+    }
+}
+
+void ContentIndex::removeEntry(const QString &path)
+{
+    auto it = m_byPath.find(path);
+    if (it == m_byPath.end()) return;
+    m_files[it.value()].alive = false;
+    ++m_dead;
+    m_byPath.erase(it);
+}
+
+void ContentIndex::appendRecord(const QByteArray &record)
+{
+    if (!m_log.isOpen()) return;
+    QDataStream out(&m_log);
+    out << quint32(record.size());
+    m_log.write(record);
+}
+
+std::vector<int> ContentIndex::candidates(const QByteArray &needle, const QStringList &files) const
+{
+    std::vector<quint32> keys;
+    trigrams(needle.constData(), needle.size(), keys);
+
+    // 从最短的倒排表开始求交集
+    QVector<int> ids;
+    bool filtered = !keys.empty();
+    if (filtered) {
+        std::vector<const QVector<int>*> lists;
+        for (quint32 key : keys) {
+            auto it = m_postings.constFind(key);
+            if (it == m_postings.constEnd()) {
+                lists.clear();
+                break;
+            }
+            lists.push_back(&it.value());
+        }
+        std::sort(lists.begin(), lists.end(), [](const QVector<int> *a, const QVector<int> *b) {
+            return a->size() < b->size();
+        });
+        if (!lists.empty()) {
+            ids = *lists.front();
+            for (size_t i = 1; i < lists.size() && !ids.isEmpty(); ++i) {
+                QVector<int> next;
+                std::set_intersection(ids.constBegin(), ids.constEnd(),
+                                      lists[i]->constBegin(), lists[i]->constEnd(), std::back_inserter(next));
+                ids.swap(next);
+            }
+        }
+    }
+
+    std::vector<int> result;
+    for (int i = 0; i < files.size(); ++i) {
+        auto it = m_byPath.constFind(files[i]);
+        if (it == m_byPath.constEnd()) {
+            // 未能建立索引的文件（如读取失败）照常核实
+            result.push_back(i);
+            continue;
+        }
+        const FileEntry &entry = m_files[it.value()];
+        if (entry.binary) continue;
+        if (!filtered || std::binary_search(ids.constBegin(), ids.constEnd(), it.value())) {
+            result.push_back(i);
+        }
+    }
+    return result;
+}
+
+void ContentIndex::compact()
+{
+    // 去掉作废编号，按原顺序重新编号，倒排表仍保持升序
+    QVector<int> remap(m_files.size(), -1);
+    QVector<FileEntry> files;
+    for (int i = 0; i < m_files.size(); ++i) {
+        if (!m_files[i].alive) continue;
+        remap[i] = files.size();
+        files.append(m_files[i]);
+    }
+
+    for (auto it = m_postings.begin(); it != m_postings.end();) {
+        QVector<int> &ids = it.value();
+        int kept = 0;
+        for (int id : ids) {
+            if (remap[id] >= 0) ids[kept++] = remap[id];
+        }
+        ids.resize(kept);
+        if (ids.isEmpty()) {
+            it = m_postings.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (auto it = m_byPath.begin(); it != m_byPath.end(); ++it) {
+        it.value() = remap[it.value()];
+    }
+    m_files = files;
+    m_dead = 0;
+}
+
+bool ContentIndex::load()
+{
+    if (m_fileName.isEmpty()) return false;
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint64 logId = 0;
+    in >> magic >> version >> logId;
+    if (magic != IndexMagic || version != IndexVersion) return false;
+
+    qint32 fileCount = 0;
+    in >> fileCount;
+    m_files.clear();
+    m_byPath.clear();
+    m_dead = 0;
+    for (qint32 i = 0; i < fileCount && in.status() == QDataStream::Ok; ++i) {
+        FileEntry entry;
+        in >> entry.path >> entry.modified >> entry.size >> entry.alive >> entry.binary;
+        if (entry.alive) {
+            m_byPath.insert(entry.path, m_files.size());
+        } else {
+            ++m_dead;
+        }
+        m_files.append(entry);
+    }
+
+    qint32 postingCount = 0;
+    in >> postingCount;
+    m_postings.clear();
+    m_postings.reserve(postingCount);
+    for (qint32 i = 0; i < postingCount && in.status() == QDataStream::Ok; ++i) {
+        quint32 key = 0;
+        QVector<int> ids;
+        in >> key >> ids;
+        m_postings.insert(key, ids);
+    }
+    if (in.status() != QDataStream::Ok) return false;
+    m_logId = logId;
+    m_snapshotSize = file.size();
+    return replayLog();
+}
+
+bool ContentIndex::replayLog()
+{
+    m_log.close();
+    m_log.setFileName(m_fileName + ".log");
+    if (!m_log.open(QIODevice::ReadWrite)) return false;
+
+    QDataStream in(&m_log);
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint64 logId = 0;
+    in >> magic >> version >> logId;
+    if (in.status() != QDataStream::Ok || magic != LogMagic || version != LogVersion || logId != m_logId) {
+        // 快照重写后日志未及清空时，其中的记录都已在快照里
+        m_log.resize(0);
+        QDataStream out(&m_log);
+        out << LogMagic << LogVersion << m_logId;
+        return out.status() == QDataStream::Ok;
+    }
+
+    qint64 good = m_log.pos();
+    for (;;) {
+        quint32 size = 0;
+        in >> size;
+        if (in.status() != QDataStream::Ok) break;
+        const QByteArray record = m_log.read(size);
+        if (record.size() != qsizetype(size) || !applyRecord(record)) break;
+        good = m_log.pos();
+    }
+    // 写入中断留下的不完整记录截掉，之后从这里追加
+    if (m_log.size() != good) m_log.resize(good);
+    return m_log.seek(good);
+}
+
+bool ContentIndex::applyRecord(const QByteArray &record)
+{
+    QDataStream in(record);
+    quint8 kind = 0;
+    QString path;
+    in >> kind >> path;
+    if (in.status() != QDataStream::Ok) return false;
+    if (kind == RemoveRecord) {
+        removeEntry(path);
+        return true;
+    }
+    if (kind != AddRecord) return false;
+
+    FileEntry entry;
+    entry.path = path;
+    quint32 count = 0;
+    in >> entry.modified >> entry.size >> entry.binary >> count;
+    if (in.status() != QDataStream::Ok || count > quint32(record.size() / 4)) return false;
+    std::vector<quint32> keys(count);
+    for (quint32 &key : keys) {
+        in >> key;
+    }
+    if (in.status() != QDataStream::Ok) return false;
+    addEntry(entry, keys.data(), keys.size());
+    return true;
+}
+
+bool ContentIndex::save()
+{
+    if (m_fileName.isEmpty()) return false;
+    QSaveFile file(m_fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning("Couldn't open content index file.");
+        return false;
+    }
+
+    // 新快照换用新编号，旧日志即使来不及清空也会在加载时被忽略
+    const quint64 logId = m_logId + 1;
+    QDataStream out(&file);
+    out << IndexMagic << IndexVersion << logId;
+    out << qint32(m_files.size());
+    for (const FileEntry &entry : m_files) {
+        out << entry.path << entry.modified << entry.size << entry.alive << entry.binary;
+    }
+    out << qint32(m_postings.size());
+    for (auto it = m_postings.constBegin(); it != m_postings.constEnd(); ++it) {
+        out << it.key() << it.value();
+    }
+    if (!file.commit()) return false;
+    m_logId = logId;
+    m_snapshotSize = QFileInfo(m_fileName).size();
+
+    m_log.close();
+    m_log.setFileName(m_fileName + ".log");
+    if (!m_log.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        qWarning("Couldn't open content index log.");
+        return false;
+    }
+    QDataStream log(&m_log);
+    log << LogMagic << LogVersion << m_logId;
+    return log.status() == QDataStream::Ok;
+}
@@ -0,0 +1,71 @@
+#ifndef CONTENTINDEX_H
+#define CONTENTINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QVector>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+class TreeWalker;
+
+// 绑定文件内容的三元组倒排索引，持久化在磁盘上
+// 每个文件的内容按 UTF-8 字节切分为三字节组，倒排表记录包含该三元组的文件编号。
+// 更新时比较修改时间和大小，只重新切分变化的文件：旧编号作废，变化的文件追加新编号，
+// 作废编号过多时压缩重排。查询时求关键字各三元组倒排表的交集得到候选文件，再由调用方逐个核实。
+// 磁盘上是一份快照加一个追加日志（文件名加 ".log"）：每切分完一个文件就把它的三元组并入内存索引，
+// 同时追加一条日志记录，不重写整个索引；日志比快照大或作废编号过多时压缩并重写快照、清空日志。
+// 快照和日志头部记录同一个编号，编号不一致的日志（重写快照后未及清空）整体忽略；末尾不完整的记录截掉。
+class ContentIndex
+{
+public:
+    void setFileName(const QString &fileName);
+
+    // 使索引与 files 一致，首次调用时从磁盘加载，变化逐个文件追加到日志
+    void update(const QStringList &files, const TreeWalker &walker, const std::atomic<bool> *cancelled = nullptr);
+
+    // 可能包含 needle 的文件在 files 中的序号；关键字不足三字节时无法筛选，返回全部非二进制文件
+    std::vector<int> candidates(const QByteArray &needle, const QStringList &files) const;
+
+    int fileCount() const { return m_byPath.size(); }
+
+    static void trigrams(const char *data, qint64 size, std::vector<quint32> &out);
+
+private:
+    struct FileEntry
+    {
+        QString path;
+        qint64 modified = 0;
+        qint64 size = 0;
+        bool alive = true;
+        bool binary = false;
+    };
+
+    void clear();
+    bool load();
+    bool replayLog();
+    bool applyRecord(const QByteArray &record);
+    bool save();
+    void compact();
+    void addEntry(const FileEntry &entry, const quint32 *keys, size_t count);
+    void removeEntry(const QString &path);
+    void appendRecord(const QByteArray &record);
+
+    QString m_fileName;
+    bool m_loaded = false;
+    QVector<FileEntry> m_files;
+    QHash<QString, int> m_byPath;                 // 路径 → 有效编号
+    QHash<quint32, QVector<int>> m_postings;      // 三元组 → 升序文件编号
+    int m_dead = 0;
+
+    QFile m_log;
+    quint64 m_logId = 0;        // 快照与日志共同的编号，每次重写快照加一
+    qint64 m_snapshotSize = 0;
+    std::mutex m_mutex;         // 并行切分时保护索引和日志的写入
+};
+
+#endif // CONTENTINDEX_H
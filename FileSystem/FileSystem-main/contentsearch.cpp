@@ -0,0 +1,117 @@
+#include "contentsearch.h"
+#include "treewalker.h"
+
+#include <cstring>
+#include <algorithm>
+
+MappedFile::MappedFile(const QString &path)
+    : m_file(path)
+{
+    if (!m_file.open(QIODevice::ReadOnly)) return;
+    m_size = m_file.size();
+    if (m_size == 0) return;
+
+    m_data = reinterpret_cast<const char*>(m_file.map(0, m_size));
+    if (!m_data) {
+        m_fallback = m_file.readAll();
+        m_data = m_fallback.constData();
+        m_size = m_fallback.size();
+    }
+}
+
+ContentSearch::ContentSearch(QObject *parent)
+    : QObject(parent), m_job(this)
+{
+}
+
+ContentSearch::~ContentSearch()
+{
+    cancel();
+}
+
+void ContentSearch::start(const QStringList &files, const QString &keyword, int threads)
+{
+    const QByteArray needle = keyword.toUtf8();
+    m_job.start([this, files, needle, threads]() -> BackgroundJob::Done {
+        // 先增量更新索引，再只扫描可能包含关键字的文件
+        const std::atomic<bool> *cancelled = m_job.cancelFlag();
+        TreeWalker walker(threads);
+        m_index.update(files, walker, cancelled);
+        const std::vector<int> candidates = m_index.candidates(needle, files);
+
+        // 每个文件扫描完就投递到主线程
+        const std::vector<int> counts = walker.map(candidates, [&](int file) {
+            if (m_job.isCancelled()) return 0;
+            QVector<ContentMatch> matches;
+            int count = scanFile(files[file], needle, file, matches, cancelled);
+            if (count > 0) {
+                m_job.post([this, matches]() { emit matchesFound(matches); });
+            }
+            return std::max(count, 0);
+        });
+
+        int total = 0;
+        for (int count : counts) {
+            total += count;
+        }
+        const int scanned = files.size();
+        return [this, scanned, total]() { emit finished(scanned, total); };
+    });
+}
+
+bool ContentSearch::looksBinary(const char *data, qint64 size)
+{
+    // 与常见工具一致：开头一段内出现 '\0' 即视为二进制
+    return std::memchr(data, '\0', static_cast<size_t>(std::min<qint64>(size, 8192))) != nullptr;
+}
+
+int ContentSearch::scanFile(const QString &path, const QByteArray &needle, int file, QVector<ContentMatch> &out,
+                            const std::atomic<bool> *cancelled)
+{
+    MappedFile f(path);
+    if (needle.isEmpty() || !f.isOpen()) return -1;
+    const char *data = f.data();
+    const qint64 size = f.size();
+    if (size < needle.size()) return 0;
+    if (looksBinary(data, size)) return -1;
+
+    // memchr 由 libc 以 SIMD 实现：先定位首字节，再比较其余字节
+    const char *begin = data;
+    const char *end = data + size;
+    const char first = needle[0];
+    const qsizetype rest = needle.size() - 1;
+    const char *lineStart = begin;
+    const char *counted = begin;
+    int line = 1;
+    int count = 0;
+
+    const char *p = begin;
+    while (p <= end - needle.size()) {
+        p = static_cast<const char*>(std::memchr(p, first, static_cast<size_t>(end - needle.size() - p + 1)));
+        if (!p) break;
+        if (std::memcmp(p + 1, needle.constData() + 1, static_cast<size_t>(rest)) != 0) {
+            ++p;
+            continue;
+        }
+        if (cancelled && cancelled->load(std::memory_order_relaxed)) break;
+
+        // 增量统计行号，只扫描上一处匹配之后的部分
+        for (const char *nl = counted; (nl = static_cast<const char*>(std::memchr(nl, '\n', static_cast<size_t>(p - nl)))); ++nl) {
+            ++line;
+            lineStart = nl + 1;
+        }
+        counted = p;
+
+        const char *lineEnd = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        if (!lineEnd) lineEnd = end;
+        ContentMatch match;
+        match.file = file;
+        match.line = line;
+        match.offset = p - begin;
+        match.text = QString::fromUtf8(lineStart, std::min<qsizetype>(lineEnd - lineStart, 200)).trimmed();
+        out.append(match);
+        ++count;
+        p += needle.size();
+    }
+    return count;
+}
@@ -0,0 +1,73 @@
+#ifndef CONTENTSEARCH_H
+#define CONTENTSEARCH_H
+
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+#include <QByteArray>
+#include <QFile>
+#include <atomic>
+
+#include "backgroundjob.h"
+#include "contentindex.h"
+
+// 只读映射一个文件，映射失败（如特殊文件系统）时退回整体读取
+class MappedFile
+{
+public:
+    explicit MappedFile(const QString &path);
+
+    bool isOpen() const { return m_data != nullptr || m_size == 0; }
+    const char *data() const { return m_data; }
+    qint64 size() const { return m_size; }
+
+private:
+    QFile m_file;
+    QByteArray m_fallback;
+    const char *m_data = nullptr;
+    qint64 m_size = -1;
+};
+
+// 一处内容匹配：文件在搜索列表中的序号、行号（从1开始）、字节偏移和该行内容
+struct ContentMatch
+{
+    int file = -1;
+    int line = 0;
+    qint64 offset = 0;
+    QString text;
+};
+
+// 在绑定文件中并行搜索内容
+// 文件以内存映射方式读取，按 UTF-8 字节精确匹配（区分大小写）；开头含 '\0' 的文件视为二进制跳过。
+// 搜索前先增量更新内容索引，只扫描索引给出的候选文件；
+// 结果按文件分批在主线程上通过 matchesFound 发出，开始新搜索或 cancel() 后旧结果不再发出。
+class ContentSearch : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ContentSearch(QObject *parent = nullptr);
+    ~ContentSearch();
+
+    // 内容索引文件，首次搜索时在后台线程加载
+    void setIndexFile(const QString &path) { m_index.setFileName(path); }
+
+    void start(const QStringList &files, const QString &keyword, int threads);
+    void cancel() { m_job.cancel(); }
+    bool isRunning() const { return m_job.isRunning(); }
+
+    // 扫描单个文件，返回匹配数；二进制或无法读取的文件返回 -1
+    static int scanFile(const QString &path, const QByteArray &needle, int file, QVector<ContentMatch> &out,
+                        const std::atomic<bool> *cancelled = nullptr);
+    static bool looksBinary(const char *data, qint64 size);
+
+signals:
+    void matchesFound(const QVector<ContentMatch> &matches);
+    void finished(int scannedFiles, int matchCount);
+
+private:
+    BackgroundJob m_job;
+    ContentIndex m_index;    // 只在后台线程中访问，同一时刻至多一个搜索线程
+};
+
+#endif // CONTENTSEARCH_H
@@ -0,0 +1,97 @@
+#include "counters.h"
+
+#include <mutex>
+
+namespace {
+
+// 登记只发生在静态对象构造时，读取发生在刷新面板时，都很少，用一把锁即可
+struct Registry
+{
+    std::mutex mutex;
+    QVector<Counter*> counters;
+    QVector<Histogram*> histograms;
+};
+
+Registry &registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+}
+
+Counter::Counter(const char *name, const char *label, Unit unit)
+    : m_name(name), m_label(label), m_unit(unit)
+{
+    Counters::add(this);
+}
+
+Histogram::Histogram(const char *name, const char *label, std::initializer_list<qint64> bounds)
+    : m_name(name), m_label(label), m_bounds(bounds), m_counts(new std::atomic<qint64>[bounds.size() + 1])
+{
+    reset();
+    Counters::add(this);
+}
+
+void Histogram::record(qint64 value)
+{
+    int i = 0;
+    while (i < int(m_bounds.size()) && value > m_bounds[i]) {
+        ++i;
+    }
+    m_counts[i].fetch_add(1, std::memory_order_relaxed);
+}
+
+qint64 Histogram::total() const
+{
+    qint64 sum = 0;
+    for (int i = 0; i < bucketCount(); ++i) {
+        sum += count(i);
+    }
+    return sum;
+}
+
+void Histogram::reset()
+{
+    for (int i = 0; i < bucketCount(); ++i) {
+        m_counts[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+QVector<Counter*> Counters::counters()
+{
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    return r.counters;
+}
+
+QVector<Histogram*> Counters::histograms()
+{
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    return r.histograms;
+}
+
+Counter *Counters::find(const QString &name)
+{
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (Counter *counter : r.counters) {
+        if (name == QLatin1String(counter->name())) return counter;
+    }
+    return nullptr;
+}
+
+void Counters::add(Counter *counter)
+{
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.counters.append(counter);
+}
+
+void Counters::add(Histogram *histogram)
+{
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.histograms.append(histogram);
+}
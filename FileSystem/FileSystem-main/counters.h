@@ -0,0 +1,100 @@
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <chrono>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
+// 具名计数器
+// 各模块把计数器定义为静态对象，构造时自动登记；更新只是一次原子写，可在任意线程进行。
+// 诊断面板和基准程序通过 Counters 读取全部计数器。
+class Counter
+{
+public:
+    enum Unit { Count, Bytes, Milliseconds };
+
+    Counter(const char *name, const char *label, Unit unit = Count);
+    Counter(const Counter &) = delete;
+    Counter &operator=(const Counter &) = delete;
+
+    const char *name() const { return m_name; }
+    QString label() const { return QString::fromUtf8(m_label); }
+    Unit unit() const { return m_unit; }
+
+    qint64 value() const { return m_value.load(std::memory_order_relaxed); }
+    void set(qint64 value) { m_value.store(value, std::memory_order_relaxed); }
+    void add(qint64 delta) { m_value.fetch_add(delta, std::memory_order_relaxed); }
+
+private:
+    const char *m_name;
+    const char *m_label;
+    Unit m_unit;
+    std::atomic<qint64> m_value{0};
+};
+
+// 按固定上界分桶的直方图，最后一个桶收集超过所有上界的值
+class Histogram
+{
+public:
+    Histogram(const char *name, const char *label, std::initializer_list<qint64> bounds);
+    Histogram(const Histogram &) = delete;
+    Histogram &operator=(const Histogram &) = delete;
+
+    const char *name() const { return m_name; }
+    QString label() const { return QString::fromUtf8(m_label); }
+
+    void record(qint64 value);
+    int bucketCount() const { return int(m_bounds.size()) + 1; }
+    // 第 i 个桶的上界（含），最后一个桶返回 -1
+    qint64 bound(int i) const { return i < int(m_bounds.size()) ? m_bounds[i] : -1; }
+    qint64 count(int i) const { return m_counts[i].load(std::memory_order_relaxed); }
+    qint64 total() const;
+    void reset();
+
+private:
+    const char *m_name;
+    const char *m_label;
+    std::vector<qint64> m_bounds;
+    std::unique_ptr<std::atomic<qint64>[]> m_counts;
+};
+
+class Counters
+{
+public:
+    // 按登记顺序返回
+    static QVector<Counter*> counters();
+    static QVector<Histogram*> histograms();
+    static Counter *find(const QString &name);
+
+private:
+    friend class Counter;
+    friend class Histogram;
+    static void add(Counter *counter);
+    static void add(Histogram *histogram);
+};
+
+// 作用域结束时把耗时（毫秒）写入计数器
+class ScopedDuration
+{
+public:
+    explicit ScopedDuration(Counter &counter)
+        : m_counter(counter), m_start(std::chrono::steady_clock::now()) {}
+    ~ScopedDuration()
+    {
+        m_counter.set(std::chrono::duration_cast<std::chrono::milliseconds>(
+                          std::chrono::steady_clock::now() - m_start).count());
+    }
+
+    ScopedDuration(const ScopedDuration &) = delete;
+    ScopedDuration &operator=(const ScopedDuration &) = delete;
+
+private:
+    Counter &m_counter;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+#endif // COUNTERS_H
@@ -0,0 +1,103 @@
+#include "diagnosticspanel.h"
+#include "counters.h"
+#include "folderstats.h"
+#include "processmemory.h"
+
+#include <QHeaderView>
+#include <QPushButton>
+#include <QVBoxLayout>
+
+DiagnosticsPanel::DiagnosticsPanel(QWidget *parent)
+    : QWidget(parent, Qt::Tool)
+{
+    setWindowTitle("诊断");
+    resize(420, 480);
+
+    m_table = new QTreeWidget(this);
+    m_table->setColumnCount(2);
+    m_table->setHeaderLabels({"项目", "数值"});
+    m_table->setRootIsDecorated(false);
+    m_table->header()->resizeSection(0, 240);
+    m_counterSection = new QTreeWidgetItem(m_table, {"计数器"});
+    m_histogramSection = new QTreeWidgetItem(m_table, {"事件循环延迟"});
+    m_processSection = new QTreeWidgetItem(m_table, {"进程"});
+    m_table->expandAll();
+
+    QPushButton *resetButton = new QPushButton("清零直方图", this);
+    connect(resetButton, &QPushButton::clicked, this, &DiagnosticsPanel::resetHistograms);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addWidget(m_table);
+    layout->addWidget(resetButton, 0, Qt::AlignRight);
+
+    m_timer.setInterval(500);
+    connect(&m_timer, &QTimer::timeout, this, &DiagnosticsPanel::refresh);
+}
+
+void DiagnosticsPanel::showEvent(QShowEvent *event)
+{
+    refresh();
+    m_timer.start();
+    QWidget::showEvent(event);
+}
+
+void DiagnosticsPanel::hideEvent(QHideEvent *event)
+{
+    m_timer.stop();
+    QWidget::hideEvent(event);
+}
+
+// 复用已有的行，只更新文字，刷新时不重建条目
+QTreeWidgetItem *DiagnosticsPanel::row(QTreeWidgetItem *section, int index, const QString &label)
+{
+    QTreeWidgetItem *item = index < section->childCount() ? section->child(index) : new QTreeWidgetItem(section);
+    item->setText(0, label);
+    return item;
+}
+
+void DiagnosticsPanel::refresh()
+{
+    const QVector<Counter*> counters = Counters::counters();
+    for (int i = 0; i < counters.size(); ++i) {
+        const Counter *counter = counters[i];
+        QTreeWidgetItem *item = row(m_counterSection, i, counter->label());
+        item->setToolTip(0, QString::fromLatin1(counter->name()));
+        switch (counter->unit()) {
+        case Counter::Bytes:
+            item->setText(1, FolderStats::formatSize(counter->value()));
+            break;
+        case Counter::Milliseconds:
+            item->setText(1, QString("%1 ms").arg(counter->value()));
+            break;
+        default:
+            item->setText(1, QString::number(counter->value()));
+            break;
+        }
+    }
+
+    // 各直方图依次排列，每个桶一行：上界、次数和占比
+    int index = 0;
+    for (const Histogram *histogram : Counters::histograms()) {
+        const qint64 total = histogram->total();
+        row(m_histogramSection, index++, histogram->label())->setText(1, QString("共 %1 次").arg(total));
+        for (int i = 0; i < histogram->bucketCount(); ++i) {
+            const QString label = histogram->bound(i) >= 0
+                ? QString("    ≤ %1").arg(histogram->bound(i))
+                : QString("    > %1").arg(histogram->bound(i - 1));
+            const qint64 count = histogram->count(i);
+            const double percent = total > 0 ? 100.0 * count / total : 0.0;
+            row(m_histogramSection, index++, label)->setText(1, QString("%1 (%2%)").arg(count).arg(percent, 0, 'f', 1));
+        }
+    }
+
+    row(m_processSection, 0, "常驻内存")->setText(1, FolderStats::formatSize(ProcessMemory::residentBytes()));
+    row(m_processSection, 1, "峰值内存")->setText(1, FolderStats::formatSize(ProcessMemory::peakResidentBytes()));
+}
+
+void DiagnosticsPanel::resetHistograms()
+{
+    for (Histogram *histogram : Counters::histograms()) {
+        histogram->reset();
+    }
+    refresh();
+}
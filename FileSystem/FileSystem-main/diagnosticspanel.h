@@ -0,0 +1,32 @@
+#ifndef DIAGNOSTICSPANEL_H
+#define DIAGNOSTICSPANEL_H
+
+#include <QWidget>
+#include <QTimer>
+#include <QTreeWidget>
+
+// 诊断面板
+// 独立的工具窗口，显示全部已登记的计数器、事件循环延迟直方图和进程内存，显示期间每半秒刷新一次。
+// 数据都来自 Counters，面板关闭时不产生任何开销。
+class DiagnosticsPanel : public QWidget
+{
+public:
+    explicit DiagnosticsPanel(QWidget *parent = nullptr);
+
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private:
+    void refresh();
+    void resetHistograms();
+    QTreeWidgetItem *row(QTreeWidgetItem *section, int index, const QString &label);
+
+    QTreeWidget *m_table = nullptr;
+    QTreeWidgetItem *m_counterSection = nullptr;
+    QTreeWidgetItem *m_histogramSection = nullptr;
+    QTreeWidgetItem *m_processSection = nullptr;
+    QTimer m_timer;
+};
+
+#endif // DIAGNOSTICSPANEL_H
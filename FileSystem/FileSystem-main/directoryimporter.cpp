@@ -0,0 +1,166 @@
+#include "directoryimporter.h"
+#include "treewalker.h"
+#include "filetypes.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#ifdef Q_OS_UNIX
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+struct ScanNode
+{
+    QByteArray path;    // 本地编码的完整路径
+    qint32 id = 0;
+    qint32 parent = -1;
+    bool dir = false;
+};
+
+}
+
+// 读取一个目录的直接子项；符号链接不跟随，避免循环
+static void readDirectory(const ScanNode &dir, std::atomic<qint32> &nextId, std::vector<ScanNode> &out)
+{
+#ifdef Q_OS_UNIX
+    DIR *handle = opendir(dir.path.constData());
+    if (!handle) return;
+    const bool needSlash = !dir.path.endsWith('/');
+    while (dirent *entry = readdir(handle)) {
+        const char *name = entry->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+
+        ScanNode node;
+        node.path.reserve(dir.path.size() + 1 + static_cast<int>(std::strlen(name)));
+        node.path.append(dir.path);
+        if (needSlash) node.path.append('/');
+        node.path.append(name);
+#ifdef DT_DIR
+        // d_type 可用时无需逐项 stat
+        if (entry->d_type != DT_UNKNOWN) {
+            node.dir = (entry->d_type == DT_DIR);
+        } else
+#endif
+        {
+            struct stat st;
+            node.dir = lstat(node.path.constData(), &st) == 0 && S_ISDIR(st.st_mode);
+        }
+        node.id = nextId.fetch_add(1, std::memory_order_relaxed);
+        node.parent = dir.id;
+        out.push_back(node);
+    }
+    closedir(handle);
+#else
+    QDirIterator it(QFile::decodeName(dir.path), QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System);
+    while (it.hasNext()) {
+        it.next();
+        const QFileInfo info = it.fileInfo();
+        ScanNode node;
+        node.path = QFile::encodeName(info.filePath());
+        node.dir = info.isDir() && !info.isSymLink();
+        node.id = nextId.fetch_add(1, std::memory_order_relaxed);
+        node.parent = dir.id;
+        out.push_back(node);
+    }
+#endif
+}
+
+// 并行读取 root 下的整棵目录树，结果按父目录分组、组内文件夹在前并按名称排序；
+// 父目录编号总小于子项编号，按此顺序建节点时父节点总已建好。count 返回编号总数（含 root）
+static std::vector<ScanNode> scanTree(const ScanNode &root, int threads, const std::atomic<bool> &cancelled,
+                                      std::atomic<qint64> &scanned, qint32 &count)
+{
+    // 每个线程把读到的目录项记入自己的列表
+    std::atomic<qint32> nextId(1);
+    TreeWalker walker(threads);
+    std::vector<std::vector<ScanNode>> found(walker.threadCount());
+    walker.walk(root, [&](const ScanNode &dir, std::vector<ScanNode> &out) {
+        if (cancelled.load(std::memory_order_relaxed)) return;
+        readDirectory(dir, nextId, out);
+    }, [&](const ScanNode &node, int worker) {
+        found[worker].push_back(node);
+        scanned.fetch_add(1, std::memory_order_relaxed);
+        return node.dir;
+    });
+    count = nextId.load();
+    if (cancelled) return {};
+
+    std::vector<ScanNode> entries;
+    for (std::vector<ScanNode> &part : found) {
+        entries.insert(entries.end(), part.begin(), part.end());
+        std::vector<ScanNode>().swap(part);
+    }
+    std::sort(entries.begin(), entries.end(), [](const ScanNode &a, const ScanNode &b) {
+        if (a.parent != b.parent) return a.parent < b.parent;
+        if (a.dir != b.dir) return a.dir;
+        return a.path < b.path;
+    });
+    return entries;
+}
+
+DirectoryImporter::DirectoryImporter(QObject *parent)
+    : QObject(parent), m_job(this)
+{
+}
+
+DirectoryImporter::~DirectoryImporter()
+{
+    cancel();
+}
+
+void DirectoryImporter::start(const QString &path, const QMap<QString, QIcon> &icons, int threads)
+{
+    m_scanned = 0;
+    m_job.start([this, path, icons, threads]() -> BackgroundJob::Done {
+        ScanNode root;
+        root.path = QFile::encodeName(QDir::cleanPath(QDir(path).absolutePath()));
+        root.id = 0;
+        root.dir = true;
+        qint32 count = 0;
+        auto entries = std::make_shared<std::vector<ScanNode>>(scanTree(root, threads, *m_job.cancelFlag(), m_scanned, count));
+        if (m_job.isCancelled()) return {};
+
+        const qint64 total = scanned();
+        return [this, root, entries, count, icons, total]() {
+            std::vector<QStandardItem*> items(static_cast<size_t>(count), nullptr);
+            QList<QStandardItem*> rootRow = makeRow(QFile::decodeName(root.path), true, icons);
+            items[0] = rootRow[0];
+            for (const ScanNode &node : *entries) {
+                QList<QStandardItem*> row = makeRow(QFile::decodeName(node.path), node.dir, icons);
+                items[node.id] = row[0];
+                items[node.parent]->appendRow(row);
+            }
+            emit finished(rootRow, total);
+        };
+    });
+}
+
+QList<QStandardItem*> DirectoryImporter::makeRow(const QString &fullPath, bool dir, const QMap<QString, QIcon> &icons)
+{
+    QString name = fullPath.mid(fullPath.lastIndexOf('/') + 1);
+    if (name.isEmpty()) name = fullPath;
+
+    QString type = "文件夹";
+    QIcon icon = icons.value("treeItem_Project");
+    if (!dir) {
+        int dot = name.lastIndexOf('.');
+        FileTypeInfo info = fileTypeForSuffix(dot > 0 ? name.mid(dot + 1) : QString());
+        type = info.type;
+        icon = icons.value(info.iconKey, icons.value("treeItem_Unknownfile"));
+    }
+
+    QStandardItem *item = new QStandardItem(icon, name);
+    item->setData(type, Qt::UserRole + 1);
+    item->setData(fullPath, Qt::UserRole + 2);
+    QStandardItem *typeItem = new QStandardItem(type);
+    typeItem->setData(type, Qt::UserRole + 1);
+    return {item, typeItem};
+}
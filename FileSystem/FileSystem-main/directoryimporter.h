@@ -0,0 +1,43 @@
+#ifndef DIRECTORYIMPORTER_H
+#define DIRECTORYIMPORTER_H
+
+#include <QObject>
+#include <QStandardItem>
+#include <QMap>
+#include <QIcon>
+#include <atomic>
+
+#include "backgroundjob.h"
+
+// 把磁盘上的真实目录导入为文件夹/文件节点
+// 后台线程中以工作窃取方式并行读取目录（Unix 上直接用 readdir，由 getdents 批量取回目录项），
+// 并按父目录排好序；节点在主线程上一次建好交给调用方，QStandardItem 不在其他线程上创建。
+// 文件节点带 UserRole+2 真实路径和按后缀识别的图标，文件夹节点也记录其真实路径。
+class DirectoryImporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DirectoryImporter(QObject *parent = nullptr);
+    ~DirectoryImporter();
+
+    void start(const QString &path, const QMap<QString, QIcon> &icons, int threads);
+    void cancel() { m_job.cancel(); }
+    bool isRunning() const { return m_job.isRunning(); }
+
+    // 已扫描的目录项数，可在任意线程读取，用于显示进度
+    qint64 scanned() const { return m_scanned.load(std::memory_order_relaxed); }
+
+    // 为磁盘上的一个文件或文件夹建立一行节点（名称列和类型列）
+    static QList<QStandardItem*> makeRow(const QString &fullPath, bool dir, const QMap<QString, QIcon> &icons);
+
+signals:
+    // root 为导入目录对应的一行（名称列和类型列），所有权交给接收方
+    void finished(QList<QStandardItem*> root, qint64 entries);
+
+private:
+    BackgroundJob m_job;
+    std::atomic<qint64> m_scanned{0};
+};
+
+#endif // DIRECTORYIMPORTER_H
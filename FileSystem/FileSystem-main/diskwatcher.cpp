@@ -0,0 +1,284 @@
+#include "diskwatcher.h"
+
+#include <QFile>
+#include <QMutexLocker>
+#include <algorithm>
+#include <vector>
+
+#ifdef Q_OS_LINUX
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <cerrno>
+
+static const quint32 WatchMask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY | IN_CLOSE_WRITE
+                                 | IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK;
+#endif
+
+DiskWatcher::DiskWatcher(QObject *parent)
+    : QObject(parent)
+{
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(200);
+    connect(&m_flushTimer, &QTimer::timeout, this, &DiskWatcher::flush);
+
+#ifdef Q_OS_LINUX
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0) {
+        qWarning("inotify_init1 failed, disk changes will not be tracked.");
+        return;
+    }
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &DiskWatcher::readEvents);
+#endif
+}
+
+DiskWatcher::~DiskWatcher()
+{
+    {
+        QMutexLocker locker(&m_queueMutex);
+        m_stopping = true;
+        m_queueReady.wakeAll();
+    }
+    if (m_worker) {
+        m_worker->wait();
+        delete m_worker;
+    }
+
+#ifdef Q_OS_LINUX
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+#endif
+}
+
+int DiskWatcher::watchCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_paths.size();
+}
+
+void DiskWatcher::addTree(const QString &root)
+{
+    if (!isSupported()) return;
+    startAdding(QFile::encodeName(root), false);
+}
+
+void DiskWatcher::startAdding(const QByteArray &root, bool reportContents)
+{
+    QMutexLocker locker(&m_queueMutex);
+    if (m_stopping) return;
+    // 同一目录尚未处理时只合并标志
+    for (PendingRoot &pending : m_roots) {
+        if (pending.path == root) {
+            pending.reportContents = pending.reportContents || reportContents;
+            return;
+        }
+    }
+    m_roots.append(PendingRoot{root, reportContents});
+    if (!m_worker) {
+        m_worker = QThread::create([this]() { runAdding(); });
+        m_worker->start();
+    }
+    m_queueReady.wakeOne();
+}
+
+void DiskWatcher::runAdding()
+{
+    for (;;) {
+        PendingRoot pending;
+        {
+            QMutexLocker locker(&m_queueMutex);
+            while (m_roots.isEmpty() && !m_stopping) {
+                m_queueReady.wait(&m_queueMutex);
+            }
+            if (m_stopping) return;
+            pending = m_roots.takeFirst();
+        }
+        addWatches(pending.path, pending.reportContents);
+    }
+}
+
+void DiskWatcher::removeTree(const QString &root)
+{
+    if (!isSupported()) return;
+    removeWatches(QFile::encodeName(root));
+}
+
+void DiskWatcher::addWatches(const QByteArray &root, bool reportContents)
+{
+#ifdef Q_OS_LINUX
+    // 先添加监视再读取目录，之后新建的文件由事件报告，已有的文件由读取结果补报，两者按路径合并
+    QVector<DiskChange> found;
+    std::vector<QByteArray> stack(1, root);
+    while (!stack.empty() && !m_stopping) {
+        const QByteArray dir = stack.back();
+        stack.pop_back();
+        if (addWatch(dir) < 0) continue;
+
+        DIR *handle = opendir(dir.constData());
+        if (!handle) continue;
+        while (dirent *entry = readdir(handle)) {
+            const char *name = entry->d_name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+            const QByteArray path = dir + '/' + name;
+            bool isDir = false;
+            if (entry->d_type != DT_UNKNOWN) {
+                isDir = (entry->d_type == DT_DIR);
+            } else {
+                struct stat st;
+                isDir = lstat(path.constData(), &st) == 0 && S_ISDIR(st.st_mode);
+            }
+            if (isDir) {
+                stack.push_back(path);
+            }
+            if (reportContents) {
+                found.append(DiskChange{DiskChange::Created, QFile::decodeName(path), isDir});
+            }
+        }
+        closedir(handle);
+    }
+
+    if (!found.isEmpty()) {
+        QMetaObject::invokeMethod(this, [this, found]() {
+            for (const DiskChange &change : found) {
+                queueChange(change.kind, change.path, change.dir);
+            }
+        }, Qt::QueuedConnection);
+    }
+#else
+    Q_UNUSED(root)
+    Q_UNUSED(reportContents)
+#endif
+}
+
+int DiskWatcher::addWatch(const QByteArray &path)
+{
+#ifdef Q_OS_LINUX
+    int wd = inotify_add_watch(m_fd, path.constData(), WatchMask);
+    if (wd < 0) {
+        static std::atomic<bool> warned(false);
+        if (errno == ENOSPC && !warned.exchange(true)) {
+            qWarning("inotify watch limit reached, raise fs.inotify.max_user_watches to watch more folders.");
+        }
+        return -1;
+    }
+    QMutexLocker locker(&m_mutex);
+    m_paths.insert(wd, path);
+    m_watches.insert(path, wd);
+    return wd;
+#else
+    Q_UNUSED(path)
+    return -1;
+#endif
+}
+
+void DiskWatcher::removeWatches(const QByteArray &prefix)
+{
+#ifdef Q_OS_LINUX
+    const QByteArray childPrefix = prefix + '/';
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_watches.begin(); it != m_watches.end();) {
+        if (it.key() != prefix && !it.key().startsWith(childPrefix)) {
+            ++it;
+            continue;
+        }
+        inotify_rm_watch(m_fd, it.value());
+        m_paths.remove(it.value());
+        it = m_watches.erase(it);
+    }
+#else
+    Q_UNUSED(prefix)
+#endif
+}
+
+void DiskWatcher::readEvents()
+{
+#ifdef Q_OS_LINUX
+    alignas(inotify_event) char buffer[64 * 1024];
+    for (;;) {
+        const ssize_t length = read(m_fd, buffer, sizeof(buffer));
+        if (length <= 0) break;
+
+        for (const char *p = buffer; p < buffer + length;) {
+            const inotify_event *event = reinterpret_cast<const inotify_event*>(p);
+            p += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                qWarning("inotify event queue overflowed, some disk changes were lost.");
+                continue;
+            }
+
+            QByteArray dir;
+            {
+                QMutexLocker locker(&m_mutex);
+                dir = m_paths.value(event->wd);
+                // 目录被删除或移出文件系统后内核自动撤销监视
+                if (event->mask & IN_IGNORED) {
+                    m_paths.remove(event->wd);
+                    if (m_watches.value(dir, -1) == event->wd) {
+                        m_watches.remove(dir);
+                    }
+                    continue;
+                }
+            }
+            // 没有名称的是目录自身的事件，由其父目录上的事件处理
+            if (dir.isEmpty() || event->len == 0) continue;
+
+            const QByteArray path = dir + '/' + QByteArray(event->name);
+            const bool isDir = event->mask & IN_ISDIR;
+            if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                queueChange(DiskChange::Created, QFile::decodeName(path), isDir);
+                if (isDir) {
+                    startAdding(path, true);
+                }
+            } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                queueChange(DiskChange::Removed, QFile::decodeName(path), isDir);
+                if (isDir) {
+                    removeWatches(path);
+                }
+            } else if (event->mask & (IN_MODIFY | IN_CLOSE_WRITE)) {
+                queueChange(DiskChange::Modified, QFile::decodeName(path), false);
+            }
+        }
+    }
+#endif
+}
+
+void DiskWatcher::queueChange(DiskChange::Kind kind, const QString &path, bool dir)
+{
+    // 同一路径只保留最终状态；新建后又修改仍视为新建，删除后又新建记为替换，类型取最后一次的
+    auto it = m_pending.find(path);
+    if (it != m_pending.end()) {
+        if (kind == DiskChange::Modified && it->kind == DiskChange::Created) return;
+        if (kind == DiskChange::Created && it->kind == DiskChange::Removed) {
+            it->replaced = true;
+        } else if (kind == DiskChange::Removed) {
+            it->replaced = false;
+        }
+        it->kind = kind;
+        it->dir = dir;
+    } else {
+        m_pending.insert(path, DiskChange{kind, path, dir});
+    }
+    if (!m_flushTimer.isActive()) {
+        m_flushTimer.start();
+    }
+}
+
+void DiskWatcher::flush()
+{
+    QVector<DiskChange> changes;
+    changes.reserve(m_pending.size());
+    for (auto it = m_pending.constBegin(); it != m_pending.constEnd(); ++it) {
+        changes.append(it.value());
+    }
+    m_pending.clear();
+
+    // 按路径排序，新建的目录总排在其内容之前
+    std::sort(changes.begin(), changes.end(), [](const DiskChange &a, const DiskChange &b) {
+        return a.path < b.path;
+    });
+    emit changed(changes);
+}
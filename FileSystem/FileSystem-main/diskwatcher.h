@@ -0,0 +1,79 @@
+#ifndef DISKWATCHER_H
+#define DISKWATCHER_H
+
+#include <QObject>
+#include <QHash>
+#include <QMutex>
+#include <QThread>
+#include <QTimer>
+#include <QWaitCondition>
+#include <QVector>
+#include <QSocketNotifier>
+#include <atomic>
+
+// 磁盘变化，路径为真实的绝对路径
+struct DiskChange
+{
+    enum Kind { Created, Removed, Modified };
+    Kind kind = Modified;
+    QString path;
+    bool dir = false;
+    bool replaced = false;  // 先删除后新建：原有的节点应整个替换（类型可能从文件变为目录或相反）
+};
+
+// 监视导入的目录树
+// Linux 上直接使用 inotify：每个目录一个监视描述符（文件不单独监视），所有事件由同一个描述符读出，
+// 不需要为每个路径创建监视对象，也不轮询。事件按路径合并（同一路径只保留最终状态），
+// 攒够一小段时间后通过 changed 一次性发出。新建的子目录会自动加入监视，其中已有的内容作为新建事件补发；
+// 添加监视由同一个后台线程按队列依次完成，大量目录同时出现时也不会创建更多线程。
+// 其他平台上 isSupported() 返回 false，不做任何事。
+class DiskWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DiskWatcher(QObject *parent = nullptr);
+    ~DiskWatcher();
+
+    bool isSupported() const { return m_fd >= 0; }
+    int watchCount() const;
+
+    // 在后台线程中递归地为 root 下的所有目录添加监视
+    void addTree(const QString &root);
+    void removeTree(const QString &root);
+
+signals:
+    void changed(const QVector<DiskChange> &changes);
+
+private:
+    void readEvents();
+    void queueChange(DiskChange::Kind kind, const QString &path, bool dir);
+    void flush();
+    void startAdding(const QByteArray &root, bool reportContents);
+    void runAdding();
+    void addWatches(const QByteArray &root, bool reportContents);
+    int addWatch(const QByteArray &path);
+    void removeWatches(const QByteArray &prefix);
+
+    int m_fd = -1;
+    QSocketNotifier *m_notifier = nullptr;
+    QTimer m_flushTimer;
+    QHash<QString, DiskChange> m_pending;
+
+    mutable QMutex m_mutex;                 // 保护下面两个表，后台线程也会添加监视
+    QHash<int, QByteArray> m_paths;         // 监视描述符 → 目录路径
+    QHash<QByteArray, int> m_watches;       // 目录路径 → 监视描述符
+
+    struct PendingRoot
+    {
+        QByteArray path;
+        bool reportContents = false;
+    };
+    QThread *m_worker = nullptr;            // 添加监视的后台线程，第一次需要时创建
+    QMutex m_queueMutex;
+    QWaitCondition m_queueReady;
+    QVector<PendingRoot> m_roots;           // 等待添加监视的目录
+    std::atomic<bool> m_stopping{false};
+};
+
+#endif // DISKWATCHER_H
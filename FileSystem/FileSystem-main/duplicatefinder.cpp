@@ -0,0 +1,193 @@
+#include "duplicatefinder.h"
+#include "contenthash.h"
+#include "treewalker.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <algorithm>
+
+static const quint32 CacheMagic = 0x46534448;   // "FSDH"
+static const quint32 CacheVersion = 1;
+static const qint64 ReadChunk = 1 << 20;
+
+DuplicateFinder::DuplicateFinder(QObject *parent)
+    : QObject(parent), m_job(this)
+{
+}
+
+DuplicateFinder::~DuplicateFinder()
+{
+    cancel();
+}
+
+bool DuplicateFinder::hashFile(const QString &path, quint64 &hash, const std::atomic<bool> *cancelled)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) return false;
+
+    // 每个线程复用一块读缓冲，内存占用与文件大小无关
+    thread_local std::vector<char> buffer(ReadChunk);
+    ContentHash h;
+    for (;;) {
+        if (cancelled && cancelled->load(std::memory_order_relaxed)) return false;
+        const qint64 n = file.read(buffer.data(), ReadChunk);
+        if (n < 0) return false;
+        if (n == 0) break;
+        h.update(buffer.data(), static_cast<size_t>(n));
+    }
+    hash = h.digest();
+    return true;
+}
+
+void DuplicateFinder::start(const QStringList &files, int threads)
+{
+    m_job.start([this, files, threads]() -> BackgroundJob::Done {
+        if (!m_loaded) {
+            if (!loadCache()) m_cache.clear();
+            m_loaded = true;
+        }
+
+        TreeWalker walker(threads);
+        std::vector<int> all(files.size());
+        for (int i = 0; i < files.size(); ++i) {
+            all[i] = i;
+        }
+        struct Stat
+        {
+            bool valid = false;
+            FileStamp stamp;
+        };
+        const std::vector<Stat> stats = walker.map(all, [&](int file) {
+            Stat s;
+            if (!m_job.isCancelled()) {
+                s.valid = FileStamp::read(files[file], s.stamp);
+            }
+            return s;
+        });
+
+        // 按大小分组，同一 inode 只保留第一个路径；空文件不算重复
+        QHash<qint64, QVector<int>> bySize;
+        QHash<FileStamp::Key, int> seen;
+        for (int i = 0; i < files.size(); ++i) {
+            const Stat &s = stats[i];
+            if (!s.valid || s.stamp.size == 0) continue;
+            if (seen.contains(s.stamp.key)) continue;
+            seen.insert(s.stamp.key, i);
+            bySize[s.stamp.size].append(i);
+        }
+
+        // 只有大小相同的文件需要散列；大文件先开始，避免最后只剩一个线程在读大文件
+        std::vector<int> candidates;
+        for (auto it = bySize.constBegin(); it != bySize.constEnd(); ++it) {
+            if (it.value().size() > 1) {
+                candidates.insert(candidates.end(), it.value().begin(), it.value().end());
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [&](int a, int b) {
+            return stats[a].stamp.size > stats[b].stamp.size;
+        });
+
+        struct Hashed
+        {
+            bool valid = false;
+            bool read = false;
+            quint64 hash = 0;
+        };
+        const QHash<FileStamp::Key, CacheEntry> &cache = m_cache;
+        const std::vector<Hashed> hashes = walker.map(candidates, [&](int file) {
+            Hashed h;
+            const FileStamp &stamp = stats[file].stamp;
+            auto it = cache.constFind(stamp.key);
+            if (it != cache.constEnd() && it->stamp.sameVersion(stamp)) {
+                h.valid = true;
+                h.hash = it->hash;
+                return h;
+            }
+            h.valid = hashFile(files[file], h.hash, m_job.cancelFlag());
+            h.read = h.valid;
+            return h;
+        });
+
+        int hashedFiles = 0;
+        qint64 hashedBytes = 0;
+        bool changed = false;
+        QHash<QPair<qint64, quint64>, QVector<int>> byContent;
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            if (!hashes[i].valid) continue;
+            const int file = candidates[i];
+            const FileStamp &stamp = stats[file].stamp;
+            if (hashes[i].read) {
+                m_cache.insert(stamp.key, CacheEntry{stamp, hashes[i].hash});
+                ++hashedFiles;
+                hashedBytes += stamp.size;
+                changed = true;
+            }
+            byContent[qMakePair(stamp.size, hashes[i].hash)].append(file);
+        }
+        if (changed && !m_job.isCancelled()) {
+            saveCache();
+        }
+
+        QVector<DuplicateGroup> groups;
+        for (auto it = byContent.begin(); it != byContent.end(); ++it) {
+            if (it.value().size() < 2) continue;
+            std::sort(it.value().begin(), it.value().end());
+            groups.append(DuplicateGroup{it.key().first, it.value()});
+        }
+        std::sort(groups.begin(), groups.end(), [](const DuplicateGroup &a, const DuplicateGroup &b) {
+            const qint64 wastedA = a.size * (a.files.size() - 1);
+            const qint64 wastedB = b.size * (b.files.size() - 1);
+            if (wastedA != wastedB) return wastedA > wastedB;
+            return a.files.first() < b.files.first();
+        });
+
+        const int scanned = files.size();
+        return [this, groups, scanned, hashedFiles, hashedBytes]() {
+            emit finished(groups, scanned, hashedFiles, hashedBytes);
+        };
+    });
+}
+
+bool DuplicateFinder::loadCache()
+{
+    if (m_cacheFile.isEmpty()) return false;
+    QFile file(m_cacheFile);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if (magic != CacheMagic || version != CacheVersion) return false;
+
+    qint32 count = 0;
+    in >> count;
+    m_cache.clear();
+    m_cache.reserve(count);
+    for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        CacheEntry entry;
+        in >> entry.stamp.key.device >> entry.stamp.key.inode >> entry.stamp.modified >> entry.stamp.size
+           >> entry.hash;
+        m_cache.insert(entry.stamp.key, entry);
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+bool DuplicateFinder::saveCache() const
+{
+    if (m_cacheFile.isEmpty()) return false;
+    QSaveFile file(m_cacheFile);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning("Couldn't open content hash cache.");
+        return false;
+    }
+
+    QDataStream out(&file);
+    out << CacheMagic << CacheVersion;
+    out << qint32(m_cache.size());
+    for (auto it = m_cache.constBegin(); it != m_cache.constEnd(); ++it) {
+        out << it->stamp.key.device << it->stamp.key.inode << it->stamp.modified << it->stamp.size << it->hash;
+    }
+    return file.commit();
+}
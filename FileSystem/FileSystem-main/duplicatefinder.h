@@ -0,0 +1,63 @@
+#ifndef DUPLICATEFINDER_H
+#define DUPLICATEFINDER_H
+
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <atomic>
+
+#include "backgroundjob.h"
+#include "filestamp.h"
+
+// 一组内容相同的文件：size 为单个文件的大小，files 为文件在查找列表中的序号
+struct DuplicateGroup
+{
+    qint64 size = 0;
+    QVector<int> files;
+};
+
+// 在绑定文件中并行查找内容相同的文件
+// 先并行 stat 按大小分组，只有大小相同的文件才需要比较内容；候选文件在 TreeWalker 线程上分块流式读取，
+// 计算 64 位内容散列，大小和散列都相同的归为一组。同一文件的多个硬链接只算一个。
+// 散列按 (设备, inode) 缓存并持久化，修改时间和大小都未变的文件再次查找时不重新读取。
+class DuplicateFinder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DuplicateFinder(QObject *parent = nullptr);
+    ~DuplicateFinder();
+
+    // 散列缓存文件，首次查找时在后台线程加载
+    void setCacheFile(const QString &path) { m_cacheFile = path; m_loaded = false; }
+
+    void start(const QStringList &files, int threads);
+    void cancel() { m_job.cancel(); }
+    bool isRunning() const { return m_job.isRunning(); }
+
+    // 流式读取整个文件计算内容散列，读取失败或被取消时返回 false
+    static bool hashFile(const QString &path, quint64 &hash, const std::atomic<bool> *cancelled = nullptr);
+
+signals:
+    // groups 按可节省的空间从大到小排列；hashedBytes 为本次实际读取的字节数，不含命中缓存的文件
+    void finished(const QVector<DuplicateGroup> &groups, int scannedFiles, int hashedFiles, qint64 hashedBytes);
+
+private:
+    struct CacheEntry
+    {
+        FileStamp stamp;
+        quint64 hash = 0;
+    };
+
+    bool loadCache();
+    bool saveCache() const;
+
+    BackgroundJob m_job;
+    QString m_cacheFile;
+    // 以下只在后台线程中访问，同一时刻至多一个查找线程
+    bool m_loaded = false;
+    QHash<FileStamp::Key, CacheEntry> m_cache;
+};
+
+#endif // DUPLICATEFINDER_H
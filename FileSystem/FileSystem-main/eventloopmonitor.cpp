@@ -0,0 +1,42 @@
+#include "eventloopmonitor.h"
+#include "counters.h"
+#include "trace.h"
+
+#include <algorithm>
+
+static Histogram s_stalls("event_loop.stall_ms", "事件循环延迟 (ms)", {16, 50, 100, 250, 500, 1000, 2500});
+static Counter s_maxStall("event_loop.max_stall_ms", "最长阻塞", Counter::Milliseconds);
+
+EventLoopMonitor::EventLoopMonitor(QObject *parent)
+    : QObject(parent)
+{
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &EventLoopMonitor::tick);
+}
+
+void EventLoopMonitor::start(int intervalMs)
+{
+    m_timer.start(intervalMs);
+    m_clock.start();
+    m_last = 0;
+    m_interval.store(intervalMs, std::memory_order_relaxed);
+    m_lastBeat.store(Trace::now(), std::memory_order_release);
+}
+
+void EventLoopMonitor::stop()
+{
+    m_timer.stop();
+    m_lastBeat.store(0, std::memory_order_release);
+}
+
+void EventLoopMonitor::tick()
+{
+    const qint64 now = m_clock.elapsed();
+    const qint64 stall = std::max<qint64>(0, now - m_last - m_timer.interval());
+    m_last = now;
+    m_lastBeat.store(Trace::now(), std::memory_order_release);
+    s_stalls.record(stall);
+    if (stall > s_maxStall.value()) {
+        s_maxStall.set(stall);
+    }
+}
@@ -0,0 +1,35 @@
+#ifndef EVENTLOOPMONITOR_H
+#define EVENTLOOPMONITOR_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <atomic>
+
+// 事件循环延迟监测
+// 在所属线程上按固定间隔触发定时器，实际间隔比预期多出的部分就是事件循环被阻塞的时间，
+// 每次都记入直方图 event_loop.stall_ms，最长的一次记入计数器 event_loop.max_stall_ms。
+// 每次触发还更新一次心跳时间，供 StallWatchdog 在其他线程上判断事件循环是否仍被阻塞。
+class EventLoopMonitor : public QObject
+{
+public:
+    explicit EventLoopMonitor(QObject *parent = nullptr);
+
+    void start(int intervalMs = 50);
+    void stop();
+
+    int interval() const { return m_interval.load(std::memory_order_relaxed); }
+    // 最近一次触发的时间，与 Trace::now() 同一时钟（纳秒），未运行时为 0；可在任意线程读取
+    qint64 lastBeat() const { return m_lastBeat.load(std::memory_order_acquire); }
+
+private:
+    void tick();
+
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    qint64 m_last = 0;
+    std::atomic<int> m_interval{0};
+    std::atomic<qint64> m_lastBeat{0};
+};
+
+#endif // EVENTLOOPMONITOR_H
@@ -0,0 +1,271 @@
+#include "fileioqueue.h"
+#include "blobstore.h"
+#include "counters.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <linux/fs.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+static const qint64 CopyChunk = 8 * 1024 * 1024;
+
+static Counter s_queueDepth("io.queue_depth", "磁盘操作队列长度");
+static Counter s_completed("io.completed", "已完成的磁盘操作");
+
+FileIoQueue::FileIoQueue(QObject *parent)
+    : QObject(parent)
+{
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->start();
+}
+
+FileIoQueue::~FileIoQueue()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_wake.wakeAll();
+    }
+    // 退出前执行完已入队的操作，避免丢失删除或创建
+    m_thread->wait();
+    delete m_thread;
+}
+
+quint64 FileIoQueue::create(const QString &path)
+{
+    return enqueue(FileOperation::Create, path, QString());
+}
+
+quint64 FileIoQueue::remove(const QString &path)
+{
+    return enqueue(FileOperation::Remove, path, QString());
+}
+
+quint64 FileIoQueue::rename(const QString &path, const QString &target)
+{
+    return enqueue(FileOperation::Rename, path, target);
+}
+
+quint64 FileIoQueue::copy(const QString &path, const QString &target)
+{
+    return enqueue(FileOperation::Copy, path, target);
+}
+
+quint64 FileIoQueue::store(const QString &path, const QString &root)
+{
+    return enqueue(FileOperation::Store, path, root);
+}
+
+int FileIoQueue::pending() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_queue.size() + m_running;
+}
+
+quint64 FileIoQueue::enqueue(FileOperation::Kind kind, const QString &path, const QString &target)
+{
+    FileOperation op;
+    op.kind = kind;
+    op.path = path;
+    op.target = target;
+
+    QMutexLocker locker(&m_mutex);
+    op.id = m_nextId++;
+    m_queue.append(op);
+    s_queueDepth.set(m_queue.size() + m_running);
+    m_wake.wakeOne();
+    return op.id;
+}
+
+void FileIoQueue::run()
+{
+    for (;;) {
+        QVector<FileOperation> batch;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_queue.isEmpty() && !m_stopping) {
+                m_wake.wait(&m_mutex);
+            }
+            if (m_queue.isEmpty()) return;
+            batch.swap(m_queue);
+            m_running = batch.size();
+        }
+
+        for (FileOperation &op : batch) {
+            execute(op);
+        }
+
+        {
+            QMutexLocker locker(&m_mutex);
+            m_running = 0;
+            s_queueDepth.set(m_queue.size());
+        }
+        s_completed.add(batch.size());
+        QMetaObject::invokeMethod(this, [this, batch]() {
+            emit finished(batch);
+        }, Qt::QueuedConnection);
+    }
+}
+
+void FileIoQueue::execute(FileOperation &op)
+{
+    QFile file(op.path);
+    switch (op.kind) {
+    case FileOperation::Create:
+        // 已存在的文件直接沿用
+        QDir().mkpath(QFileInfo(op.path).path());
+        op.ok = file.exists() || file.open(QIODevice::WriteOnly);
+        break;
+    case FileOperation::Remove:
+        op.ok = !file.exists() || file.remove();
+        break;
+    case FileOperation::Rename:
+        op.ok = file.rename(op.target);
+        break;
+    case FileOperation::Copy:
+        QDir().mkpath(QFileInfo(op.target).path());
+        op.ok = copyFile(op.path, op.target, &op.bytes, &op.error);
+        return;
+    case FileOperation::Store:
+        op.target = BlobStore::store(op.target, op.path, &op.error);
+        op.ok = !op.target.isEmpty();
+        return;
+    }
+    if (!op.ok) {
+        op.error = file.errorString();
+    }
+}
+
+#ifdef Q_OS_LINUX
+static QString errnoString()
+{
+    return QString::fromLocal8Bit(strerror(errno));
+}
+#endif
+
+// 先尝试 reflink 共享数据块（btrfs、xfs 等），不支持时用 copy_file_range 在内核中复制，
+// 跨文件系统或内核不支持时退回分块读写。目标已存在时失败，不覆盖
+bool FileIoQueue::copyFile(const QString &source, const QString &target, qint64 *bytes, QString *error)
+{
+#ifdef Q_OS_LINUX
+    int in = ::open(QFile::encodeName(source).constData(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        *error = errnoString();
+        return false;
+    }
+    struct stat st;
+    if (fstat(in, &st) != 0) {
+        *error = errnoString();
+        ::close(in);
+        return false;
+    }
+    const QByteArray targetName = QFile::encodeName(target);
+    int out = ::open(targetName.constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, st.st_mode & 0777);
+    if (out < 0) {
+        *error = errnoString();
+        ::close(in);
+        return false;
+    }
+
+    bool ok = false;
+    bool buffered = false;
+#ifdef FICLONE
+    if (ioctl(out, FICLONE, in) == 0) {
+        *bytes = st.st_size;
+        m_copiedBytes.fetch_add(st.st_size, std::memory_order_relaxed);
+        ok = true;
+    }
+#endif
+    while (!ok && !buffered) {
+        ssize_t n = copy_file_range(in, nullptr, out, nullptr, CopyChunk, 0);
+        if (n > 0) {
+            *bytes += n;
+            m_copiedBytes.fetch_add(n, std::memory_order_relaxed);
+        } else if (n == 0) {
+            ok = true;
+        } else if (*bytes == 0 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP)) {
+            buffered = true;
+        } else {
+            *error = errnoString();
+            break;
+        }
+    }
+    if (buffered) {
+        QByteArray buffer(1024 * 1024, Qt::Uninitialized);
+        for (;;) {
+            ssize_t n = ::read(in, buffer.data(), buffer.size());
+            if (n == 0) {
+                ok = true;
+                break;
+            }
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                *error = errnoString();
+                break;
+            }
+            ssize_t written = 0;
+            while (written < n) {
+                ssize_t w = ::write(out, buffer.constData() + written, n - written);
+                if (w < 0 && errno == EINTR) continue;
+                if (w <= 0) break;
+                written += w;
+            }
+            if (written < n) {
+                *error = errnoString();
+                break;
+            }
+            *bytes += n;
+            m_copiedBytes.fetch_add(n, std::memory_order_relaxed);
+        }
+    }
+
+    ::close(in);
+    if (::close(out) != 0 && ok) {
+        *error = errnoString();
+        ok = false;
+    }
+    if (!ok) {
+        ::unlink(targetName.constData());
+    }
+    return ok;
+#else
+    QFile in(source);
+    if (!in.open(QIODevice::ReadOnly)) {
+        *error = in.errorString();
+        return false;
+    }
+    if (QFile::exists(target)) {
+        *error = QStringLiteral("Destination file exists");
+        return false;
+    }
+    QFile out(target);
+    if (!out.open(QIODevice::WriteOnly)) {
+        *error = out.errorString();
+        return false;
+    }
+    QByteArray buffer(1024 * 1024, Qt::Uninitialized);
+    for (;;) {
+        qint64 n = in.read(buffer.data(), buffer.size());
+        if (n == 0) break;
+        if (n < 0 || out.write(buffer.constData(), n) != n) {
+            *error = n < 0 ? in.errorString() : out.errorString();
+            out.remove();
+            return false;
+        }
+        *bytes += n;
+        m_copiedBytes.fetch_add(n, std::memory_order_relaxed);
+    }
+    out.setPermissions(in.permissions());
+    return true;
+#endif
+}
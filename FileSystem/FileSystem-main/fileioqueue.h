@@ -0,0 +1,67 @@
+#ifndef FILEIOQUEUE_H
+#define FILEIOQUEUE_H
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+#include <atomic>
+
+// 一次磁盘文件操作，执行后填入结果
+struct FileOperation
+{
+    enum Kind { Create, Remove, Rename, Copy, Store };
+    Kind kind = Create;
+    quint64 id = 0;
+    QString path;
+    QString target;     // 重命名、复制的目标；存入存储时为存储根目录，完成后为内容编号
+    bool ok = false;
+    QString error;
+    qint64 bytes = 0;   // 复制的字节数
+};
+
+// 后台文件操作队列
+// 创建、删除、重命名绑定文件都在后台线程中执行，主线程只负责入队，
+// 后台线程每次取走队列中的全部操作批量执行，结果按批在主线程上通过 finished 发出。
+class FileIoQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FileIoQueue(QObject *parent = nullptr);
+    ~FileIoQueue();
+
+    // 入队并返回操作编号，结果中以此编号对应
+    quint64 create(const QString &path);
+    quint64 remove(const QString &path);
+    quint64 rename(const QString &path, const QString &target);
+    quint64 copy(const QString &path, const QString &target);
+    // 把 path 存入 root 下的内容寻址存储，见 BlobStore::store
+    quint64 store(const QString &path, const QString &root);
+
+    // 尚未执行完的操作数
+    int pending() const;
+    // 累计复制的字节数，复制过程中也会增长，用于计算吞吐量
+    qint64 copiedBytes() const { return m_copiedBytes.load(std::memory_order_relaxed); }
+
+signals:
+    void finished(const QVector<FileOperation> &results);
+
+private:
+    quint64 enqueue(FileOperation::Kind kind, const QString &path, const QString &target);
+    void run();
+    void execute(FileOperation &op);
+    bool copyFile(const QString &source, const QString &target, qint64 *bytes, QString *error);
+
+    QThread *m_thread = nullptr;
+    mutable QMutex m_mutex;
+    QWaitCondition m_wake;
+    QVector<FileOperation> m_queue;
+    int m_running = 0;
+    quint64 m_nextId = 1;
+    bool m_stopping = false;
+    std::atomic<qint64> m_copiedBytes{0};
+};
+
+#endif // FILEIOQUEUE_H
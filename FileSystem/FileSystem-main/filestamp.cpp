@@ -0,0 +1,34 @@
+#include "filestamp.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+bool FileStamp::read(const QString &path, FileStamp &stamp)
+{
+#ifdef Q_OS_UNIX
+    struct stat st;
+    if (::stat(QFile::encodeName(path).constData(), &st) != 0 || !S_ISREG(st.st_mode)) return false;
+    stamp.key.device = quint64(st.st_dev);
+    stamp.key.inode = quint64(st.st_ino);
+#if defined(Q_OS_DARWIN)
+    stamp.modified = qint64(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    stamp.modified = qint64(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    stamp.size = st.st_size;
+#else
+    // 取不到 inode 的平台以规范路径的散列代替
+    QFileInfo info(path);
+    if (!info.isFile()) return false;
+    stamp.key.device = 0;
+    stamp.key.inode = qHash(info.canonicalFilePath());
+    stamp.modified = info.lastModified().toMSecsSinceEpoch() * 1000000;
+    stamp.size = info.size();
+#endif
+    return true;
+}
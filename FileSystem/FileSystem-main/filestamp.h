@@ -0,0 +1,29 @@
+#ifndef FILESTAMP_H
+#define FILESTAMP_H
+
+#include <QString>
+#include <QHashFunctions>
+
+// 文件的身份和版本：(设备, inode) 标识文件本身，修改时间和大小用于判断内容是否变化
+// 按内容计算的结果（类型、散列）以 key() 为键缓存，硬链接和重命名后的文件都能命中缓存。
+struct FileStamp
+{
+    struct Key
+    {
+        quint64 device = 0;
+        quint64 inode = 0;
+        bool operator==(const Key &other) const { return device == other.device && inode == other.inode; }
+        friend size_t qHash(const Key &key, size_t seed = 0) { return qHashMulti(seed, key.device, key.inode); }
+    };
+
+    Key key;
+    qint64 modified = 0;    // 纳秒
+    qint64 size = 0;
+
+    bool sameVersion(const FileStamp &other) const { return modified == other.modified && size == other.size; }
+
+    // 读取普通文件的身份和版本，不存在或不是普通文件时返回 false
+    static bool read(const QString &path, FileStamp &stamp);
+};
+
+#endif // FILESTAMP_H
@@ -0,0 +1,172 @@
+#include "filetypes.h"
+
+#include <QIODevice>
+#include <QStringDecoder>
+#include <QtEndian>
+#include <cstring>
+
+FileTypeInfo fileTypeForSuffix(const QString &suffix)
+{
+    QString lowerSuffix = suffix.toLower();
+
+    if (lowerSuffix == "txt") {
+        return {"txt文件", "treeItem_txt"};
+    } else if (lowerSuffix == "pdf") {
+        return {"pdf文件", "treeItem_pdf"};
+    } else if (lowerSuffix == "png") {
+        return {"png文件", "treeItem_png"};
+    } else if (lowerSuffix == "doc") {
+        return {"doc文档", "treeItem_doc"};
+    } else if (lowerSuffix == "gif") {
+        return {"gif文件", "treeItem_gif"};
+    } else if (lowerSuffix == "ppt") {
+        return {"ppt文档", "treeItem_ppt"};
+    } else if (lowerSuffix == "xls") {
+        return {"xls文档", "treeItem_xls"};
+    } else if (lowerSuffix == "zip") {
+        return {"zip文件", "treeItem_zip"};
+    } else if (lowerSuffix == "jpg" || lowerSuffix == "jpeg") {
+        return {"jpg文件", "treeItem_png"};
+    } else if (lowerSuffix == "gz" || lowerSuffix == "tgz" || lowerSuffix == "bz2" || lowerSuffix == "xz"
+               || lowerSuffix == "7z" || lowerSuffix == "rar") {
+        return {"压缩文件", "treeItem_zip"};
+    }
+    return {"未知文件", "treeItem_Unknownfile"};
+}
+
+FileTypeInfo fileTypeForContent(const QByteArray &head, const QString &suffix)
+{
+    const QString lowerSuffix = suffix.toLower();
+    auto startsWith = [&head](const char *magic, int length) {
+        return head.size() >= length && std::memcmp(head.constData(), magic, length) == 0;
+    };
+
+    if (startsWith("%PDF-", 5)) {
+        return {"pdf文件", "treeItem_pdf"};
+    }
+    if (startsWith("\x89PNG\r\n\x1a\n", 8)) {
+        return {"png文件", "treeItem_png"};
+    }
+    if (startsWith("GIF87a", 6) || startsWith("GIF89a", 6)) {
+        return {"gif文件", "treeItem_gif"};
+    }
+    if (startsWith("\xFF\xD8\xFF", 3)) {
+        return {"jpg文件", "treeItem_png"};
+    }
+    if (startsWith("PK\x03\x04", 4)) {
+        // Office 2007 以后的文档也是 zip。只有开头时按其中出现的目录名粗略区分，
+        // zip 内条目的顺序不固定，能读到整个文件时由 fileTypeForFile 按中央目录判断
+        if (head.contains("word/")) return {"doc文档", "treeItem_doc"};
+        if (head.contains("ppt/")) return {"ppt文档", "treeItem_ppt"};
+        if (head.contains("xl/")) return {"xls文档", "treeItem_xls"};
+        return {"zip文件", "treeItem_zip"};
+    }
+    if (startsWith("\xD0\xCF\x11\xE0\xA1\xB1\x1A\xE1", 8)) {
+        // 旧版 Office 复合文档，三种格式的头部相同，后缀是其中之一时沿用后缀
+        if (lowerSuffix == "ppt") return {"ppt文档", "treeItem_ppt"};
+        if (lowerSuffix == "xls") return {"xls文档", "treeItem_xls"};
+        return {"doc文档", "treeItem_doc"};
+    }
+    if (startsWith("\x1f\x8b", 2) || startsWith("BZh", 3) || startsWith("\xFD" "7zXZ\x00", 6)
+        || startsWith("7z\xBC\xAF\x27\x1C", 6) || startsWith("Rar!\x1A\x07", 6)) {
+        return {"压缩文件", "treeItem_zip"};
+    }
+    if (!head.isEmpty() && !head.contains('\0')) {
+        // 没有 '\0' 且是合法 UTF-8 的视为文本；末尾被截断的多字节字符不算错误
+        qsizetype end = head.size();
+        for (qsizetype i = end - 1; i >= 0 && i >= head.size() - 4; --i) {
+            const uchar c = uchar(head[i]);
+            if (c < 0x80) break;
+            if (c >= 0xC0) {
+                end = i;
+                break;
+            }
+        }
+        QStringDecoder decoder(QStringDecoder::Utf8, QStringDecoder::Flag::Stateless);
+        const QString text = decoder(QByteArrayView(head).left(end));
+        if (!decoder.hasError() && !text.isEmpty()) {
+            return {"txt文件", "treeItem_txt"};
+        }
+    }
+    return {};
+}
+
+// 按 zip 中央目录中的条目名区分 Office 文档：有 [Content_Types].xml 且有 word/、ppt/、xl/ 目录的才算。
+// 找不到目录结束记录、中央目录无效或是 zip64 时返回 false
+static bool zipDocumentType(QIODevice &device, FileTypeInfo &info)
+{
+    static const int EndRecordSize = 22;
+    static const int EntryHeaderSize = 46;
+    static const qint64 MaxDirectorySize = 4 * 1024 * 1024;
+
+    const qint64 size = device.size();
+    if (size < EndRecordSize) return false;
+
+    // 目录结束记录在文件末尾，其后最多跟 65535 字节的注释；从后往前找第一个长度自洽的记录
+    const qint64 tailSize = qMin<qint64>(size, EndRecordSize + 0xFFFF);
+    if (!device.seek(size - tailSize)) return false;
+    const QByteArray tail = device.read(tailSize);
+    const QByteArrayView endSignature("PK\x05\x06", 4);
+    qsizetype end = -1;
+    for (qsizetype pos = tail.lastIndexOf(endSignature); pos >= 0;
+         pos = pos > 0 ? tail.lastIndexOf(endSignature, pos - 1) : -1) {
+        if (pos + EndRecordSize > tail.size()) continue;
+        const quint16 commentLength = qFromLittleEndian<quint16>(tail.constData() + pos + 20);
+        if (pos + EndRecordSize + commentLength <= tail.size()) {
+            end = pos;
+            break;
+        }
+    }
+    if (end < 0) return false;
+
+    const uchar *record = reinterpret_cast<const uchar*>(tail.constData() + end);
+    const quint32 directorySize = qFromLittleEndian<quint32>(record + 12);
+    const quint32 directoryOffset = qFromLittleEndian<quint32>(record + 16);
+    if (directoryOffset == 0xFFFFFFFFu || directorySize == 0xFFFFFFFFu) return false;
+
+    // 中央目录紧挨在结束记录之前；按实际位置读取，前面拼接了其他数据的 zip 同样适用
+    const qint64 endOffset = size - tailSize + end;
+    const qint64 directoryStart = endOffset - qint64(directorySize);
+    if (directoryStart < 0 || !device.seek(directoryStart)) return false;
+    const QByteArray directory = device.read(qMin<qint64>(directorySize, MaxDirectorySize));
+
+    bool contentTypes = false;
+    FileTypeInfo office;
+    for (qsizetype pos = 0; pos + EntryHeaderSize <= directory.size();) {
+        const char *entry = directory.constData() + pos;
+        if (std::memcmp(entry, "PK\x01\x02", 4) != 0) {
+            if (pos == 0) return false;
+            break;
+        }
+        const quint16 nameLength = qFromLittleEndian<quint16>(entry + 28);
+        const quint16 extraLength = qFromLittleEndian<quint16>(entry + 30);
+        const quint16 commentLength = qFromLittleEndian<quint16>(entry + 32);
+        const QByteArray name = directory.mid(pos + EntryHeaderSize, nameLength);
+
+        if (name == "[Content_Types].xml") {
+            contentTypes = true;
+        } else if (office.type.isEmpty()) {
+            if (name.startsWith("word/")) office = {"doc文档", "treeItem_doc"};
+            else if (name.startsWith("ppt/")) office = {"ppt文档", "treeItem_ppt"};
+            else if (name.startsWith("xl/")) office = {"xls文档", "treeItem_xls"};
+        }
+        if (contentTypes && !office.type.isEmpty()) break;
+        pos += EntryHeaderSize + nameLength + extraLength + commentLength;
+    }
+
+    info = (contentTypes && !office.type.isEmpty()) ? office : FileTypeInfo{"zip文件", "treeItem_zip"};
+    return true;
+}
+
+FileTypeInfo fileTypeForFile(QIODevice &device, const QString &suffix, int headSize)
+{
+    const QByteArray head = device.read(headSize);
+    FileTypeInfo info = fileTypeForContent(head, suffix);
+    if (head.startsWith("PK\x03\x04") && !device.isSequential()) {
+        FileTypeInfo fromDirectory;
+        if (zipDocumentType(device, fromDirectory)) {
+            info = fromDirectory;
+        }
+    }
+    return info;
+}
@@ -0,0 +1,25 @@
+#ifndef FILETYPES_H
+#define FILETYPES_H
+
+#include <QString>
+#include <QByteArray>
+
+class QIODevice;
+
+// 文件类型显示名和图标键
+struct FileTypeInfo
+{
+    QString type;
+    QString iconKey;
+};
+
+// 按后缀识别文件类型，未知后缀返回“未知文件”
+FileTypeInfo fileTypeForSuffix(const QString &suffix);
+
+// 按文件开头的特征字节识别文件类型，suffix 用于区分同一容器格式的文档；无法判断时 type 为空
+FileTypeInfo fileTypeForContent(const QByteArray &head, const QString &suffix);
+
+// 读取文件开头 headSize 字节识别类型；zip 文件再读取末尾的中央目录，按包内条目区分 Office 文档
+FileTypeInfo fileTypeForFile(QIODevice &device, const QString &suffix, int headSize = 4096);
+
+#endif // FILETYPES_H
@@ -0,0 +1,265 @@
+#include "folderstats.h"
+#include "treewalker.h"
+
+#include <QFileInfo>
+
+FolderStats::FolderStats(QObject *parent)
+    : QObject(parent), m_job(this)
+{
+    // 一批 stat 结束后接着处理期间排队的文件
+    m_job.setIdleHandler([this]() { startStat(); });
+    // 同一轮事件中的多次变化合并为一次显示刷新
+    m_refreshTimer.setSingleShot(true);
+    m_refreshTimer.setInterval(0);
+    connect(&m_refreshTimer, &QTimer::timeout, this, &FolderStats::refresh);
+}
+
+FolderStats::~FolderStats()
+{
+    m_job.cancel();
+}
+
+void FolderStats::setModel(QStandardItemModel *model, int threads)
+{
+    if (m_model) {
+        disconnect(m_model, nullptr, this, nullptr);
+    }
+    m_model = model;
+    m_threads = threads;
+    reset();
+    if (!model) return;
+
+    connect(model, &QAbstractItemModel::rowsInserted, this, &FolderStats::rowsInserted);
+    connect(model, &QAbstractItemModel::rowsAboutToBeRemoved, this, &FolderStats::rowsAboutToBeRemoved);
+    connect(model, &QAbstractItemModel::dataChanged, this, &FolderStats::pathChanged);
+    connect(model, &QAbstractItemModel::modelReset, this, &FolderStats::reset);
+}
+
+FolderStats::Totals FolderStats::totals(QStandardItem *item) const
+{
+    if (isFile(item)) {
+        return Totals{item->data(SizeRole).toLongLong(), 1};
+    }
+    return m_totals.value(item);
+}
+
+void FolderStats::refresh(QStandardItem *item)
+{
+    if (!item || !isFile(item) || item->data(Qt::UserRole + 2).toString().isEmpty()) return;
+    m_queued.append(QPersistentModelIndex(item->index()));
+    startStat();
+}
+
+bool FolderStats::isFile(QStandardItem *item)
+{
+    QString type = item->data(Qt::UserRole + 1).toString();
+    return type != "文件夹" && type != "驱动器" && type != "system";
+}
+
+QString FolderStats::formatSize(qint64 bytes)
+{
+    if (bytes < 1024) return QString("%1 B").arg(bytes);
+    static const char *units[] = {"KB", "MB", "GB", "TB"};
+    double value = bytes / 1024.0;
+    int unit = 0;
+    while (value >= 1024.0 && unit < 3) {
+        value /= 1024.0;
+        ++unit;
+    }
+    return QString("%1 %2").arg(value, 0, 'f', 1).arg(units[unit]);
+}
+
+FolderStats::Totals FolderStats::addSubtree(QStandardItem *item)
+{
+    if (isFile(item)) {
+        requestSize(item);
+        return totals(item);
+    }
+    Totals sum;
+    for (int i = 0; i < item->rowCount(); ++i) {
+        Totals child = addSubtree(item->child(i, 0));
+        sum.bytes += child.bytes;
+        sum.files += child.files;
+    }
+    m_totals.insert(item, sum);
+    scheduleRefresh(item);
+    return sum;
+}
+
+void FolderStats::removeSubtree(QStandardItem *item)
+{
+    if (isFile(item)) return;
+    for (int i = 0; i < item->rowCount(); ++i) {
+        removeSubtree(item->child(i, 0));
+    }
+    m_totals.remove(item);
+    m_dirty.remove(item);
+}
+
+void FolderStats::addToAncestors(QStandardItem *parent, qint64 bytes, qint64 files)
+{
+    if (bytes == 0 && files == 0) return;
+    // 顶层节点的 parent() 为空，不经过不可见根节点
+    for (QStandardItem *p = parent; p && p != m_model->invisibleRootItem(); p = p->parent()) {
+        Totals &t = m_totals[p];
+        t.bytes += bytes;
+        t.files += files;
+        scheduleRefresh(p);
+    }
+}
+
+QStandardItem *FolderStats::parentItem(const QModelIndex &parent) const
+{
+    return parent.isValid() ? m_model->itemFromIndex(parent) : m_model->invisibleRootItem();
+}
+
+void FolderStats::rowsInserted(const QModelIndex &parent, int first, int last)
+{
+    if (parent.isValid() && parent.column() != 0) return;
+    QStandardItem *parentNode = parentItem(parent);
+    Totals sum;
+    for (int row = first; row <= last; ++row) {
+        QStandardItem *item = parentNode->child(row, 0);
+        if (!item) continue;
+        Totals t = addSubtree(item);
+        sum.bytes += t.bytes;
+        sum.files += t.files;
+    }
+    addToAncestors(parentNode, sum.bytes, sum.files);
+    startStat();
+}
+
+void FolderStats::rowsAboutToBeRemoved(const QModelIndex &parent, int first, int last)
+{
+    if (parent.isValid() && parent.column() != 0) return;
+    QStandardItem *parentNode = parentItem(parent);
+    Totals sum;
+    for (int row = first; row <= last; ++row) {
+        QStandardItem *item = parentNode->child(row, 0);
+        if (!item) continue;
+        Totals t = totals(item);
+        sum.bytes += t.bytes;
+        sum.files += t.files;
+        removeSubtree(item);
+    }
+    addToAncestors(parentNode, -sum.bytes, -sum.files);
+}
+
+void FolderStats::pathChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles)
+{
+    // 只关心文件绑定路径的变化
+    if (topLeft.column() != 0) return;
+    if (!roles.isEmpty() && !roles.contains(Qt::UserRole + 2)) return;
+    for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+        QStandardItem *item = m_model->itemFromIndex(topLeft.sibling(row, 0));
+        if (!item || !isFile(item)) continue;
+        if (item->data(Qt::UserRole + 2).toString().isEmpty()) {
+            setFileSize(item, 0);
+        } else {
+            m_queued.append(QPersistentModelIndex(item->index()));
+        }
+    }
+    startStat();
+}
+
+void FolderStats::reset()
+{
+    // 不等待正在进行的 stat，其结果到达时丢弃
+    m_job.discard();
+    m_totals.clear();
+    m_dirty.clear();
+    m_queued.clear();
+    m_inFlight.clear();
+    if (!m_model) return;
+
+    QStandardItem *root = m_model->invisibleRootItem();
+    for (int i = 0; i < root->rowCount(); ++i) {
+        addSubtree(root->child(i, 0));
+    }
+    startStat();
+}
+
+void FolderStats::requestSize(QStandardItem *item)
+{
+    // 复制出的节点已带有大小，不再 stat
+    if (item->data(SizeRole).isValid()) return;
+    if (item->data(Qt::UserRole + 2).toString().isEmpty()) return;
+    m_queued.append(QPersistentModelIndex(item->index()));
+}
+
+void FolderStats::startStat()
+{
+    if (m_job.isRunning() || m_queued.isEmpty()) return;
+
+    m_inFlight.swap(m_queued);
+    m_queued.clear();
+    std::vector<QString> paths;
+    paths.reserve(m_inFlight.size());
+    for (const QPersistentModelIndex &index : m_inFlight) {
+        paths.push_back(index.data(Qt::UserRole + 2).toString());
+    }
+
+    const int threads = m_threads;
+    m_job.start([this, paths, threads]() -> BackgroundJob::Done {
+        TreeWalker walker(threads);
+        const std::vector<qint64> sizes = walker.map(paths, [](const QString &path) {
+            return QFileInfo(path).size();
+        });
+        QVector<qint64> result(sizes.begin(), sizes.end());
+        return [this, result]() { applySizes(result); };
+    });
+}
+
+void FolderStats::applySizes(const QVector<qint64> &sizes)
+{
+    const QVector<QPersistentModelIndex> files = std::move(m_inFlight);
+    m_inFlight.clear();
+    for (int i = 0; i < files.size() && i < sizes.size(); ++i) {
+        if (QStandardItem *item = m_model->itemFromIndex(files[i])) {
+            setFileSize(item, sizes[i]);
+        }
+    }
+}
+
+void FolderStats::setFileSize(QStandardItem *item, qint64 size)
+{
+    const QVariant old = item->data(SizeRole);
+    if (old.isValid() && old.toLongLong() == size) return;
+    item->setData(size, SizeRole);
+    addToAncestors(item->parent(), size - old.toLongLong(), 0);
+}
+
+void FolderStats::scheduleRefresh(QStandardItem *item)
+{
+    m_dirty.insert(item);
+    if (!m_refreshTimer.isActive()) {
+        m_refreshTimer.start();
+    }
+}
+
+void FolderStats::refresh()
+{
+    const QSet<QStandardItem*> dirty = std::move(m_dirty);
+    m_dirty.clear();
+    for (QStandardItem *item : dirty) {
+        QStandardItem *parent = item->parent() ? item->parent() : m_model->invisibleRootItem();
+        const int row = item->row();
+        const Totals t = m_totals.value(item);
+        setCellText(parent, row, SizeColumn, formatSize(t.bytes));
+        setCellText(parent, row, CountColumn, QString::number(t.files));
+    }
+}
+
+void FolderStats::setCellText(QStandardItem *parent, int row, int column, const QString &text)
+{
+    QStandardItem *cell = parent->child(row, column);
+    if (!cell) {
+        cell = new QStandardItem;
+        cell->setEditable(false);
+        cell->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        parent->setChild(row, column, cell);
+    }
+    if (cell->text() != text) {
+        cell->setText(text);
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef FOLDERSTATS_H
+#define FOLDERSTATS_H
+
+#include <QObject>
+#include <QStandardItemModel>
+#include <QPersistentModelIndex>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+#include <QVector>
+
+#include "backgroundjob.h"
+
+// 文件夹汇总：每个文件夹下（递归）的文件数和总字节数
+// 文件大小在后台批量 stat 后记在文件节点的 SizeRole 上，随节点一起复制；文件夹的汇总值保存在表中，
+// 插入、删除或文件大小变化时只沿祖先链加减差值，不重新遍历整棵树。汇总值显示在 大小、文件数 两列。
+class FolderStats : public QObject
+{
+public:
+    enum { SizeRole = Qt::UserRole + 4 };
+    enum { SizeColumn = 2, CountColumn = 3 };
+
+    struct Totals
+    {
+        qint64 bytes = 0;
+        qint64 files = 0;
+    };
+
+    explicit FolderStats(QObject *parent = nullptr);
+    ~FolderStats();
+
+    void setModel(QStandardItemModel *model, int threads);
+
+    // 文件返回自身大小，文件夹返回汇总值
+    Totals totals(QStandardItem *item) const;
+    // 文件内容在磁盘上被修改后重新 stat
+    void refresh(QStandardItem *item);
+
+    static bool isFile(QStandardItem *item);
+    static QString formatSize(qint64 bytes);
+    // 设置 parent 第 row 行第 column 列的文字，单元格不存在时创建
+    static void setCellText(QStandardItem *parent, int row, int column, const QString &text);
+
+private:
+    Totals addSubtree(QStandardItem *item);
+    void removeSubtree(QStandardItem *item);
+    void addToAncestors(QStandardItem *parent, qint64 bytes, qint64 files);
+    void rowsInserted(const QModelIndex &parent, int first, int last);
+    void rowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void pathChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles);
+    void reset();
+    void requestSize(QStandardItem *item);
+    void startStat();
+    void applySizes(const QVector<qint64> &sizes);
+    void setFileSize(QStandardItem *item, qint64 size);
+    void scheduleRefresh(QStandardItem *item);
+    void refresh();
+    QStandardItem *parentItem(const QModelIndex &parent) const;
+
+    QStandardItemModel *m_model = nullptr;
+    int m_threads = 0;
+    QHash<QStandardItem*, Totals> m_totals;         // 非文件节点的汇总值
+    QSet<QStandardItem*> m_dirty;                   // 汇总值变化、等待刷新显示的节点
+    QTimer m_refreshTimer;
+
+    QVector<QPersistentModelIndex> m_queued;        // 等待 stat 的文件
+    QVector<QPersistentModelIndex> m_inFlight;      // 后台正在 stat 的文件
+    BackgroundJob m_job;
+};
+
+#endif // FOLDERSTATS_H
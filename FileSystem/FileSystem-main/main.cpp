@@ -1,4 +1,5 @@
 #include "widget.h"
+#include "trace.h"
 
 #include <QApplication>
 #include <QLocale>
@@ -18,8 +19,19 @@ int main(int argc, char *argv[])
             break;
         }
     }
-    Widget w;
-    w.setWindowTitle("文件系统");
-    w.show();
-    return a.exec();
+
+    // FILESYS_TRACE=文件名 时记录跟踪，退出时（包括析构时的保存）写出
+    const QString traceFile = qEnvironmentVariable("FILESYS_TRACE");
+    Trace::setEnabled(!traceFile.isEmpty());
+    int code = 0;
+    {
+        Widget w;
+        w.setWindowTitle("文件系统");
+        w.show();
+        code = a.exec();
+    }
+    if (!traceFile.isEmpty()) {
+        Trace::writeChromeJson(traceFile);
+    }
+    return code;
 }
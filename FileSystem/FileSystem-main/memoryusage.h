@@ -0,0 +1,46 @@
+#ifndef MEMORYUSAGE_H
+#define MEMORYUSAGE_H
+
+#include <QString>
+
+// 一棵子树的内存占用，按类别分开统计
+// 数值是按数据结构推算的估计值：共享的字符串和图标按各自引用计入，不扣除共享部分。
+struct MemoryUsage
+{
+    qint64 nodes = 0;           // 节点数
+    qint64 nodeBytes = 0;       // 节点对象本身、子节点表和数据项的开销
+    qint64 stringBytes = 0;     // 名称、类型等文字
+    qint64 iconBytes = 0;       // 图标键或图标句柄
+    qint64 pathBytes = 0;       // 绑定的真实路径和内容编号
+
+    qint64 total() const { return nodeBytes + stringBytes + iconBytes + pathBytes; }
+
+    MemoryUsage &operator+=(const MemoryUsage &other)
+    {
+        nodes += other.nodes;
+        nodeBytes += other.nodeBytes;
+        stringBytes += other.stringBytes;
+        iconBytes += other.iconBytes;
+        pathBytes += other.pathBytes;
+        return *this;
+    }
+    MemoryUsage operator-() const
+    {
+        return MemoryUsage{-nodes, -nodeBytes, -stringBytes, -iconBytes, -pathBytes};
+    }
+    MemoryUsage operator-(const MemoryUsage &other) const
+    {
+        MemoryUsage result = *this;
+        result += -other;
+        return result;
+    }
+    bool isZero() const { return nodes == 0 && nodeBytes == 0 && stringBytes == 0 && iconBytes == 0 && pathBytes == 0; }
+
+    // 字符串数据块：头部、分配器开销和按容量计的 UTF-16 内容，空串不占数据块
+    static qint64 sizeOfString(const QString &text)
+    {
+        return text.isNull() ? 0 : 32 + (text.capacity() + 1) * qint64(sizeof(QChar));
+    }
+};
+
+#endif // MEMORYUSAGE_H
@@ -0,0 +1,252 @@
+#include "metadatacolumns.h"
+#include "folderstats.h"
+#include "trace.h"
+#include "treewalker.h"
+
+#include <QAbstractProxyModel>
+#include <QEvent>
+#include <QFileInfo>
+#include <QScrollBar>
+
+MetadataColumns::MetadataColumns(QObject *parent)
+    : QObject(parent), m_job(this)
+{
+    m_job.setIdleHandler([this]() { startStat(); });
+    // 连续滚动时只在停下后扫描一次
+    m_scanTimer.setSingleShot(true);
+    m_scanTimer.setInterval(50);
+    connect(&m_scanTimer, &QTimer::timeout, this, &MetadataColumns::scanVisible);
+}
+
+MetadataColumns::~MetadataColumns()
+{
+    m_job.cancel();
+}
+
+void MetadataColumns::setView(QTreeView *view, QStandardItemModel *model, int threads)
+{
+    if (m_view) {
+        disconnect(m_view, nullptr, this, nullptr);
+        disconnect(m_view->verticalScrollBar(), nullptr, this, nullptr);
+        if (m_view->model()) {
+            disconnect(m_view->model(), nullptr, this, nullptr);
+        }
+        m_view->viewport()->removeEventFilter(this);
+    }
+    if (m_model) {
+        disconnect(m_model, nullptr, this, nullptr);
+    }
+    m_view = view;
+    m_model = model;
+    m_threads = threads;
+    reset();
+    if (!m_view || !m_model) return;
+
+    connect(m_view->verticalScrollBar(), &QScrollBar::valueChanged, this, &MetadataColumns::scheduleScan);
+    connect(m_view, &QTreeView::expanded, this, &MetadataColumns::scheduleScan);
+    if (m_view->model() != m_model) {
+        // 排序后可见的行变了
+        connect(m_view->model(), &QAbstractItemModel::layoutChanged, this, &MetadataColumns::scheduleScan);
+    }
+    m_view->viewport()->installEventFilter(this);
+
+    connect(m_model, &QAbstractItemModel::rowsInserted, this, &MetadataColumns::scheduleScan);
+    connect(m_model, &QAbstractItemModel::rowsAboutToBeRemoved, this, &MetadataColumns::rowsAboutToBeRemoved);
+    connect(m_model, &QAbstractItemModel::dataChanged, this, &MetadataColumns::pathChanged);
+    connect(m_model, &QAbstractItemModel::modelReset, this, &MetadataColumns::reset);
+    scheduleScan();
+}
+
+QString MetadataColumns::formatPermissions(QFileDevice::Permissions permissions)
+{
+    static const QFileDevice::Permission bits[] = {
+        QFileDevice::ReadOwner, QFileDevice::WriteOwner, QFileDevice::ExeOwner,
+        QFileDevice::ReadGroup, QFileDevice::WriteGroup, QFileDevice::ExeGroup,
+        QFileDevice::ReadOther, QFileDevice::WriteOther, QFileDevice::ExeOther};
+    static const char letters[] = "rwx";
+    QString text(9, '-');
+    for (int i = 0; i < 9; ++i) {
+        if (permissions & bits[i]) {
+            text[i] = QLatin1Char(letters[i % 3]);
+        }
+    }
+    return text;
+}
+
+bool MetadataColumns::eventFilter(QObject *watched, QEvent *event)
+{
+    if (event->type() == QEvent::Resize) {
+        scheduleScan();
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+void MetadataColumns::scheduleScan()
+{
+    if (!m_scanTimer.isActive()) {
+        m_scanTimer.start();
+    }
+}
+
+void MetadataColumns::scanVisible()
+{
+    TRACE_SCOPE("metadata.scan_visible");
+    if (!m_view || !m_model) return;
+
+    // 从视口顶部逐行向下，直到超出视口底部
+    const int bottom = m_view->viewport()->height();
+    for (QModelIndex index = m_view->indexAt(QPoint(0, 0)); index.isValid(); index = m_view->indexBelow(index)) {
+        if (m_view->visualRect(index).top() > bottom) break;
+        QModelIndex source = index.sibling(index.row(), 0);
+        if (QAbstractProxyModel *proxy = qobject_cast<QAbstractProxyModel*>(m_view->model())) {
+            source = proxy->mapToSource(source);
+        }
+        QStandardItem *item = m_model->itemFromIndex(source);
+        if (!item || m_cache.contains(item) || m_requested.contains(item)) continue;
+        if (item->data(Qt::UserRole + 2).toString().isEmpty()) continue;
+        m_requested.insert(item);
+        m_queued.append(QPersistentModelIndex(item->index()));
+    }
+    startStat();
+}
+
+const FileMetadata *MetadataColumns::cached(QStandardItem *item) const
+{
+    auto it = m_cache.constFind(item);
+    return it == m_cache.constEnd() ? nullptr : &it.value();
+}
+
+void MetadataColumns::request(const std::vector<QStandardItem*> &items)
+{
+    for (QStandardItem *item : items) {
+        if (m_cache.contains(item) || m_requested.contains(item)) continue;
+        if (item->data(Qt::UserRole + 2).toString().isEmpty()) continue;
+        m_requested.insert(item);
+        m_queued.append(QPersistentModelIndex(item->index()));
+    }
+    startStat();
+}
+
+void MetadataColumns::startStat()
+{
+    if (m_job.isRunning() || m_queued.isEmpty()) return;
+
+    m_inFlight.swap(m_queued);
+    m_queued.clear();
+    std::vector<QString> paths;
+    paths.reserve(m_inFlight.size());
+    for (const QPersistentModelIndex &index : m_inFlight) {
+        paths.push_back(index.data(Qt::UserRole + 2).toString());
+    }
+
+    const int threads = m_threads;
+    m_job.start([this, paths, threads]() -> BackgroundJob::Done {
+        TreeWalker walker(threads);
+        const std::vector<FileMetadata> found = walker.map(paths, [](const QString &path) {
+            QFileInfo info(path);
+            FileMetadata meta;
+            meta.exists = info.exists();
+            if (meta.exists) {
+                meta.size = info.size();
+                meta.modified = info.lastModified();
+                meta.permissions = info.permissions();
+            }
+            return meta;
+        });
+        QVector<FileMetadata> results(found.begin(), found.end());
+        return [this, results, paths]() {
+            // 后台 stat 期间路径又变了的节点不缓存，下次扫描重新获取
+            for (int i = 0; i < m_inFlight.size(); ++i) {
+                if (m_inFlight[i].data(Qt::UserRole + 2).toString() != paths[i]) {
+                    m_inFlight[i] = QPersistentModelIndex();
+                }
+            }
+            applyMetadata(results);
+        };
+    });
+}
+
+void MetadataColumns::applyMetadata(const QVector<FileMetadata> &results)
+{
+    const QVector<QPersistentModelIndex> items = std::move(m_inFlight);
+    m_inFlight.clear();
+    QVector<QStandardItem*> updated;
+    updated.reserve(items.size());
+    for (int i = 0; i < items.size() && i < results.size(); ++i) {
+        QStandardItem *item = m_model->itemFromIndex(items[i]);
+        if (!item || !m_requested.remove(item)) continue;
+        m_cache.insert(item, results[i]);
+        showMetadata(item, results[i]);
+        updated.append(item);
+    }
+    if (m_updateHandler && !updated.isEmpty()) {
+        m_updateHandler(updated);
+    }
+}
+
+void MetadataColumns::showMetadata(QStandardItem *item, const FileMetadata &meta)
+{
+    QStandardItem *parent = item->parent() ? item->parent() : m_model->invisibleRootItem();
+    const int row = item->row();
+    // 文件夹的大小列显示汇总值，由 FolderStats 维护
+    if (FolderStats::isFile(item)) {
+        FolderStats::setCellText(parent, row, FolderStats::SizeColumn,
+                                 meta.exists ? FolderStats::formatSize(meta.size) : QString());
+    }
+    FolderStats::setCellText(parent, row, ModifiedColumn,
+                             meta.exists ? meta.modified.toString("yyyy-MM-dd hh:mm") : QString("文件不存在"));
+    FolderStats::setCellText(parent, row, PermissionsColumn,
+                             meta.exists ? formatPermissions(meta.permissions) : QString());
+}
+
+void MetadataColumns::refresh(QStandardItem *item)
+{
+    if (!item) return;
+    m_cache.remove(item);
+    m_requested.remove(item);
+    scheduleScan();
+}
+
+void MetadataColumns::forget(QStandardItem *item)
+{
+    m_cache.remove(item);
+    m_requested.remove(item);
+    for (int i = 0; i < item->rowCount(); ++i) {
+        forget(item->child(i, 0));
+    }
+}
+
+void MetadataColumns::rowsAboutToBeRemoved(const QModelIndex &parent, int first, int last)
+{
+    if (m_cache.isEmpty() && m_requested.isEmpty()) return;
+    if (parent.isValid() && parent.column() != 0) return;
+    QStandardItem *parentNode = parent.isValid() ? m_model->itemFromIndex(parent) : m_model->invisibleRootItem();
+    for (int row = first; row <= last; ++row) {
+        if (QStandardItem *item = parentNode->child(row, 0)) {
+            forget(item);
+        }
+    }
+}
+
+void MetadataColumns::pathChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles)
+{
+    if (topLeft.column() != 0) return;
+    if (!roles.isEmpty() && !roles.contains(Qt::UserRole + 2)) return;
+    for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+        QStandardItem *item = m_model->itemFromIndex(topLeft.sibling(row, 0));
+        if (!item) continue;
+        m_cache.remove(item);
+        m_requested.remove(item);
+    }
+    scheduleScan();
+}
+
+void MetadataColumns::reset()
+{
+    m_job.discard();
+    m_cache.clear();
+    m_requested.clear();
+    m_queued.clear();
+    m_inFlight.clear();
+    scheduleScan();
+}
@@ -0,0 +1,80 @@
+#ifndef METADATACOLUMNS_H
+#define METADATACOLUMNS_H
+
+#include <QObject>
+#include <QStandardItemModel>
+#include <QTreeView>
+#include <QPersistentModelIndex>
+#include <QDateTime>
+#include <QFileDevice>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+#include <QVector>
+#include <functional>
+#include <vector>
+
+#include "backgroundjob.h"
+
+// 绑定文件的元数据
+struct FileMetadata
+{
+    bool exists = false;
+    qint64 size = 0;
+    QDateTime modified;
+    QFileDevice::Permissions permissions;
+};
+
+// 元数据列：文件大小、修改时间、权限
+// 只为视图中可见的行取元数据：滚动、展开或改变窗口大小后，找出可见行中尚未缓存的节点，
+// 一次性交给后台线程并行 stat，结果按节点缓存并写入对应单元格。绑定路径变化或节点删除时丢弃缓存。
+class MetadataColumns : public QObject
+{
+public:
+    enum { ModifiedColumn = 4, PermissionsColumn = 5 };
+
+    explicit MetadataColumns(QObject *parent = nullptr);
+    ~MetadataColumns();
+
+    // 视图可以显示 model 之上的代理模型（如排序模型），可见行会先映射回 model 的索引
+    void setView(QTreeView *view, QStandardItemModel *model, int threads);
+    // 文件在磁盘上被修改后丢弃缓存，可见时重新 stat
+    void refresh(QStandardItem *item);
+
+    // 已缓存的元数据，没有时返回空指针；指针在下一次修改缓存前有效
+    const FileMetadata *cached(QStandardItem *item) const;
+    // 不论是否可见，为这些节点排队 stat（排序时用）
+    void request(const std::vector<QStandardItem*> &items);
+    // 每批元数据写入缓存后调用，参数是本批更新的节点
+    void setUpdateHandler(std::function<void(const QVector<QStandardItem*> &)> handler) { m_updateHandler = std::move(handler); }
+
+    static QString formatPermissions(QFileDevice::Permissions permissions);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    void scheduleScan();
+    void scanVisible();
+    void startStat();
+    void applyMetadata(const QVector<FileMetadata> &results);
+    void showMetadata(QStandardItem *item, const FileMetadata &meta);
+    void forget(QStandardItem *item);
+    void rowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void pathChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles);
+    void reset();
+
+    QTreeView *m_view = nullptr;
+    QStandardItemModel *m_model = nullptr;
+    int m_threads = 0;
+    QTimer m_scanTimer;
+
+    QHash<QStandardItem*, FileMetadata> m_cache;
+    QSet<QStandardItem*> m_requested;               // 已排队或正在 stat 的节点
+    QVector<QPersistentModelIndex> m_queued;
+    QVector<QPersistentModelIndex> m_inFlight;
+    std::function<void(const QVector<QStandardItem*> &)> m_updateHandler;
+    BackgroundJob m_job;
+};
+
+#endif // METADATACOLUMNS_H
@@ -0,0 +1,208 @@
+#include "modelcounters.h"
+#include "counters.h"
+
+static Counter s_nodes("model.nodes", "节点数");
+static Counter s_bytes("model.bytes", "模型内存（估算）", Counter::Bytes);
+
+// 64 位平台上 QStandardItem 及其私有数据、父节点子项表中一项的大致开销，每个数据角色另占一项；
+// 大小、背景色等定长角色计入 ItemOverhead，它们变化时不必重算
+static const qint64 ItemOverhead = 192;
+static const qint64 RoleOverhead = 32;
+static const int CountedRoles[] = {Qt::DisplayRole, Qt::EditRole, Qt::ToolTipRole, Qt::DecorationRole,
+                                   Qt::UserRole + 1, Qt::UserRole + 2, Qt::UserRole + 3};
+
+ModelCounters::ModelCounters(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void ModelCounters::setModel(QStandardItemModel *model)
+{
+    if (m_model) {
+        disconnect(m_model, nullptr, this, nullptr);
+    }
+    m_model = model;
+    reset();
+    if (!model) return;
+
+    connect(model, &QAbstractItemModel::rowsInserted, this, &ModelCounters::rowsInserted);
+    connect(model, &QAbstractItemModel::rowsAboutToBeRemoved, this, &ModelCounters::rowsAboutToBeRemoved);
+    connect(model, &QAbstractItemModel::dataChanged, this, &ModelCounters::dataChanged);
+    connect(model, &QAbstractItemModel::modelReset, this, &ModelCounters::reset);
+}
+
+MemoryUsage ModelCounters::usage(QStandardItem *item) const
+{
+    if (!m_model) return MemoryUsage();
+    if (!item) item = m_model->invisibleRootItem();
+    auto it = m_totals.constFind(item);
+    if (it != m_totals.constEnd()) return it.value();
+    it = m_rows.constFind(item);
+    return it != m_rows.constEnd() ? it.value() : rowUsage(item);
+}
+
+MemoryUsage ModelCounters::rowUsage(QStandardItem *item)
+{
+    MemoryUsage usage;
+    QStandardItem *parent = item->parent();
+    if (!parent && item->model() && item != item->model()->invisibleRootItem()) {
+        parent = item->model()->invisibleRootItem();
+    }
+    if (!parent) return usage;      // 不可见根节点本身不计
+    usage.nodes = 1;
+    for (int column = 0; column < parent->columnCount(); ++column) {
+        QStandardItem *cell = parent->child(item->row(), column);
+        if (!cell) continue;
+        usage.nodeBytes += ItemOverhead;
+        // 图标在节点间共享，只计句柄
+        if (cell->data(Qt::DecorationRole).isValid()) usage.iconBytes += RoleOverhead;
+        for (int role : {int(Qt::DisplayRole), int(Qt::ToolTipRole), Qt::UserRole + 1}) {
+            const QVariant value = cell->data(role);
+            if (!value.isValid()) continue;
+            usage.nodeBytes += RoleOverhead;
+            usage.stringBytes += MemoryUsage::sizeOfString(value.toString());
+        }
+        for (int role : {Qt::UserRole + 2, Qt::UserRole + 3}) {
+            const QVariant value = cell->data(role);
+            if (!value.isValid()) continue;
+            usage.nodeBytes += RoleOverhead;
+            usage.pathBytes += MemoryUsage::sizeOfString(value.toString());
+        }
+    }
+    return usage;
+}
+
+bool ModelCounters::affectsUsage(const QVector<int> &roles)
+{
+    if (roles.isEmpty()) return true;
+    for (int role : CountedRoles) {
+        if (roles.contains(role)) return true;
+    }
+    return false;
+}
+
+bool ModelCounters::isContainer(QStandardItem *item)
+{
+    const QString type = item->data(Qt::UserRole + 1).toString();
+    return item->hasChildren() || type == "文件夹" || type == "驱动器" || type == "system";
+}
+
+QStandardItem *ModelCounters::parentItem(const QModelIndex &parent) const
+{
+    return parent.isValid() ? m_model->itemFromIndex(parent) : m_model->invisibleRootItem();
+}
+
+MemoryUsage ModelCounters::addSubtree(QStandardItem *item)
+{
+    MemoryUsage sum = rowUsage(item);
+    m_rows.insert(item, sum);
+    if (!isContainer(item)) return sum;
+    for (int i = 0; i < item->rowCount(); ++i) {
+        if (QStandardItem *child = item->child(i, 0)) {
+            sum += addSubtree(child);
+        }
+    }
+    m_totals.insert(item, sum);
+    return sum;
+}
+
+void ModelCounters::removeSubtree(QStandardItem *item)
+{
+    m_rows.remove(item);
+    if (m_totals.remove(item) == 0) return;
+    for (int i = 0; i < item->rowCount(); ++i) {
+        if (QStandardItem *child = item->child(i, 0)) {
+            removeSubtree(child);
+        }
+    }
+}
+
+void ModelCounters::addToAncestors(QStandardItem *parent, const MemoryUsage &delta)
+{
+    if (delta.isZero()) return;
+    QStandardItem *root = m_model->invisibleRootItem();
+    for (QStandardItem *p = parent; p; p = p->parent()) {
+        // 原先是文件、刚有了子项的节点，汇总值从它自己这一行开始
+        auto it = m_totals.find(p);
+        if (it == m_totals.end()) it = m_totals.insert(p, m_rows.value(p));
+        it.value() += delta;
+        if (p == root) return;
+    }
+    // 顶层节点的 parent() 为空，不可见根节点单独加
+    m_totals[root] += delta;
+}
+
+void ModelCounters::rowsInserted(const QModelIndex &parent, int first, int last)
+{
+    if (parent.isValid() && parent.column() != 0) return;
+    QStandardItem *parentNode = parentItem(parent);
+    MemoryUsage sum;
+    for (int row = first; row <= last; ++row) {
+        if (QStandardItem *item = parentNode->child(row, 0)) {
+            sum += addSubtree(item);
+        }
+    }
+    addToAncestors(parentNode, sum);
+    publish();
+}
+
+void ModelCounters::rowsAboutToBeRemoved(const QModelIndex &parent, int first, int last)
+{
+    if (parent.isValid() && parent.column() != 0) return;
+    QStandardItem *parentNode = parentItem(parent);
+    MemoryUsage sum;
+    for (int row = first; row <= last; ++row) {
+        if (QStandardItem *item = parentNode->child(row, 0)) {
+            sum += usage(item);
+            removeSubtree(item);
+        }
+    }
+    addToAncestors(parentNode, -sum);
+    publish();
+}
+
+void ModelCounters::dataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles)
+{
+    if (!affectsUsage(roles)) return;
+    // 只重算变化的行，与缓存值的差加到自身（若是容器）和祖先上
+    QStandardItem *parentNode = parentItem(topLeft.parent());
+    bool changed = false;
+    for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+        QStandardItem *item = parentNode->child(row, 0);
+        if (!item) continue;
+        const MemoryUsage now = rowUsage(item);
+        MemoryUsage &cached = m_rows[item];
+        const MemoryUsage delta = now - cached;
+        cached = now;
+        if (delta.isZero()) continue;
+        auto total = m_totals.find(item);
+        if (total != m_totals.end()) total.value() += delta;
+        addToAncestors(parentNode, delta);
+        changed = true;
+    }
+    if (changed) publish();
+}
+
+void ModelCounters::reset()
+{
+    m_rows.clear();
+    m_totals.clear();
+    if (m_model) {
+        QStandardItem *root = m_model->invisibleRootItem();
+        MemoryUsage sum;
+        for (int row = 0; row < root->rowCount(); ++row) {
+            if (QStandardItem *item = root->child(row, 0)) {
+                sum += addSubtree(item);
+            }
+        }
+        m_totals.insert(root, sum);
+    }
+    publish();
+}
+
+void ModelCounters::publish()
+{
+    const MemoryUsage total = usage();
+    s_nodes.set(total.nodes);
+    s_bytes.set(total.total());
+}
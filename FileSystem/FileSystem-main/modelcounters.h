@@ -0,0 +1,46 @@
+#ifndef MODELCOUNTERS_H
+#define MODELCOUNTERS_H
+
+#include <QObject>
+#include <QStandardItemModel>
+#include <QPointer>
+#include <QHash>
+
+#include "memoryusage.h"
+
+// 模型计数：每棵子树的节点数和内存占用估算
+// 每行的占用和文件夹的汇总值都保存在表中；插入、删除时只统计变化的子树，修改数据时只重算该行，
+// 再沿祖先链加减差值。整棵树的结果写入计数器 model.nodes 和 model.bytes。
+class ModelCounters : public QObject
+{
+public:
+    explicit ModelCounters(QObject *parent = nullptr);
+
+    void setModel(QStandardItemModel *model);
+
+    // item 子树（含自身）的占用，item 为空时统计整个模型
+    MemoryUsage usage(QStandardItem *item = nullptr) const;
+
+    // 一行（名称列及其余各列）的占用，含 QStandardItem 自身开销和各数据角色
+    static MemoryUsage rowUsage(QStandardItem *item);
+    // 改变后会影响估算的数据角色
+    static bool affectsUsage(const QVector<int> &roles);
+
+private:
+    static bool isContainer(QStandardItem *item);
+    MemoryUsage addSubtree(QStandardItem *item);
+    void removeSubtree(QStandardItem *item);
+    void addToAncestors(QStandardItem *parent, const MemoryUsage &delta);
+    void rowsInserted(const QModelIndex &parent, int first, int last);
+    void rowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void dataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles);
+    void reset();
+    void publish();
+    QStandardItem *parentItem(const QModelIndex &parent) const;
+
+    QPointer<QStandardItemModel> m_model;   // 旧模型可能先于 setModel 被删除
+    QHash<QStandardItem*, MemoryUsage> m_rows;      // 每行（以名称列为键）上次统计的占用
+    QHash<QStandardItem*, MemoryUsage> m_totals;    // 容器节点（含不可见根节点）的子树汇总
+};
+
+#endif // MODELCOUNTERS_H
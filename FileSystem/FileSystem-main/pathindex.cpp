@@ -0,0 +1,226 @@
+#include "pathindex.h"
+#include "treeengine.h"
+
+#include <algorithm>
+
+PathIndex::PathIndex(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void PathIndex::setModel(QStandardItemModel *model)
+{
+    if (m_model) {
+        disconnect(m_model, nullptr, this, nullptr);
+    }
+    m_model = model;
+    invalidate();
+    m_paths.clear();
+    if (!model) return;
+
+    // 插入和删除只影响那几行的子树；QStandardItemModel 的移动是先取出再插入，rowsMoved 很少出现
+    connect(model, &QAbstractItemModel::rowsInserted, this, &PathIndex::rowsInserted);
+    connect(model, &QAbstractItemModel::rowsAboutToBeRemoved, this, &PathIndex::rowsAboutToBeRemoved);
+    connect(model, &QAbstractItemModel::rowsMoved, this, [this]() {
+        invalidate();
+        m_paths.clear();
+    });
+    connect(model, &QAbstractItemModel::modelReset, this, [this]() {
+        invalidate();
+        m_paths.clear();
+    });
+    connect(model, &QAbstractItemModel::dataChanged, this,
+            [this](const QModelIndex &topLeft, const QModelIndex &, const QVector<int> &roles) {
+        // 只有名称变化才影响路径，其他列的文字与路径无关
+        if (topLeft.column() == 0 && (roles.isEmpty() || roles.contains(Qt::DisplayRole))) {
+            renamed(topLeft);
+        }
+    });
+}
+
+QString PathIndex::displayPath(QStandardItem *item)
+{
+    auto it = m_paths.constFind(item);
+    if (it != m_paths.constEnd()) return it.value();
+
+    buildPath(item, m_buffer);
+    // 深拷贝进缓存，保持 m_buffer 不被共享以便复用
+    QString path(m_buffer.constData(), m_buffer.size());
+    m_paths.insert(item, path);
+    return path;
+}
+
+void PathIndex::buildPath(QStandardItem *item, QString &buffer)
+{
+    static const QString separator = QStringLiteral(" / ");
+
+    // 先算总长度，再从尾部向前填充，避免逐级 prepend
+    qsizetype length = 0;
+    for (QStandardItem *p = item; p; p = p->parent()) {
+        length += p->text().size();
+        if (p != item) length += separator.size();
+    }
+    buffer.resize(length);
+
+    QChar *out = buffer.data() + length;
+    for (QStandardItem *p = item; p; p = p->parent()) {
+        if (p != item) {
+            out -= separator.size();
+            std::copy(separator.constBegin(), separator.constEnd(), out);
+        }
+        const QString name = p->text();
+        out -= name.size();
+        std::copy(name.constBegin(), name.constEnd(), out);
+    }
+}
+
+QStandardItem *PathIndex::find(const QStringList &components)
+{
+    if (!m_model || components.isEmpty()) return nullptr;
+    if (m_dirty) rebuild();
+
+    QString key = components.join('/').toCaseFolded();
+    if (QStandardItem *item = findFolder(key, components)) {
+        return item;
+    }
+
+    // 不是文件夹时，先定位父文件夹再在其子项中按名称查找，规则与 TreeEngine::nodeAt 相同
+    if (components.size() < 2) return nullptr;
+    QStandardItem *parent = find(components.mid(0, components.size() - 1));
+    if (!parent) return nullptr;
+    const int row = TreeEngine::childRow(parent->rowCount(), [parent](int i) { return parent->child(i, 0)->text(); },
+                                         components.last());
+    return row >= 0 ? parent->child(row, 0) : nullptr;
+}
+
+void PathIndex::invalidate()
+{
+    m_dirty = true;
+    m_folders.clear();
+    m_keys.clear();
+}
+
+void PathIndex::rebuild()
+{
+    m_folders.clear();
+    m_keys.clear();
+    QStandardItem *root = m_model->invisibleRootItem();
+    for (int i = 0; i < root->rowCount(); ++i) {
+        QStandardItem *item = root->child(i, 0);
+        indexItem(item, item->text().toCaseFolded());
+    }
+    m_dirty = false;
+}
+
+void PathIndex::rowsInserted(const QModelIndex &parent, int first, int last)
+{
+    // 索引尚未建立时等首次查询一并建立
+    if (m_dirty) return;
+    QStandardItem *root = m_model->invisibleRootItem();
+    QStandardItem *parentItem = parent.isValid() ? m_model->itemFromIndex(parent) : root;
+    QString prefix;
+    if (parentItem != root) {
+        // 父项可能是刚有了第一个子项、之前没有索引的节点
+        auto it = m_keys.constFind(parentItem);
+        prefix = it != m_keys.constEnd() ? it.value() : keyOf(parentItem);
+        if (it == m_keys.constEnd()) {
+            m_folders.insert(prefix, parentItem);
+            m_keys.insert(parentItem, prefix);
+        }
+        prefix += '/';
+    }
+    for (int row = first; row <= last; ++row) {
+        if (QStandardItem *item = parentItem->child(row, 0)) {
+            indexItem(item, prefix + item->text().toCaseFolded());
+        }
+    }
+}
+
+void PathIndex::rowsAboutToBeRemoved(const QModelIndex &parent, int first, int last)
+{
+    QStandardItem *parentItem = parent.isValid() ? m_model->itemFromIndex(parent) : m_model->invisibleRootItem();
+    for (int row = first; row <= last; ++row) {
+        if (QStandardItem *item = parentItem->child(row, 0)) {
+            unindexItem(item);
+        }
+    }
+}
+
+void PathIndex::renamed(const QModelIndex &topLeft)
+{
+    // 重命名文件只影响它自己，重命名文件夹会影响所有后代
+    QStandardItem *item = m_model->itemFromIndex(topLeft.sibling(topLeft.row(), 0));
+    if (!item) return;
+    unindexItem(item);
+    if (!m_dirty) indexItem(item, keyOf(item));
+}
+
+bool PathIndex::isIndexed(QStandardItem *item)
+{
+    // 文件通过父文件夹查找；空文件夹也索引，之后插入子项时不必再补父项
+    if (item->hasChildren()) return true;
+    const QString type = item->data(Qt::UserRole + 1).toString();
+    return type == "文件夹" || type == "驱动器" || type == "system";
+}
+
+void PathIndex::indexItem(QStandardItem *item, const QString &key)
+{
+    if (!isIndexed(item)) return;
+    m_folders.insert(key, item);
+    m_keys.insert(item, key);
+    for (int i = 0; i < item->rowCount(); ++i) {
+        QStandardItem *child = item->child(i, 0);
+        indexItem(child, key + '/' + child->text().toCaseFolded());
+    }
+}
+
+void PathIndex::unindexItem(QStandardItem *item)
+{
+    m_paths.remove(item);
+    auto it = m_keys.find(item);
+    if (it != m_keys.end()) {
+        m_folders.remove(it.value(), item);
+        m_keys.erase(it);
+    }
+    for (int i = 0; i < item->rowCount(); ++i) {
+        unindexItem(item->child(i, 0));
+    }
+}
+
+QString PathIndex::keyOf(QStandardItem *item)
+{
+    QStringList names;
+    for (QStandardItem *p = item; p; p = p->parent()) {
+        names.prepend(p->text().toCaseFolded());
+    }
+    return names.join('/');
+}
+
+bool PathIndex::endsWith(QStandardItem *item, const QStringList &components)
+{
+    for (int i = components.size() - 1; i >= 0; --i, item = item->parent()) {
+        if (!item || item->text() != components[i]) return false;
+    }
+    return true;
+}
+
+QStandardItem *PathIndex::findFolder(const QString &key, const QStringList &components) const
+{
+    // 同一键下有多个只差大小写的节点时优先取名称完全相同的
+    auto lookup = [&](const QString &k) -> QStandardItem* {
+        QStandardItem *candidate = nullptr;
+        for (auto it = m_folders.constFind(k); it != m_folders.constEnd() && it.key() == k; ++it) {
+            if (endsWith(it.value(), components)) return it.value();
+            if (!candidate) candidate = it.value();
+        }
+        return candidate;
+    };
+    if (QStandardItem *item = lookup(key)) return item;
+
+    // 允许省略顶层节点（如“我的电脑”）
+    QStandardItem *root = m_model->invisibleRootItem();
+    for (int i = 0; i < root->rowCount(); ++i) {
+        if (QStandardItem *item = lookup(root->child(i, 0)->text().toCaseFolded() + '/' + key)) return item;
+    }
+    return nullptr;
+}
@@ -0,0 +1,56 @@
+#ifndef PATHINDEX_H
+#define PATHINDEX_H
+
+#include <QObject>
+#include <QStandardItemModel>
+#include <QHash>
+#include <QVector>
+#include <QStringList>
+
+#include "pathpattern.h"
+
+// 路径索引
+// 正向：文件夹路径（各级名称用 "/" 连接，不区分大小写）→ 节点，首次查询时建立，之后插入、删除和重命名
+// 只更新受影响的子树；只差大小写的同级文件夹共用一个键，查询时优先取大小写完全相同的节点。
+// 反向：节点 → 显示路径（各级用 " / " 连接）缓存，重命名或删除时移除受影响子树的条目。
+class PathIndex : public QObject
+{
+public:
+    explicit PathIndex(QObject *parent = nullptr);
+
+    void setModel(QStandardItemModel *model);
+
+    // 按路径查找节点，可省略顶层的“我的电脑”；找不到返回 nullptr
+    QStandardItem *find(const QStringList &components);
+
+    // 节点的显示路径，命中缓存时只做一次哈希查找，返回的字符串与缓存共享数据
+    QString displayPath(QStandardItem *item);
+
+    // 把显示路径写入调用方复用的缓冲区，缓冲区容量足够且未被共享时不分配内存
+    static void buildPath(QStandardItem *item, QString &buffer);
+
+    static QStringList splitPath(const QString &path) { return PathPattern::splitPath(path); }
+
+private:
+    void invalidate();
+    void rebuild();
+    void rowsInserted(const QModelIndex &parent, int first, int last);
+    void rowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void renamed(const QModelIndex &topLeft);
+    void indexItem(QStandardItem *item, const QString &key);
+    void unindexItem(QStandardItem *item);
+    QStandardItem *findFolder(const QString &key, const QStringList &components) const;
+
+    static bool isIndexed(QStandardItem *item);
+    static QString keyOf(QStandardItem *item);
+    static bool endsWith(QStandardItem *item, const QStringList &components);
+
+    QStandardItemModel *m_model = nullptr;
+    QMultiHash<QString, QStandardItem*> m_folders;     // 大小写折叠后的路径 → 节点
+    QHash<QStandardItem*, QString> m_keys;              // 反查，删除和重命名时按节点移除
+    bool m_dirty = true;
+    QHash<QStandardItem*, QString> m_paths;
+    QString m_buffer;
+};
+
+#endif // PATHINDEX_H
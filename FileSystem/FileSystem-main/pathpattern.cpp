@@ -0,0 +1,71 @@
+#include "pathpattern.h"
+
+QStringList PathPattern::splitPath(const QString &path)
+{
+    QStringList components;
+    for (const QString &part : path.split('/')) {
+        QString name = part.trimmed();
+        if (!name.isEmpty()) {
+            components.append(name);
+        }
+    }
+    return components;
+}
+
+PathPattern::PathPattern(const QString &query)
+{
+    const QStringList components = splitPath(query);
+    bool inScope = true;
+    for (const QString &component : components) {
+        bool literal = !component.contains('*') && !component.contains('?');
+        if (inScope && literal) {
+            m_scope.append(component);
+            continue;
+        }
+        inScope = false;
+
+        Part part;
+        part.text = component;
+        part.anyDepth = (component == "**");
+        part.literal = literal;
+        if (!literal && !part.anyDepth) {
+            part.regex.setPattern(QRegularExpression::anchoredPattern(
+                QRegularExpression::wildcardToRegularExpression(component)));
+            part.regex.setPatternOptions(QRegularExpression::CaseInsensitiveOption);
+            part.regex.optimize();
+        }
+        m_parts.append(part);
+    }
+}
+
+quint64 PathPattern::start() const
+{
+    return closure(1);
+}
+
+quint64 PathPattern::closure(quint64 state) const
+{
+    // "**" 可以匹配零级，直接跳到下一段
+    for (int i = 0; i < m_parts.size(); ++i) {
+        if ((state & (quint64(1) << i)) && m_parts[i].anyDepth) {
+            state |= quint64(1) << (i + 1);
+        }
+    }
+    return state;
+}
+
+quint64 PathPattern::advance(quint64 state, const QString &name) const
+{
+    quint64 next = 0;
+    for (int i = 0; i < m_parts.size(); ++i) {
+        if (!(state & (quint64(1) << i))) continue;
+        const Part &part = m_parts[i];
+        if (part.anyDepth) {
+            next |= quint64(1) << i;
+        } else if (part.literal ? name.compare(part.text, Qt::CaseInsensitive) == 0
+                                : part.regex.match(name).hasMatch()) {
+            next |= quint64(1) << (i + 1);
+        }
+    }
+    return closure(next);
+}
@@ -0,0 +1,43 @@
+#ifndef PATHPATTERN_H
+#define PATHPATTERN_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QRegularExpression>
+
+// 路径查询，如 "C盘/文件夹1/**/*.txt"
+// 开头不含通配符的各级作为搜索范围，其余部分逐级匹配：* 和 ? 只在一级名称内匹配，** 匹配任意多级
+class PathPattern
+{
+public:
+    explicit PathPattern(const QString &query);
+
+    // 按 "/" 拆分路径，去掉各级首尾空白和空的级
+    static QStringList splitPath(const QString &path);
+
+    const QStringList &scope() const { return m_scope; }
+    bool isLiteral() const { return m_parts.isEmpty(); }
+    bool isValid() const { return m_parts.size() < 64; }
+
+    // 匹配状态是位集合，第 i 位表示已匹配完前 i 段
+    quint64 start() const;
+    quint64 advance(quint64 state, const QString &name) const;
+    bool matches(quint64 state) const { return state & (quint64(1) << m_parts.size()); }
+
+private:
+    struct Part
+    {
+        QString text;
+        bool anyDepth = false;   // "**"
+        bool literal = true;
+        QRegularExpression regex;
+    };
+
+    quint64 closure(quint64 state) const;
+
+    QStringList m_scope;
+    QVector<Part> m_parts;
+};
+
+#endif // PATHPATTERN_H
@@ -0,0 +1,16 @@
+#ifndef PROCESSMEMORY_H
+#define PROCESSMEMORY_H
+
+#include <QtGlobal>
+
+// 当前进程的内存，由操作系统报告；诊断面板、基准测试和规模报告共用
+class ProcessMemory
+{
+public:
+    // 常驻内存（字节），取不到时为 0；Linux 上读 /proc/self/statm
+    static qint64 residentBytes();
+    // 峰值常驻内存（字节），取不到时为 0；Unix 上取 getrusage 的 ru_maxrss
+    static qint64 peakResidentBytes();
+};
+
+#endif // PROCESSMEMORY_H
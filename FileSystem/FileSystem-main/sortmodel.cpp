@@ -0,0 +1,244 @@
+#include "sortmodel.h"
+#include "folderstats.h"
+#include "metadatacolumns.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+SortModel::SortModel(const FolderStats *stats, MetadataColumns *metadata, QObject *parent)
+    : QSortFilterProxyModel(parent), m_stats(stats), m_metadata(metadata)
+{
+    // 数据变化时不自动重排：大小等列在后台陆续更新，自动重排会让大文件夹反复整体排序
+    setDynamicSortFilter(false);
+
+    // 元数据分批到达，攒一小段时间后只重排一次
+    m_resortTimer.setSingleShot(true);
+    m_resortTimer.setInterval(100);
+    connect(&m_resortTimer, &QTimer::timeout, this, &SortModel::resort);
+    if (m_metadata) {
+        m_metadata->setUpdateHandler([this](const QVector<QStandardItem*> &items) { metadataArrived(items); });
+    }
+}
+
+void SortModel::setSourceModel(QAbstractItemModel *model)
+{
+    if (sourceModel()) {
+        disconnect(sourceModel(), nullptr, this, nullptr);
+    }
+    forgetAll();
+    m_waiting.clear();
+    m_model = qobject_cast<QStandardItemModel*>(model);
+    QSortFilterProxyModel::setSourceModel(model);
+    if (!model) return;
+
+    // 行号变化前就丢弃对应文件夹的名次，保证后续比较不会用到旧名次
+    connect(model, &QAbstractItemModel::rowsAboutToBeInserted, this, [this](const QModelIndex &parent) {
+        forgetFolder(parent);
+    });
+    connect(model, &QAbstractItemModel::rowsAboutToBeRemoved, this, &SortModel::forgetAll);
+    connect(model, &QAbstractItemModel::rowsAboutToBeMoved, this, &SortModel::forgetAll);
+    connect(model, &QAbstractItemModel::layoutAboutToBeChanged, this, &SortModel::forgetAll);
+    connect(model, &QAbstractItemModel::modelAboutToBeReset, this, &SortModel::forgetAll);
+    connect(model, &QAbstractItemModel::dataChanged, this, [this](const QModelIndex &topLeft) {
+        forgetFolder(topLeft.parent());
+    });
+}
+
+void SortModel::sort(int column, Qt::SortOrder order)
+{
+    // 始终让基类按第0列排序：各文件夹的子表列数不一定够，其他列的索引可能无效，实际排序列记在 m_keyColumn
+    m_keyColumn = column;
+    m_lastParent = nullptr;
+    m_waiting.clear();
+    QSortFilterProxyModel::sort(column < 0 ? -1 : 0, order);
+}
+
+bool SortModel::acceptsDrop(const QModelIndex &index) const
+{
+    if (!index.isValid() || !m_model) return false;
+    QStandardItem *item = m_model->itemFromIndex(mapToSource(index.sibling(index.row(), 0)));
+    return item && !FolderStats::isFile(item);
+}
+
+Qt::ItemFlags SortModel::flags(const QModelIndex &index) const
+{
+    Qt::ItemFlags flags = QSortFilterProxyModel::flags(index);
+    if (index.isValid() && !acceptsDrop(index)) flags &= ~Qt::ItemIsDropEnabled;
+    return flags;
+}
+
+bool SortModel::canDropMimeData(const QMimeData *data, Qt::DropAction action, int row, int column,
+                                const QModelIndex &parent) const
+{
+    return acceptsDrop(parent) && QSortFilterProxyModel::canDropMimeData(data, action, row, column, parent);
+}
+
+QString SortModel::naturalKey(const QString &name)
+{
+    const QString folded = name.toCaseFolded();
+    QString key;
+    key.reserve(folded.size() + 4);
+    for (int i = 0; i < folded.size();) {
+        const QChar c = folded[i];
+        if (c < QLatin1Char('0') || c > QLatin1Char('9')) {
+            key += c;
+            ++i;
+            continue;
+        }
+        // 数字串去掉前导零，前面加一个表示位数的控制字符，位数少的数值小
+        int start = i;
+        while (i < folded.size() && folded[i] >= QLatin1Char('0') && folded[i] <= QLatin1Char('9')) {
+            ++i;
+        }
+        while (start < i - 1 && folded[start] == QLatin1Char('0')) {
+            ++start;
+        }
+        key += QChar(char16_t(qMin(i - start, 0x1f)));
+        key += QStringView(folded).mid(start, i - start);
+    }
+    return key;
+}
+
+bool SortModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
+{
+    if (!m_model) return QSortFilterProxyModel::lessThan(left, right);
+
+    // 同一文件夹内连续比较时只查一次名次表
+    const QModelIndex parentIndex = left.parent();
+    QStandardItem *parent = parentIndex.isValid() ? m_model->itemFromIndex(parentIndex) : m_model->invisibleRootItem();
+    if (parent != m_lastParent) {
+        m_lastKeys = &keys(parent);
+        m_lastParent = parent;
+    }
+    const FolderKeys &k = *m_lastKeys;
+    const int l = left.row();
+    const int r = right.row();
+    // 基类在降序时把比较结果反过来用，文件夹与文件之分要预先按方向调整，才能始终排在前面
+    if (k.files[l] != k.files[r]) {
+        const bool folderFirst = !k.files[l];
+        return sortOrder() == Qt::AscendingOrder ? folderFirst : !folderFirst;
+    }
+    return k.ranks[l] < k.ranks[r];
+}
+
+const SortModel::FolderKeys &SortModel::keys(QStandardItem *parent) const
+{
+    FolderKeys &keys = m_folders[parent];
+    if (keys.column != m_keyColumn || keys.ranks.size() != static_cast<size_t>(parent->rowCount())) {
+        computeRanks(parent, keys);
+    }
+    return keys;
+}
+
+void SortModel::computeRanks(QStandardItem *parent, FolderKeys &keys) const
+{
+    const int rows = parent->rowCount();
+    if (keys.names.size() != static_cast<size_t>(rows)) {
+        keys.names.resize(rows);
+        for (int i = 0; i < rows; ++i) {
+            keys.names[i] = naturalKey(parent->child(i, 0)->text());
+        }
+    }
+
+    struct Entry
+    {
+        qint64 number = 0;
+        QString text;
+    };
+    std::vector<Entry> entries(rows);
+    std::vector<QStandardItem*> missing;
+    keys.files.assign(rows, 0);
+    for (int i = 0; i < rows; ++i) {
+        QStandardItem *child = parent->child(i, 0);
+        Entry &e = entries[i];
+        keys.files[i] = FolderStats::isFile(child);
+        switch (m_keyColumn) {
+        case 1:
+            e.text = child->data(Qt::UserRole + 1).toString().toCaseFolded();
+            break;
+        case FolderStats::SizeColumn:
+            e.number = m_stats ? m_stats->totals(child).bytes : 0;
+            break;
+        case FolderStats::CountColumn:
+            e.number = m_stats ? m_stats->totals(child).files : 0;
+            break;
+        case MetadataColumns::ModifiedColumn:
+        case MetadataColumns::PermissionsColumn:
+            // 未绑定或不存在的视为最小；还没取到的暂时视为最大，取到后重排
+            if (child->data(Qt::UserRole + 2).toString().isEmpty()) {
+                e.number = -1;
+            } else if (const FileMetadata *meta = m_metadata ? m_metadata->cached(child) : nullptr) {
+                if (!meta->exists) {
+                    e.number = -1;
+                } else if (m_keyColumn == MetadataColumns::ModifiedColumn) {
+                    e.number = meta->modified.toMSecsSinceEpoch();
+                } else {
+                    e.number = qint64(meta->permissions);
+                }
+            } else {
+                e.number = std::numeric_limits<qint64>::max();
+                missing.push_back(child);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    if (!missing.empty()) {
+        m_waiting.insert(parent);
+        m_metadata->request(missing);
+    }
+
+    std::vector<int> order(rows);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        const Entry &x = entries[a];
+        const Entry &y = entries[b];
+        if (x.number != y.number) return x.number < y.number;
+        if (x.text != y.text) return x.text < y.text;
+        if (keys.names[a] != keys.names[b]) return keys.names[a] < keys.names[b];
+        return a < b;
+    });
+
+    keys.ranks.assign(rows, 0);
+    for (int i = 0; i < rows; ++i) {
+        keys.ranks[order[i]] = i;
+    }
+    keys.column = m_keyColumn;
+}
+
+void SortModel::forgetFolder(const QModelIndex &parent)
+{
+    if (!m_model) return;
+    QStandardItem *item = parent.isValid() ? m_model->itemFromIndex(parent) : m_model->invisibleRootItem();
+    m_folders.erase(item);
+    m_lastParent = nullptr;
+}
+
+void SortModel::forgetAll()
+{
+    m_folders.clear();
+    m_lastParent = nullptr;
+}
+
+void SortModel::metadataArrived(const QVector<QStandardItem*> &items)
+{
+    if (m_waiting.isEmpty() || !m_model) return;
+    for (QStandardItem *item : items) {
+        QStandardItem *parent = item->parent() ? item->parent() : m_model->invisibleRootItem();
+        if (m_waiting.contains(parent)) {
+            if (!m_resortTimer.isActive()) {
+                m_resortTimer.start();
+            }
+            return;
+        }
+    }
+}
+
+void SortModel::resort()
+{
+    if (m_keyColumn != MetadataColumns::ModifiedColumn && m_keyColumn != MetadataColumns::PermissionsColumn) return;
+    forgetAll();
+    sort(m_keyColumn, sortOrder());
+}
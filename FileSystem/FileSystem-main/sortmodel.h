@@ -0,0 +1,70 @@
+#ifndef SORTMODEL_H
+#define SORTMODEL_H
+
+#include <QSortFilterProxyModel>
+#include <QStandardItemModel>
+#include <QSet>
+#include <QTimer>
+#include <unordered_map>
+#include <vector>
+
+class FolderStats;
+class MetadataColumns;
+
+// 排序模型
+// 放在 QStandardItemModel 与视图之间，按文件夹保存排序后的行序，底层存储的行序不变。
+// 排序某个文件夹时一次性算出全部子项的排序键（自然序名称、类型、大小、文件数、修改时间、权限），
+// 整体排好得到每行的名次；之后 QSortFilterProxyModel 的每次比较只比较两个整数。
+// 名称键按文件夹缓存，切换排序列时不重算。不论升序降序，文件夹总排在文件前面。
+// 修改时间和权限取自 MetadataColumns 的缓存，排序时不在界面线程 stat；尚未取到的行暂时视为最大，
+// 同时交给 MetadataColumns 在后台获取，到达后重新排序一次。
+class SortModel : public QSortFilterProxyModel
+{
+public:
+    SortModel(const FolderStats *stats, MetadataColumns *metadata, QObject *parent = nullptr);
+
+    void setSourceModel(QAbstractItemModel *model) override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    // 视图内拖动移动节点时，文件和顶层不接受放入
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+    bool canDropMimeData(const QMimeData *data, Qt::DropAction action, int row, int column,
+                         const QModelIndex &parent) const override;
+
+    int keyColumn() const { return m_keyColumn; }
+
+    // 自然序名称键：忽略大小写，数字串按数值比较，"文件2" 排在 "文件10" 之前
+    static QString naturalKey(const QString &name);
+
+protected:
+    bool lessThan(const QModelIndex &left, const QModelIndex &right) const override;
+
+private:
+    struct FolderKeys
+    {
+        std::vector<QString> names;     // 按源行号
+        std::vector<int> ranks;         // 按源行号，m_keyColumn 列的名次，不含文件夹与文件之分
+        std::vector<char> files;        // 按源行号，是否为文件
+        int column = -1;
+    };
+
+    bool acceptsDrop(const QModelIndex &index) const;
+    const FolderKeys &keys(QStandardItem *parent) const;
+    void computeRanks(QStandardItem *parent, FolderKeys &keys) const;
+    void forgetFolder(const QModelIndex &parent);
+    void forgetAll();
+    void metadataArrived(const QVector<QStandardItem*> &items);
+    void resort();
+
+    const FolderStats *m_stats = nullptr;
+    MetadataColumns *m_metadata = nullptr;
+    QStandardItemModel *m_model = nullptr;
+    int m_keyColumn = -1;
+    mutable std::unordered_map<QStandardItem*, FolderKeys> m_folders;
+    mutable QStandardItem *m_lastParent = nullptr;
+    mutable const FolderKeys *m_lastKeys = nullptr;
+    mutable QSet<QStandardItem*> m_waiting;         // 排序键还缺元数据的文件夹
+    QTimer m_resortTimer;
+};
+
+#endif // SORTMODEL_H
@@ -0,0 +1,168 @@
+#include "stallwatchdog.h"
+#include "eventloopmonitor.h"
+#include "counters.h"
+#include "trace.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <algorithm>
+
+static Counter s_reports("event_loop.stall_reports", "阻塞报告数");
+
+static QMutex s_activityMutex;
+static QString s_activity;
+
+StallWatchdog::Activity::Activity(const QString &text)
+{
+    QMutexLocker locker(&s_activityMutex);
+    m_previous = s_activity;
+    s_activity = text;
+}
+
+StallWatchdog::Activity::~Activity()
+{
+    QMutexLocker locker(&s_activityMutex);
+    s_activity = m_previous;
+}
+
+QString StallWatchdog::activity()
+{
+    QMutexLocker locker(&s_activityMutex);
+    return s_activity;
+}
+
+StallWatchdog::StallWatchdog(const EventLoopMonitor *monitor, const QString &directory, QObject *parent)
+    : QObject(parent), m_monitor(monitor), m_directory(directory)
+{
+}
+
+StallWatchdog::~StallWatchdog()
+{
+    stop();
+}
+
+void StallWatchdog::start(int thresholdMs)
+{
+    stop();
+    if (thresholdMs <= 0) return;
+    m_threshold = thresholdMs;
+    m_thread = Trace::currentThread();
+    Trace::setEnabled(true);
+    m_stopping = false;
+    m_stallBeat = 0;
+    m_worker = QThread::create([this]() { run(); });
+    m_worker->start();
+}
+
+void StallWatchdog::stop()
+{
+    if (!m_worker) return;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_wake.wakeAll();
+    }
+    m_worker->wait();
+    delete m_worker;
+    m_worker = nullptr;
+}
+
+void StallWatchdog::run()
+{
+    // 检查间隔取阈值的四分之一，阻塞开始后最迟 1.25 倍阈值时抓取
+    const unsigned long interval = std::max(10, m_threshold / 4);
+    QMutexLocker locker(&m_mutex);
+    while (!m_stopping) {
+        m_wake.wait(&m_mutex, interval);
+        if (m_stopping) break;
+        locker.unlock();
+        check();
+        locker.relock();
+    }
+}
+
+void StallWatchdog::check()
+{
+    const qint64 beat = m_monitor->lastBeat();
+    if (beat == 0) return;      // 监测未运行
+    const qint64 expected = m_monitor->interval();
+
+    if (m_stallBeat != 0) {
+        // 心跳恢复，阻塞结束：补写实际时长
+        if (beat != m_stallBeat) {
+            writeSummary((beat - m_stallBeat) / 1000000 - expected, true);
+            m_stallBeat = 0;
+        }
+        return;
+    }
+    const qint64 stalled = (Trace::now() - beat) / 1000000 - expected;
+    if (stalled >= m_threshold && m_reports < MaxReports) {
+        m_stallBeat = beat;
+        capture(stalled);
+    }
+}
+
+// 阻塞期间抓取：此时被监测线程仍停在阻塞处，活动区间反映的就是正在执行的代码
+void StallWatchdog::capture(qint64 stalledMs)
+{
+    ++m_reports;
+    s_reports.add(1);
+    QDir().mkpath(m_directory);
+    const QDateTime detected = QDateTime::currentDateTime();
+    m_detectedAt = detected.toString(Qt::ISODateWithMs);
+    m_baseName = QDir(m_directory).filePath("stall-" + detected.toString("yyyyMMdd-HHmmss-zzz"));
+
+    QString text;
+    const QString current = activity();
+    text += QString("正在进行的操作：%1\n").arg(current.isEmpty() ? "（未标注）" : current);
+
+    const QVector<TraceEvent> active = Trace::activeSpans();
+    text += "\n被阻塞线程上正在执行的区间（由外向内）：\n";
+    for (const TraceEvent &event : active) {
+        if (event.thread == m_thread) {
+            text += QString("  %1  已运行 %2 ms\n").arg(QString::fromUtf8(event.name)).arg(event.duration / 1000000);
+        }
+    }
+    text += "\n其他线程正在执行的区间：\n";
+    for (const TraceEvent &event : active) {
+        if (event.thread != m_thread) {
+            text += QString("  [线程 %1] %2  已运行 %3 ms\n").arg(event.thread)
+                        .arg(QString::fromUtf8(event.name)).arg(event.duration / 1000000);
+        }
+    }
+
+    // 被阻塞线程上最近结束的几个区间，说明阻塞前做了什么
+    const QVector<TraceEvent> events = Trace::events();
+    QStringList recent;
+    for (int i = events.size() - 1; i >= 0 && recent.size() < 10; --i) {
+        if (events[i].thread == m_thread) {
+            recent.prepend(QString("  %1  %2 ms\n").arg(QString::fromUtf8(events[i].name))
+                               .arg(events[i].duration / 1000000.0, 0, 'f', 1));
+        }
+    }
+    text += "\n被阻塞线程上最近完成的区间：\n" + recent.join(QString());
+
+    text += "\n计数器：\n";
+    for (const Counter *counter : Counters::counters()) {
+        text += QString("  %1 (%2) = %3\n").arg(counter->label(), QString::fromLatin1(counter->name()))
+                    .arg(counter->value());
+    }
+    m_details = text;
+
+    writeSummary(stalledMs, false);
+    Trace::writeChromeJson(m_baseName + ".json");
+}
+
+void StallWatchdog::writeSummary(qint64 stalledMs, bool finished)
+{
+    QSaveFile file(m_baseName + ".txt");
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) return;
+    QString header = QString("事件循环阻塞报告\n检测时间：%1\n阈值：%2 ms\n")
+        .arg(m_detectedAt).arg(m_threshold);
+    header += finished ? QString("阻塞时长：%1 ms\n\n").arg(stalledMs)
+                       : QString("阻塞时长：至少 %1 ms（仍在阻塞）\n\n").arg(stalledMs);
+    file.write((header + m_details).toUtf8());
+    file.commit();
+}
@@ -0,0 +1,68 @@
+#ifndef STALLWATCHDOG_H
+#define STALLWATCHDOG_H
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QString>
+
+class EventLoopMonitor;
+
+// 事件循环阻塞看门狗
+// 后台线程定期检查 EventLoopMonitor 的心跳，超过阈值没有更新就认为事件循环被阻塞，
+// 立即抓取各线程正在执行的跟踪区间、当前操作说明和计数器写成报告，阻塞结束后补写实际时长。
+// 报告写在 directory 下：stall-时间.txt 为文字摘要，stall-时间.json 为当时的 Chrome 跟踪记录。
+// 启用后跟踪区间也会一直记录（见 Trace），用来定位阻塞时正在执行的代码。
+class StallWatchdog : public QObject
+{
+public:
+    // 单次运行最多写出的报告数，避免反复阻塞时写满磁盘
+    static const int MaxReports = 20;
+
+    StallWatchdog(const EventLoopMonitor *monitor, const QString &directory, QObject *parent = nullptr);
+    ~StallWatchdog();
+
+    // 在被监测的线程上调用，thresholdMs <= 0 时不启动
+    void start(int thresholdMs);
+    void stop();
+
+    // 当前操作的说明，写入报告；在作用域内设置，结束时恢复为之前的说明
+    class Activity
+    {
+    public:
+        explicit Activity(const QString &text);
+        ~Activity();
+
+        Activity(const Activity &) = delete;
+        Activity &operator=(const Activity &) = delete;
+
+    private:
+        QString m_previous;
+    };
+    static QString activity();
+
+private:
+    void run();
+    void check();
+    void capture(qint64 stalledMs);
+    void writeSummary(qint64 stalledMs, bool finished);
+
+    const EventLoopMonitor *m_monitor;
+    QString m_directory;
+    int m_threshold = 0;
+    int m_thread = 0;               // 被监测线程在跟踪记录中的序号
+    QThread *m_worker = nullptr;
+    QMutex m_mutex;
+    QWaitCondition m_wake;
+    bool m_stopping = false;
+
+    // 以下只在看门狗线程上访问
+    qint64 m_stallBeat = 0;         // 阻塞前最后一次心跳，0 表示当前没有阻塞
+    int m_reports = 0;
+    QString m_baseName;             // 当前报告的文件名（不含扩展名）
+    QString m_detectedAt;
+    QString m_details;              // 检测到阻塞时抓取的内容，补写时长时原样保留
+};
+
+#endif // STALLWATCHDOG_H
@@ -0,0 +1,77 @@
+#include <QtTest>
+
+#include "contenthash.h"
+
+class TestContentHash : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void vectors_data();
+    void vectors();
+    void streamingMatchesOneShot_data();
+    void streamingMatchesOneShot();
+    void digestKeepsState();
+};
+
+void TestContentHash::vectors_data()
+{
+    QTest::addColumn<QByteArray>("input");
+    QTest::addColumn<quint64>("expected");
+
+    // XXH64 参考实现的结果，种子为 0；最后一项超过 32 字节，经过四路累加
+    QTest::newRow("empty") << QByteArray() << quint64(0xEF46DB3751D8E999ULL);
+    QTest::newRow("a") << QByteArray("a") << quint64(0xD24EC4F1A98C6E5BULL);
+    QTest::newRow("abc") << QByteArray("abc") << quint64(0x44BC2CF5AD770999ULL);
+    QTest::newRow("sentence") << QByteArray("Nobody inspects the spammish repetition")
+                              << quint64(0xFBCEA83C8A378BF1ULL);
+}
+
+void TestContentHash::vectors()
+{
+    QFETCH(QByteArray, input);
+    QFETCH(quint64, expected);
+    QCOMPARE(quint64(ContentHash::hash(input.constData(), size_t(input.size()))), expected);
+}
+
+void TestContentHash::streamingMatchesOneShot_data()
+{
+    QTest::addColumn<int>("chunk");
+    QTest::newRow("1") << 1;
+    QTest::newRow("7") << 7;
+    QTest::newRow("31") << 31;
+    QTest::newRow("32") << 32;
+    QTest::newRow("33") << 33;
+    QTest::newRow("4096") << 4096;
+}
+
+void TestContentHash::streamingMatchesOneShot()
+{
+    QFETCH(int, chunk);
+    QByteArray data(1000, Qt::Uninitialized);
+    for (int i = 0; i < data.size(); ++i) {
+        data[i] = char(i * 31 + 7);
+    }
+
+    // 任意分块 update 的结果与一次计算相同
+    ContentHash hash;
+    for (int i = 0; i < data.size(); i += chunk) {
+        hash.update(data.constData() + i, size_t(qMin(chunk, int(data.size()) - i)));
+    }
+    QCOMPARE(quint64(hash.digest()), quint64(ContentHash::hash(data.constData(), size_t(data.size()))));
+}
+
+void TestContentHash::digestKeepsState()
+{
+    const QByteArray first("Nobody inspects ");
+    const QByteArray second("the spammish repetition");
+    ContentHash hash;
+    hash.update(first.constData(), size_t(first.size()));
+    const quint64 partial = hash.digest();
+    QCOMPARE(partial, quint64(ContentHash::hash(first.constData(), size_t(first.size()))));
+    hash.update(second.constData(), size_t(second.size()));
+    QCOMPARE(quint64(hash.digest()), quint64(0xFBCEA83C8A378BF1ULL));
+}
+
+QTEST_APPLESS_MAIN(TestContentHash)
+#include "tst_contenthash.moc"
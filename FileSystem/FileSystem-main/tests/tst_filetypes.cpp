@@ -0,0 +1,181 @@
+#include <QtTest>
+#include <QBuffer>
+#include <QtEndian>
+
+#include "filetypes.h"
+
+class TestFileTypes : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void magicBytes_data();
+    void magicBytes();
+    void legacyOfficeUsesSuffix();
+    void zipDirectory_data();
+    void zipDirectory();
+    void zipWithoutDirectoryFallsBack();
+};
+
+static void put16(QByteArray &out, quint16 value)
+{
+    char bytes[2];
+    qToLittleEndian(value, bytes);
+    out.append(bytes, 2);
+}
+
+static void put32(QByteArray &out, quint32 value)
+{
+    char bytes[4];
+    qToLittleEndian(value, bytes);
+    out.append(bytes, 4);
+}
+
+// 按给定顺序写出不压缩的 zip：本地文件头和内容、中央目录、目录结束记录（CRC 不影响识别，写 0）
+static QByteArray makeZip(const QList<QPair<QByteArray, QByteArray>> &entries, const QByteArray &comment = QByteArray())
+{
+    QByteArray zip;
+    QList<quint32> offsets;
+    for (const auto &entry : entries) {
+        offsets.append(quint32(zip.size()));
+        put32(zip, 0x04034b50);
+        put16(zip, 20);
+        put16(zip, 0);
+        put16(zip, 0);
+        put16(zip, 0);
+        put16(zip, 0);
+        put32(zip, 0);
+        put32(zip, quint32(entry.second.size()));
+        put32(zip, quint32(entry.second.size()));
+        put16(zip, quint16(entry.first.size()));
+        put16(zip, 0);
+        zip += entry.first;
+        zip += entry.second;
+    }
+
+    const quint32 directoryOffset = quint32(zip.size());
+    for (int i = 0; i < entries.size(); ++i) {
+        const auto &entry = entries[i];
+        put32(zip, 0x02014b50);
+        put16(zip, 20);
+        put16(zip, 20);
+        put16(zip, 0);
+        put16(zip, 0);
+        put16(zip, 0);
+        put16(zip, 0);
+        put32(zip, 0);
+        put32(zip, quint32(entry.second.size()));
+        put32(zip, quint32(entry.second.size()));
+        put16(zip, quint16(entry.first.size()));
+        put16(zip, 0);
+        put16(zip, 0);
+        put16(zip, 0);
+        put16(zip, 0);
+        put32(zip, 0);
+        put32(zip, offsets[i]);
+        zip += entry.first;
+    }
+    const quint32 directorySize = quint32(zip.size()) - directoryOffset;
+
+    put32(zip, 0x06054b50);
+    put16(zip, 0);
+    put16(zip, 0);
+    put16(zip, quint16(entries.size()));
+    put16(zip, quint16(entries.size()));
+    put32(zip, directorySize);
+    put32(zip, directoryOffset);
+    put16(zip, quint16(comment.size()));
+    zip += comment;
+    return zip;
+}
+
+static FileTypeInfo typeOfBytes(const QByteArray &bytes, const QString &suffix = QString())
+{
+    QByteArray data = bytes;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    return fileTypeForFile(buffer, suffix);
+}
+
+void TestFileTypes::magicBytes_data()
+{
+    QTest::addColumn<QByteArray>("head");
+    QTest::addColumn<QString>("type");
+
+    QTest::newRow("pdf") << QByteArray("%PDF-1.7\n") << "pdf文件";
+    QTest::newRow("png") << QByteArray("\x89PNG\r\n\x1a\n\0\0\0\rIHDR", 16) << "png文件";
+    QTest::newRow("gif") << QByteArray("GIF89a\x01\x00\x01\x00", 10) << "gif文件";
+    QTest::newRow("jpeg") << QByteArray("\xFF\xD8\xFF\xE0\0\x10JFIF", 10) << "jpg文件";
+    QTest::newRow("gzip") << QByteArray("\x1f\x8b\x08\0\0\0\0\0", 8) << "压缩文件";
+    QTest::newRow("7z") << QByteArray("7z\xBC\xAF\x27\x1C\0\x04", 8) << "压缩文件";
+    QTest::newRow("text") << QByteArray("hello, 世界\n") << "txt文件";
+    // 末尾被截断的多字节字符仍算文本
+    QTest::newRow("truncated utf-8") << QByteArray("abc\xE4\xB8", 5) << "txt文件";
+    QTest::newRow("binary") << QByteArray("\x01\x02\0\x03", 4) << QString();
+    QTest::newRow("invalid utf-8") << QByteArray("ab\xFF\xFE" "cd", 6) << QString();
+    QTest::newRow("empty") << QByteArray() << QString();
+}
+
+void TestFileTypes::magicBytes()
+{
+    QFETCH(QByteArray, head);
+    QFETCH(QString, type);
+    QCOMPARE(fileTypeForContent(head, QString()).type, type);
+    QCOMPARE(typeOfBytes(head).type, type);
+}
+
+void TestFileTypes::legacyOfficeUsesSuffix()
+{
+    const QByteArray head("\xD0\xCF\x11\xE0\xA1\xB1\x1A\xE1\0\0\0\0", 12);
+    QCOMPARE(fileTypeForContent(head, "xls").type, QString("xls文档"));
+    QCOMPARE(fileTypeForContent(head, "PPT").type, QString("ppt文档"));
+    QCOMPARE(fileTypeForContent(head, QString()).type, QString("doc文档"));
+}
+
+void TestFileTypes::zipDirectory_data()
+{
+    QTest::addColumn<QByteArray>("zip");
+    QTest::addColumn<QString>("type");
+
+    // 第一个条目超过 4 KiB，文件开头看不到 Office 的目录名
+    const QByteArray padding(5000, 'x');
+    const QByteArray types("<Types/>");
+
+    QTest::newRow("docx") << makeZip({{"media/big.bin", padding}, {"[Content_Types].xml", types},
+                                      {"word/document.xml", "<w/>"}})
+                          << "doc文档";
+    QTest::newRow("xlsx") << makeZip({{"docProps/app.xml", padding}, {"xl/workbook.xml", "<x/>"},
+                                      {"[Content_Types].xml", types}})
+                          << "xls文档";
+    QTest::newRow("pptx") << makeZip({{"[Content_Types].xml", types}, {"a.bin", padding},
+                                      {"ppt/presentation.xml", "<p/>"}})
+                          << "ppt文档";
+    QTest::newRow("pptx with comment") << makeZip({{"a.bin", padding}, {"[Content_Types].xml", types},
+                                                   {"ppt/presentation.xml", "<p/>"}}, "archive comment")
+                                       << "ppt文档";
+    // 只有目录名而没有 [Content_Types].xml 的是普通 zip
+    QTest::newRow("plain zip with word/") << makeZip({{"word/readme.txt", "hello"}}) << "zip文件";
+    QTest::newRow("plain zip") << makeZip({{"a.txt", "hello"}, {"b.txt", padding}}) << "zip文件";
+}
+
+void TestFileTypes::zipDirectory()
+{
+    QFETCH(QByteArray, zip);
+    QFETCH(QString, type);
+    QCOMPARE(typeOfBytes(zip).type, type);
+}
+
+void TestFileTypes::zipWithoutDirectoryFallsBack()
+{
+    // 截掉目录结束记录后读不到中央目录，按文件开头的目录名粗略判断
+    QByteArray zip = makeZip({{"word/document.xml", "<w/>"}, {"[Content_Types].xml", "<Types/>"}});
+    zip.chop(22);
+    QCOMPARE(typeOfBytes(zip).type, QString("doc文档"));
+
+    QByteArray plain = makeZip({{"a.txt", "hello"}});
+    plain.chop(22);
+    QCOMPARE(typeOfBytes(plain).type, QString("zip文件"));
+}
+
+QTEST_GUILESS_MAIN(TestFileTypes)
+#include "tst_filetypes.moc"
@@ -0,0 +1,121 @@
+#include <QtTest>
+#include <thread>
+
+#include "trace.h"
+
+class TestTrace : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void ringBufferWraps();
+    void threadsHaveOwnBuffers();
+    void disabledSpansAreNotRecorded();
+    void activeSpansNest();
+};
+
+static QVector<TraceEvent> eventsNamed(const char *name)
+{
+    QVector<TraceEvent> found;
+    for (const TraceEvent &event : Trace::events()) {
+        if (qstrcmp(event.name, name) == 0) {
+            found.append(event);
+        }
+    }
+    return found;
+}
+
+void TestTrace::init()
+{
+    Trace::setEnabled(false);
+    Trace::clear();
+}
+
+void TestTrace::ringBufferWraps()
+{
+    // 写满后覆盖最旧的区间，导出的是最新的连续一段
+    const int total = Trace::BufferSize + 100;
+    for (int i = 0; i < total; ++i) {
+        Trace::record("test.wrap", i, 1);
+    }
+    const QVector<TraceEvent> events = eventsNamed("test.wrap");
+    QVERIFY(events.size() >= Trace::BufferSize - 1);
+    QVERIFY(events.size() <= Trace::BufferSize);
+    QCOMPARE(events.last().start, qint64(total - 1));
+    for (int i = 1; i < events.size(); ++i) {
+        QCOMPARE(events[i].start, events[i - 1].start + 1);
+    }
+    QCOMPARE(events.first().thread, Trace::currentThread());
+
+    Trace::clear();
+    QVERIFY(eventsNamed("test.wrap").isEmpty());
+}
+
+void TestTrace::threadsHaveOwnBuffers()
+{
+    for (int i = 0; i < Trace::BufferSize; ++i) {
+        Trace::record("test.main", i, 1);
+    }
+    int other = 0;
+    std::thread worker([&other]() {
+        other = Trace::currentThread();
+        for (int i = 0; i < 10; ++i) {
+            Trace::record("test.worker", i, 1);
+        }
+    });
+    worker.join();
+
+    // 其他线程写入不会挤掉本线程的区间
+    QVERIFY(eventsNamed("test.main").size() >= Trace::BufferSize - 1);
+    const QVector<TraceEvent> workerEvents = eventsNamed("test.worker");
+    QCOMPARE(workerEvents.size(), 10);
+    QCOMPARE(workerEvents.first().thread, other);
+    QVERIFY(other != Trace::currentThread());
+}
+
+void TestTrace::disabledSpansAreNotRecorded()
+{
+    {
+        TRACE_SCOPE("test.disabled");
+    }
+    QVERIFY(eventsNamed("test.disabled").isEmpty());
+
+    Trace::setEnabled(true);
+    {
+        TRACE_SCOPE("test.enabled");
+    }
+    Trace::setEnabled(false);
+    const QVector<TraceEvent> events = eventsNamed("test.enabled");
+    QCOMPARE(events.size(), 1);
+    QVERIFY(events.first().duration >= 0);
+}
+
+void TestTrace::activeSpansNest()
+{
+    Trace::setEnabled(true);
+    QVector<TraceEvent> active;
+    {
+        TRACE_SCOPE("test.outer");
+        {
+            TRACE_SCOPE("test.inner");
+            for (const TraceEvent &event : Trace::activeSpans()) {
+                if (event.thread == Trace::currentThread()) {
+                    active.append(event);
+                }
+            }
+        }
+    }
+    Trace::setEnabled(false);
+
+    // 由外向内排列，结束后出栈
+    QCOMPARE(active.size(), 2);
+    QCOMPARE(QByteArray(active[0].name), QByteArray("test.outer"));
+    QCOMPARE(QByteArray(active[1].name), QByteArray("test.inner"));
+    for (const TraceEvent &event : Trace::activeSpans()) {
+        QVERIFY(event.thread != Trace::currentThread());
+    }
+}
+
+QTEST_APPLESS_MAIN(TestTrace)
+#include "tst_trace.moc"
@@ -0,0 +1,204 @@
+#include <QtTest>
+
+#include "pathpattern.h"
+#include "treeengine.h"
+
+class TestTreeEngine : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void moveRejectsCycles();
+    void moveRejectsClashesAndFiles();
+    void moveKeepsRowsInOrder();
+    void removeRenumbersSiblings();
+    void renameRejectsClash();
+    void nameRules();
+    void splitPath();
+    void patternScope();
+    void patternMatching();
+    void findPath();
+};
+
+// createSample 的示例树（16 个节点），C盘/文件夹1 下另加一个 子文件夹
+struct SampleTree
+{
+    TreeEngine engine{1};
+    TreeNode *disk = nullptr;
+    TreeNode *folder1 = nullptr;
+    TreeNode *folder2 = nullptr;
+    TreeNode *child = nullptr;
+    TreeNode *file = nullptr;
+
+    SampleTree()
+    {
+        engine.createSample();
+        disk = engine.nodeAt({"C盘"});
+        folder1 = engine.nodeAt({"C盘", "文件夹1"});
+        folder2 = engine.nodeAt({"C盘", "文件夹2"});
+        child = engine.addFolder(folder1, "子文件夹");
+        file = engine.nodeAt({"C盘", "文件夹1", "文件.txt"});
+    }
+};
+
+void TestTreeEngine::moveRejectsCycles()
+{
+    SampleTree tree;
+    QVERIFY(tree.disk && tree.folder1 && tree.child);
+
+    // 不能移入自身或自己的后代，树保持不变
+    QVERIFY(!tree.engine.move(tree.folder1, tree.folder1));
+    QVERIFY(!tree.engine.move(tree.folder1, tree.child));
+    QVERIFY(!tree.engine.move(tree.disk, tree.child));
+    QCOMPARE(tree.child->parent(), tree.folder1);
+    QCOMPARE(tree.folder1->parent(), tree.disk);
+    QCOMPARE(tree.engine.count(), qint64(17));
+}
+
+void TestTreeEngine::moveRejectsClashesAndFiles()
+{
+    SampleTree tree;
+
+    // 文件夹2 下已有 文件.txt
+    QVERIFY(!tree.engine.move(tree.file, tree.folder2));
+    QCOMPARE(tree.file->parent(), tree.folder1);
+
+    // 目标不是文件夹
+    QVERIFY(!tree.engine.move(tree.child, tree.file));
+    QCOMPARE(tree.child->parent(), tree.folder1);
+
+    // 移回原处不算失败
+    QVERIFY(tree.engine.move(tree.child, tree.folder1));
+    QCOMPARE(tree.child->parent(), tree.folder1);
+}
+
+void TestTreeEngine::moveKeepsRowsInOrder()
+{
+    SampleTree tree;
+    TreeNode *a = tree.engine.addFile(tree.folder2, "a.txt");
+    TreeNode *b = tree.engine.addFile(tree.folder2, "b.txt");
+    QCOMPARE(a->row(), 1);
+    QCOMPARE(b->row(), 2);
+
+    QVERIFY(tree.engine.move(a, tree.folder1));
+    QCOMPARE(a->parent(), tree.folder1);
+    QCOMPARE(a->row(), tree.folder1->childCount() - 1);
+    QCOMPARE(tree.folder1->child(a->row()), a);
+    // 原文件夹中后面的节点前移
+    QCOMPARE(b->row(), 1);
+    QCOMPARE(tree.folder2->child(1), b);
+}
+
+void TestTreeEngine::removeRenumbersSiblings()
+{
+    SampleTree tree;
+    for (int i = 0; i < 5; ++i) {
+        QVERIFY(tree.engine.addFile(tree.folder2, QString("%1.txt").arg(i)));
+    }
+    tree.engine.remove(tree.folder2->child(2));
+    QCOMPARE(tree.folder2->childCount(), 5);
+    for (int i = 0; i < tree.folder2->childCount(); ++i) {
+        QCOMPARE(tree.folder2->child(i)->row(), i);
+    }
+
+    std::unique_ptr<TreeNode> taken = tree.folder2->child(0)->take();
+    QCOMPARE(taken->row(), -1);
+    QVERIFY(!taken->parent());
+    QCOMPARE(tree.folder2->child(0)->row(), 0);
+}
+
+void TestTreeEngine::renameRejectsClash()
+{
+    SampleTree tree;
+    QVERIFY(!tree.engine.rename(tree.folder1, "文件夹2"));
+    QCOMPARE(tree.folder1->name, QString("文件夹1"));
+    QVERIFY(tree.engine.rename(tree.folder1, "文件夹3"));
+    QVERIFY(TreeEngine::hasDuplicateName(tree.disk, "文件夹3"));
+    QVERIFY(!TreeEngine::hasDuplicateName(tree.disk, "文件夹1"));
+}
+
+void TestTreeEngine::nameRules()
+{
+    SampleTree tree;
+    TreeNode *lower = tree.engine.addFile(tree.folder2, "readme.txt");
+    // 仅大小写不同不算重名
+    TreeNode *upper = tree.engine.addFile(tree.folder2, "README.txt");
+    QVERIFY(lower && upper);
+    QVERIFY(!tree.engine.addFile(tree.folder2, "readme.txt"));
+
+    // 大小写完全相同的优先，否则取第一个仅大小写不同的
+    QCOMPARE(tree.engine.nodeAt({"C盘", "文件夹2", "README.txt"}), upper);
+    QCOMPARE(tree.engine.nodeAt({"C盘", "文件夹2", "readme.txt"}), lower);
+    QCOMPARE(tree.engine.nodeAt({"c盘", "文件夹2", "Readme.TXT"}), lower);
+
+    QCOMPARE(tree.engine.find("readme", tree.folder2).size(), size_t(2));
+}
+
+void TestTreeEngine::splitPath()
+{
+    QCOMPARE(PathPattern::splitPath(" C盘 //文件夹1/ a.txt /"), QStringList({"C盘", "文件夹1", "a.txt"}));
+    QVERIFY(PathPattern::splitPath("///").isEmpty());
+}
+
+void TestTreeEngine::patternScope()
+{
+    PathPattern pattern("C盘/文件夹1/**/*.txt");
+    QCOMPARE(pattern.scope(), QStringList({"C盘", "文件夹1"}));
+    QVERIFY(!pattern.isLiteral());
+    QVERIFY(pattern.isValid());
+
+    PathPattern literal("C盘/文件夹1");
+    QVERIFY(literal.isLiteral());
+
+    // 第一个通配级之后的各级都参与匹配，即使不含通配符
+    PathPattern mixed("C盘/*/文件.txt");
+    QCOMPARE(mixed.scope(), QStringList({"C盘"}));
+}
+
+void TestTreeEngine::patternMatching()
+{
+    auto matches = [](const QString &query, const QStringList &names) {
+        PathPattern pattern(query);
+        quint64 state = pattern.start();
+        for (const QString &name : names) {
+            state = pattern.advance(state, name);
+            if (!state) return false;
+        }
+        return pattern.matches(state);
+    };
+
+    QVERIFY(matches("*.txt", {"a.txt"}));
+    QVERIFY(matches("*.TXT", {"a.txt"}));
+    QVERIFY(!matches("*.txt", {"a.pdf"}));
+    QVERIFY(!matches("*.txt", {"sub", "a.txt"}));
+    QVERIFY(matches("?.txt", {"a.txt"}));
+    QVERIFY(!matches("?.txt", {"ab.txt"}));
+
+    // ** 匹配零级或任意多级
+    QVERIFY(matches("**/*.txt", {"a.txt"}));
+    QVERIFY(matches("**/*.txt", {"x", "y", "a.txt"}));
+    QVERIFY(matches("*/**/b", {"a", "b"}));
+    QVERIFY(matches("*/**/b", {"a", "x", "y", "b"}));
+    QVERIFY(!matches("*/**/b", {"b"}));
+}
+
+void TestTreeEngine::findPath()
+{
+    TreeEngine engine(1);
+    engine.createSample();
+
+    QCOMPARE(engine.findPath("C盘/**/*.txt").size(), size_t(2));
+    QCOMPARE(engine.findPath("**/文件.txt").size(), size_t(6));
+    QCOMPARE(engine.findPath("C盘/文件夹?").size(), size_t(2));
+    QVERIFY(engine.findPath("F盘/**").empty());
+
+    // 结果按先序排列
+    const std::vector<TreeNode*> found = engine.findPath("*/*/文件夹1");
+    QCOMPARE(found.size(), size_t(3));
+    QCOMPARE(found[0]->parent()->name, QString("C盘"));
+    QCOMPARE(found[1]->parent()->name, QString("D盘"));
+    QCOMPARE(found[2]->parent()->name, QString("E盘"));
+}
+
+QTEST_GUILESS_MAIN(TestTreeEngine)
+#include "tst_treeengine.moc"
@@ -0,0 +1,207 @@
+#include <QtTest>
+#include <QtEndian>
+
+#include "treecommands.h"
+#include "treeengine.h"
+#include "treeprotocol.h"
+
+using namespace TreeProtocol;
+
+class TestTreeProtocol : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void requestRoundTrip();
+    void replyRoundTrip();
+    void decodeRejectsBadFrames();
+    void takeFrameWaitsForWholeFrame();
+    void takeFrameRejectsOversize();
+    void parseCommand_data();
+    void parseCommand();
+    void readAndWrite();
+};
+
+static QByteArray body(const QByteArray &encoded)
+{
+    QByteArray buffer = encoded;
+    QByteArray frame;
+    bool tooLarge = false;
+    if (!takeFrame(buffer, &frame, &tooLarge) || !buffer.isEmpty()) return QByteArray();
+    return frame;
+}
+
+void TestTreeProtocol::requestRoundTrip()
+{
+    Request request;
+    request.id = 0xDEADBEEF;
+    request.flags = ContinueOnError;
+    request.ops.append(Operation{MkdirParents, {"C盘/新建/子目录"}});
+    request.ops.append(Operation{Touch, {"C盘/新建/a.txt", "/tmp/a.txt"}});
+    request.ops.append(Operation{Count, {}});
+
+    Request decoded;
+    QVERIFY(decode(body(encode(request)), &decoded));
+    QCOMPARE(decoded.id, request.id);
+    QCOMPARE(decoded.flags, request.flags);
+    QCOMPARE(decoded.ops.size(), 3);
+    for (int i = 0; i < 3; ++i) {
+        QCOMPARE(decoded.ops[i].code, request.ops[i].code);
+        QCOMPARE(decoded.ops[i].args, request.ops[i].args);
+    }
+    QVERIFY(!decoded.isReadOnly());
+
+    Request readOnly;
+    readOnly.ops.append(Operation{Stat, {"C盘"}});
+    readOnly.ops.append(Operation{Find, {"*.txt"}});
+    QVERIFY(readOnly.isReadOnly());
+}
+
+void TestTreeProtocol::replyRoundTrip()
+{
+    Reply reply;
+    reply.id = 7;
+    Result ok;
+    ok.value = 42;
+    ok.records.append(Record{"我的电脑/C盘/文件.txt", "txt文件", "/home/a.txt", QString(), 0});
+    ok.records.append(Record{"我的电脑/C盘", "驱动器", QString(), QString(), 2});
+    reply.results.append(ok);
+    reply.results.append(Result{Failed, "找不到 X", 0, {}});
+    reply.results.append(Result{Skipped, QString(), 0, {}});
+
+    Reply decoded;
+    QVERIFY(decode(body(encode(reply)), &decoded));
+    QCOMPARE(decoded.id, quint32(7));
+    QCOMPARE(decoded.results.size(), 3);
+    QCOMPARE(decoded.results[0].status, quint8(Ok));
+    QCOMPARE(decoded.results[0].value, qint64(42));
+    QCOMPARE(decoded.results[0].records.size(), 2);
+    QCOMPARE(decoded.results[0].records[0].path, QString("我的电脑/C盘/文件.txt"));
+    QCOMPARE(decoded.results[0].records[0].realPath, QString("/home/a.txt"));
+    QCOMPARE(decoded.results[0].records[1].type, QString("驱动器"));
+    QCOMPARE(decoded.results[0].records[1].children, quint32(2));
+    QCOMPARE(decoded.results[1].status, quint8(Failed));
+    QCOMPARE(decoded.results[1].message, QString("找不到 X"));
+    QCOMPARE(decoded.results[2].status, quint8(Skipped));
+}
+
+void TestTreeProtocol::decodeRejectsBadFrames()
+{
+    Request request;
+    request.id = 1;
+    request.ops.append(Operation{Stat, {"C盘"}});
+    const QByteArray frame = body(encode(request));
+
+    Request decoded;
+    QVERIFY(!decode(frame.left(frame.size() - 1), &decoded));
+    QVERIFY(!decode(frame + char(0), &decoded));
+    QVERIFY(!decode(QByteArray(), &decoded));
+}
+
+void TestTreeProtocol::takeFrameWaitsForWholeFrame()
+{
+    Request first;
+    first.id = 1;
+    first.ops.append(Operation{Stat, {"C盘"}});
+    Request second;
+    second.id = 2;
+    second.ops.append(Operation{List, {"D盘"}});
+    const QByteArray stream = encode(first) + encode(second);
+
+    // 按字节逐个到达，只有收齐一帧时才取出，且不改动缓冲区
+    QByteArray buffer;
+    QList<quint32> ids;
+    for (char byte : stream) {
+        buffer.append(byte);
+        QByteArray frame;
+        bool tooLarge = false;
+        const QByteArray before = buffer;
+        if (takeFrame(buffer, &frame, &tooLarge)) {
+            Request decoded;
+            QVERIFY(decode(frame, &decoded));
+            ids.append(decoded.id);
+        } else {
+            QVERIFY(!tooLarge);
+            QCOMPARE(buffer, before);
+        }
+    }
+    QCOMPARE(ids, QList<quint32>({1, 2}));
+    QVERIFY(buffer.isEmpty());
+}
+
+void TestTreeProtocol::takeFrameRejectsOversize()
+{
+    QByteArray buffer(4, Qt::Uninitialized);
+    qToBigEndian<quint32>(MaxFrame + 1, buffer.data());
+    QByteArray frame;
+    bool tooLarge = false;
+    QVERIFY(!takeFrame(buffer, &frame, &tooLarge));
+    QVERIFY(tooLarge);
+
+    // 恰好等于上限时只是数据不完整
+    qToBigEndian<quint32>(MaxFrame, buffer.data());
+    QVERIFY(!takeFrame(buffer, &frame, &tooLarge));
+    QVERIFY(!tooLarge);
+}
+
+void TestTreeProtocol::parseCommand_data()
+{
+    QTest::addColumn<QStringList>("words");
+    QTest::addColumn<bool>("ok");
+    QTest::addColumn<int>("code");
+    QTest::addColumn<QStringList>("args");
+
+    QTest::newRow("mkdir") << QStringList{"mkdir", "a/b"} << true << int(Mkdir) << QStringList{"a/b"};
+    QTest::newRow("mkdir -p") << QStringList{"mkdir", "-p", "a/b"} << true << int(MkdirParents) << QStringList{"a/b"};
+    QTest::newRow("rm -r") << QStringList{"rm", "-r", "a"} << true << int(RemoveRecursive) << QStringList{"a"};
+    QTest::newRow("touch bound") << QStringList{"touch", "a.txt", "/tmp/a"} << true << int(Touch)
+                                 << QStringList{"a.txt", "/tmp/a"};
+    QTest::newRow("count all") << QStringList{"count"} << true << int(Count) << QStringList();
+    QTest::newRow("mv missing target") << QStringList{"mv", "a"} << false << 0 << QStringList();
+    QTest::newRow("ls too many") << QStringList{"ls", "a", "b"} << false << 0 << QStringList();
+    QTest::newRow("unknown") << QStringList{"frobnicate"} << false << 0 << QStringList();
+    QTest::newRow("empty") << QStringList() << false << 0 << QStringList();
+}
+
+void TestTreeProtocol::parseCommand()
+{
+    QFETCH(QStringList, words);
+    QFETCH(bool, ok);
+    QFETCH(int, code);
+    QFETCH(QStringList, args);
+
+    Operation op;
+    QString error;
+    QCOMPARE(TreeProtocol::parseCommand(words, &op, &error), ok);
+    if (ok) {
+        QCOMPARE(int(op.code), code);
+        QCOMPARE(op.args, args);
+    } else {
+        QVERIFY(!error.isEmpty());
+    }
+}
+
+void TestTreeProtocol::readAndWrite()
+{
+    TreeEngine engine(1);
+    engine.createSample();
+    TreeCommands commands(engine);
+
+    Result stat = TreeProtocol::read(engine, Operation{Stat, {"C盘"}});
+    QCOMPARE(stat.status, quint8(Ok));
+    QCOMPARE(stat.records.size(), 1);
+    QCOMPARE(stat.records[0].type, QString("驱动器"));
+    QCOMPARE(stat.records[0].children, quint32(2));
+    QCOMPARE(stat.value, qint64(5));
+
+    QCOMPARE(TreeProtocol::write(commands, Operation{MkdirParents, {"C盘/新建/子目录"}}).status, quint8(Ok));
+    QCOMPARE(TreeProtocol::read(engine, Operation{Count, {"C盘"}}).value, qint64(6));
+    QCOMPARE(TreeProtocol::read(engine, Operation{Find, {"C盘/**/子目录"}}).records.size(), 1);
+
+    QCOMPARE(TreeProtocol::read(engine, Operation{Stat, {"F盘"}}).status, quint8(Failed));
+    QCOMPARE(TreeProtocol::read(engine, Operation{Stat, {}}).status, quint8(BadRequest));
+    QCOMPARE(TreeProtocol::write(commands, Operation{Move, {"C盘/新建"}}).status, quint8(BadRequest));
+}
+
+QTEST_GUILESS_MAIN(TestTreeProtocol)
+#include "tst_treeprotocol.moc"
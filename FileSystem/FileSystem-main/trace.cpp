@@ -0,0 +1,234 @@
+#include "trace.h"
+
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> Trace::s_enabled(false);
+const std::chrono::steady_clock::time_point Trace::s_epoch = std::chrono::steady_clock::now();
+
+namespace {
+
+// 单个线程的环形缓冲区：只有所属线程写入，导出时其他线程读取。
+// 各字段都是原子量（在常见平台上就是普通的读写），读取方按 head 判断哪些槽位在复制期间可能被覆盖。
+struct Slot
+{
+    std::atomic<const char*> name{nullptr};
+    std::atomic<qint64> start{0};
+    std::atomic<qint64> duration{0};
+    std::atomic<int> thread{0};
+};
+
+struct OpenSpan
+{
+    std::atomic<const char*> name{nullptr};
+    std::atomic<qint64> start{0};
+};
+
+struct ThreadBuffer
+{
+    Slot slots[Trace::BufferSize];
+    std::atomic<quint64> head{0};   // 已写入的区间总数
+    std::atomic<int> thread{0};
+    OpenSpan open[Trace::MaxDepth]; // 尚未结束的区间，超过 MaxDepth 层的只计层数
+    std::atomic<int> depth{0};
+};
+
+// 全部缓冲区只在线程第一次记录和导出时加锁访问。
+// 线程退出后缓冲区不释放，留给之后新建的线程复用，后台任务频繁创建线程时内存不会增长。
+struct Registry
+{
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    std::vector<ThreadBuffer*> idle;
+    int nextThread = 1;
+};
+
+Registry &registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+struct ThreadSlot
+{
+    ThreadBuffer *buffer = nullptr;
+
+    ~ThreadSlot()
+    {
+        if (!buffer) return;
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.idle.push_back(buffer);
+    }
+};
+
+ThreadBuffer *currentBuffer()
+{
+    thread_local ThreadSlot slot;
+    if (!slot.buffer) {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        if (!r.idle.empty()) {
+            slot.buffer = r.idle.back();
+            r.idle.pop_back();
+        } else {
+            r.buffers.push_back(std::make_unique<ThreadBuffer>());
+            slot.buffer = r.buffers.back().get();
+        }
+        // 复用的缓冲区中保留旧线程的区间，新区间以新的线程序号写入
+        slot.buffer->thread.store(r.nextThread++, std::memory_order_relaxed);
+    }
+    return slot.buffer;
+}
+
+}
+
+void Trace::setEnabled(bool enabled)
+{
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+qint64 Trace::begin(const char *name)
+{
+    ThreadBuffer *buffer = currentBuffer();
+    const qint64 start = now();
+    const int depth = buffer->depth.load(std::memory_order_relaxed);
+    if (depth < MaxDepth) {
+        buffer->open[depth].name.store(name, std::memory_order_relaxed);
+        buffer->open[depth].start.store(start, std::memory_order_relaxed);
+    }
+    buffer->depth.store(depth + 1, std::memory_order_release);
+    return start;
+}
+
+void Trace::end(const char *name, qint64 start)
+{
+    const qint64 finish = now();
+    ThreadBuffer *buffer = currentBuffer();
+    buffer->depth.store(std::max(0, buffer->depth.load(std::memory_order_relaxed) - 1), std::memory_order_release);
+    record(name, start, finish - start);
+}
+
+QVector<TraceEvent> Trace::activeSpans()
+{
+    QVector<TraceEvent> out;
+    const qint64 current = now();
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (const auto &buffer : r.buffers) {
+        const int depth = std::min(buffer->depth.load(std::memory_order_acquire), int(MaxDepth));
+        for (int i = 0; i < depth; ++i) {
+            TraceEvent event;
+            event.name = buffer->open[i].name.load(std::memory_order_relaxed);
+            event.start = buffer->open[i].start.load(std::memory_order_relaxed);
+            event.duration = current - event.start;
+            event.thread = buffer->thread.load(std::memory_order_relaxed);
+            if (event.name) out.append(event);
+        }
+    }
+    return out;
+}
+
+int Trace::currentThread()
+{
+    return currentBuffer()->thread.load(std::memory_order_relaxed);
+}
+
+void Trace::record(const char *name, qint64 start, qint64 duration)
+{
+    ThreadBuffer *buffer = currentBuffer();
+    const quint64 head = buffer->head.load(std::memory_order_relaxed);
+    Slot &slot = buffer->slots[head % BufferSize];
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.start.store(start, std::memory_order_relaxed);
+    slot.duration.store(duration, std::memory_order_relaxed);
+    slot.thread.store(buffer->thread.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+QVector<TraceEvent> Trace::events()
+{
+    QVector<TraceEvent> out;
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (const auto &buffer : r.buffers) {
+        const quint64 head = buffer->head.load(std::memory_order_acquire);
+        const quint64 first = head > quint64(BufferSize) ? head - BufferSize : 0;
+        QVector<TraceEvent> copied;
+        for (quint64 i = first; i < head; ++i) {
+            const Slot &slot = buffer->slots[i % BufferSize];
+            TraceEvent event;
+            event.name = slot.name.load(std::memory_order_relaxed);
+            event.start = slot.start.load(std::memory_order_relaxed);
+            event.duration = slot.duration.load(std::memory_order_relaxed);
+            event.thread = slot.thread.load(std::memory_order_relaxed);
+            copied.append(event);
+        }
+        // 复制期间写入方可能已经绕过一圈，被覆盖的槽位内容不完整，丢弃
+        const quint64 after = buffer->head.load(std::memory_order_acquire);
+        const quint64 valid = after > quint64(BufferSize) ? after - BufferSize + 1 : 0;
+        const int skip = int(std::min<quint64>(valid > first ? valid - first : 0, copied.size()));
+        for (int i = skip; i < copied.size(); ++i) {
+            if (copied[i].name) out.append(copied[i]);
+        }
+    }
+    std::sort(out.begin(), out.end(), [](const TraceEvent &a, const TraceEvent &b) {
+        return a.start < b.start;
+    });
+    return out;
+}
+
+QByteArray Trace::toChromeJson()
+{
+    const qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray traceEvents;
+    QJsonObject process;
+    process["name"] = "process_name";
+    process["ph"] = "M";
+    process["pid"] = pid;
+    process["args"] = QJsonObject{{"name", QCoreApplication::applicationName()}};
+    traceEvents.append(process);
+
+    // 时间单位为微秒
+    for (const TraceEvent &event : events()) {
+        QJsonObject obj;
+        obj["name"] = QString::fromUtf8(event.name);
+        obj["cat"] = "filesys";
+        obj["ph"] = "X";
+        obj["ts"] = event.start / 1000.0;
+        obj["dur"] = event.duration / 1000.0;
+        obj["pid"] = pid;
+        obj["tid"] = event.thread;
+        traceEvents.append(obj);
+    }
+    QJsonObject root;
+    root["traceEvents"] = traceEvents;
+    root["displayTimeUnit"] = "ms";
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+bool Trace::writeChromeJson(const QString &fileName)
+{
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    file.write(toChromeJson());
+    return file.commit();
+}
+
+void Trace::clear()
+{
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (const auto &buffer : r.buffers) {
+        for (Slot &slot : buffer->slots) {
+            slot.name.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+}
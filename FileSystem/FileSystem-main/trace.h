@@ -0,0 +1,81 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <chrono>
+
+// 一段已结束的跟踪区间
+struct TraceEvent
+{
+    const char *name = nullptr;
+    qint64 start = 0;       // 纳秒，相对于进程内第一次取时间
+    qint64 duration = 0;    // 纳秒
+    int thread = 0;         // 从 1 开始的线程序号
+};
+
+// 内置跟踪
+// 用 TRACE_SCOPE("名称") 标记一段代码，结束时写入当前线程自己的环形缓冲区（写入无锁，满了覆盖最旧的），
+// 可随时导出为 Chrome trace-event JSON，在 chrome://tracing 或 Perfetto 中查看。
+// 未启用时每个区间只有一次原子读取的开销。名称必须是字符串字面量，只保存指针。
+// 设置环境变量 FILESYS_TRACE=文件名 时程序启动即启用，退出时写出到该文件。
+class Trace
+{
+public:
+    static constexpr int BufferSize = 8192;     // 每个线程保留的区间数
+    static constexpr int MaxDepth = 32;         // 每个线程可查看的嵌套区间层数
+
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+    static void setEnabled(bool enabled);
+
+    static qint64 now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now() - s_epoch).count();
+    }
+
+    // 区间开始时入栈、结束时出栈并记录，栈中是各线程正在执行的区间
+    static qint64 begin(const char *name);
+    static void end(const char *name, qint64 start);
+    static void record(const char *name, qint64 start, qint64 duration);
+
+    // 各线程尚未结束的区间，由外向内排列，duration 为到目前为止的耗时；可在任意线程调用
+    static QVector<TraceEvent> activeSpans();
+    // 当前线程在跟踪记录中的序号
+    static int currentThread();
+
+    // 各线程缓冲区中的全部区间，按开始时间排序
+    static QVector<TraceEvent> events();
+    static QByteArray toChromeJson();
+    static bool writeChromeJson(const QString &fileName);
+    static void clear();
+
+private:
+    static std::atomic<bool> s_enabled;
+    static const std::chrono::steady_clock::time_point s_epoch;
+};
+
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char *name)
+        : m_name(Trace::isEnabled() ? name : nullptr), m_start(m_name ? Trace::begin(m_name) : 0) {}
+    ~TraceSpan()
+    {
+        if (m_name) Trace::end(m_name, m_start);
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+private:
+    const char *m_name;
+    qint64 m_start;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceSpan TRACE_CONCAT(traceSpan_, __LINE__)(name)
+
+#endif // TRACE_H
@@ -0,0 +1,243 @@
+#include "treecommands.h"
+#include "treeengine.h"
+#include "pathpattern.h"
+
+QStringList TreeCommands::components(const TreeNode *node)
+{
+    QStringList names;
+    for (const TreeNode *p = node; p && p->parent(); p = p->parent()) {
+        names.prepend(p->name);
+    }
+    return names;
+}
+
+bool TreeCommands::isFixed(const TreeNode *node)
+{
+    return node->type == "system" || node->type == "驱动器";
+}
+
+TreeNode *TreeCommands::resolve(const QString &path, QString *error) const
+{
+    TreeNode *node = m_engine.nodeAt(PathPattern::splitPath(path));
+    if (!node) *error = "找不到 " + path;
+    return node;
+}
+
+TreeNode *TreeCommands::resolveParent(const QString &path, QString *name, QString *error) const
+{
+    QStringList parts = PathPattern::splitPath(path);
+    if (parts.size() < 2) {
+        *error = "路径缺少上级：" + path;
+        return nullptr;
+    }
+    *name = parts.takeLast();
+    TreeNode *parent = m_engine.nodeAt(parts);
+    if (!parent || !parent->isFolder()) {
+        *error = "上级不存在或不是文件夹：" + parts.join('/');
+        return nullptr;
+    }
+    return parent;
+}
+
+void TreeCommands::inserted(const TreeNode *node)
+{
+    if (!m_changes) return;
+    TreeChange change;
+    change.kind = TreeChange::Insert;
+    change.path = components(node->parent());
+    change.node = node;
+    m_changes->append(change);
+}
+
+void TreeCommands::moved(const QStringList &before, const TreeNode *node)
+{
+    if (!m_changes) return;
+    TreeChange change;
+    change.kind = TreeChange::Move;
+    change.path = before;
+    change.target = components(node->parent());
+    change.name = node->name;
+    m_changes->append(change);
+}
+
+bool TreeCommands::mkdir(const QString &path, bool parents, QString *error)
+{
+    if (!parents) {
+        QString name;
+        TreeNode *parent = resolveParent(path, &name, error);
+        if (!parent) return false;
+        TreeNode *folder = m_engine.addFolder(parent, name);
+        if (!folder) {
+            *error = "已存在 " + path;
+            return false;
+        }
+        inserted(folder);
+        return true;
+    }
+    // 找到已存在的最长前缀，再逐级创建其余部分；新建的各级作为一棵子树记一次修改
+    const QStringList parts = PathPattern::splitPath(path);
+    int existing = parts.size();
+    TreeNode *node = nullptr;
+    while (existing > 0 && !(node = m_engine.nodeAt(parts.mid(0, existing)))) {
+        --existing;
+    }
+    if (!node) {
+        *error = "找不到上级：" + path;
+        return false;
+    }
+    TreeNode *created = nullptr;
+    for (int i = existing; i < parts.size(); ++i) {
+        TreeNode *child = m_engine.addFolder(node, parts[i]);
+        if (!child) {
+            if (created) inserted(created);
+            *error = "无法在 " + pathOf(node) + " 下创建 " + parts[i];
+            return false;
+        }
+        if (!created) created = child;
+        node = child;
+    }
+    if (created) inserted(created);
+    if (!node->isFolder()) {
+        *error = "已存在同名文件 " + path;
+        return false;
+    }
+    return true;
+}
+
+bool TreeCommands::touch(const QString &path, const QString &realPath, QString *error)
+{
+    QString name;
+    TreeNode *parent = resolveParent(path, &name, error);
+    if (!parent) return false;
+    if (TreeEngine::hasDuplicateName(parent, name)) return true;
+    TreeNode *file = m_engine.addFile(parent, name, realPath);
+    if (!file) {
+        *error = "无法创建 " + path;
+        return false;
+    }
+    inserted(file);
+    return true;
+}
+
+bool TreeCommands::move(const QString &source, const QString &target, QString *error)
+{
+    return moveOrCopy(source, target, false, error);
+}
+
+bool TreeCommands::copy(const QString &source, const QString &target, QString *error)
+{
+    return moveOrCopy(source, target, true, error);
+}
+
+bool TreeCommands::moveOrCopy(const QString &source, const QString &target, bool copy, QString *error)
+{
+    TreeNode *node = resolve(source, error);
+    if (!node) return false;
+    if (isFixed(node)) {
+        *error = "不能移动或复制 " + node->name;
+        return false;
+    }
+
+    TreeNode *folder = m_engine.nodeAt(PathPattern::splitPath(target));
+    QString name = node->name;
+    if (!folder || !folder->isFolder()) {
+        if (folder) {
+            *error = "目标已存在 " + target;
+            return false;
+        }
+        folder = resolveParent(target, &name, error);
+        if (!folder) return false;
+    }
+    if (TreeEngine::hasDuplicateName(folder, name)) {
+        *error = "目标文件夹中已存在 " + name;
+        return false;
+    }
+
+    if (copy) {
+        std::unique_ptr<TreeNode> duplicate = m_engine.copy(node);
+        duplicate->name = name;
+        TreeNode *added = m_engine.insert(folder, std::move(duplicate));
+        if (!added) {
+            *error = "无法复制到 " + target;
+            return false;
+        }
+        inserted(added);
+        return true;
+    }
+    for (const TreeNode *p = folder; p; p = p->parent()) {
+        if (p == node) {
+            *error = "不能移入自身或其子文件夹";
+            return false;
+        }
+    }
+    if (name == node->name && folder == node->parent()) return true;
+
+    const QStringList before = components(node);
+    // 改名和移动分两步，先做不会与现有名称冲突的一步
+    bool ok;
+    if (name == node->name) {
+        ok = m_engine.move(node, folder);
+    } else if (!TreeEngine::hasDuplicateName(folder, node->name)) {
+        ok = m_engine.move(node, folder) && m_engine.rename(node, name);
+    } else if (!m_engine.rename(node, name)) {
+        *error = "原文件夹中已存在 " + name;
+        return false;
+    } else {
+        ok = m_engine.move(node, folder);
+    }
+    if (!ok) {
+        *error = "无法移动到 " + target;
+        return false;
+    }
+    moved(before, node);
+    return true;
+}
+
+bool TreeCommands::remove(const QString &path, bool recursive, QString *error)
+{
+    TreeNode *node = resolve(path, error);
+    if (!node) return false;
+    if (isFixed(node)) {
+        *error = "不能删除 " + node->name;
+        return false;
+    }
+    if (node->hasChildren() && !recursive) {
+        *error = "文件夹非空，删除需要 -r：" + path;
+        return false;
+    }
+    if (m_changes) {
+        TreeChange change;
+        change.kind = TreeChange::Remove;
+        change.path = components(node);
+        m_changes->append(change);
+    }
+    m_engine.remove(node);
+    return true;
+}
+
+bool TreeCommands::rename(const QString &path, const QString &name, QString *error)
+{
+    TreeNode *node = resolve(path, error);
+    if (!node) return false;
+    if (isFixed(node)) {
+        *error = "不能重命名 " + node->name;
+        return false;
+    }
+    if (name.isEmpty() || name.contains('/')) {
+        *error = "名称不能为空或包含 /";
+        return false;
+    }
+    if (name == node->name) return true;
+    const QStringList before = components(node);
+    if (!m_engine.rename(node, name)) {
+        *error = "同一文件夹中已存在 " + name;
+        return false;
+    }
+    moved(before, node);
+    return true;
+}
+
+std::vector<TreeNode*> TreeCommands::find(const QString &query) const
+{
+    return query.contains('/') ? m_engine.findPath(query) : m_engine.find(query);
+}
@@ -0,0 +1,67 @@
+#ifndef TREECOMMANDS_H
+#define TREECOMMANDS_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <vector>
+
+class TreeEngine;
+class TreeNode;
+
+// 命令对树结构的一次修改，界面等持有同一棵树副本的一方按同样的方式修改自己的副本
+struct TreeChange
+{
+    enum Kind { Insert, Remove, Move };
+    Kind kind = Insert;
+    QStringList path;               // Insert：新节点的上级；Remove、Move：节点修改前的路径
+    QStringList target;             // Move：新的上级
+    QString name;                   // Move：新的名称
+    const TreeNode *node = nullptr; // Insert：新节点（含整棵子树），只在下一条命令执行前有效
+};
+
+// 按路径执行的树命令，命令行工具和本地服务共用
+// 路径以 / 分隔，可省略顶层的“我的电脑”。失败时返回 false 并给出原因，树保持不变；
+// 设置了 changes 时把成功的修改追加到其中，路径都从顶层节点写起。
+class TreeCommands
+{
+public:
+    explicit TreeCommands(TreeEngine &engine) : m_engine(engine) {}
+
+    void setChanges(QVector<TreeChange> *changes) { m_changes = changes; }
+
+    // 新建文件夹，parents 时同时创建缺少的上级，已存在时不算失败
+    bool mkdir(const QString &path, bool parents, QString *error);
+    // 新建文件，类型按后缀判断，可绑定真实文件；已存在时不做任何事
+    bool touch(const QString &path, const QString &realPath, QString *error);
+    // 目标是已有文件夹时移入其中，否则移到目标的上级并改名为目标的最后一级
+    bool move(const QString &source, const QString &target, QString *error);
+    // 同 move，复制整棵子树
+    bool copy(const QString &source, const QString &target, QString *error);
+    // 删除，非空文件夹需要 recursive
+    bool remove(const QString &path, bool recursive, QString *error);
+    bool rename(const QString &path, const QString &name, QString *error);
+
+    TreeNode *resolve(const QString &path, QString *error) const;
+    // 名称包含关键字的节点；含 / 时按路径模式匹配，如 "C盘/**/*.txt"
+    std::vector<TreeNode*> find(const QString &query) const;
+
+    // 各级名称，从顶层节点开始
+    static QStringList components(const TreeNode *node);
+    // 各级名称用 / 连接，可直接作为命令的路径参数
+    static QString pathOf(const TreeNode *node) { return components(node).join('/'); }
+    // “我的电脑”和驱动器不能移动、复制或删除
+    static bool isFixed(const TreeNode *node);
+
+private:
+    // 路径的上级节点和最后一级名称
+    TreeNode *resolveParent(const QString &path, QString *name, QString *error) const;
+    bool moveOrCopy(const QString &source, const QString &target, bool copy, QString *error);
+    void inserted(const TreeNode *node);
+    void moved(const QStringList &before, const TreeNode *node);
+
+    TreeEngine &m_engine;
+    QVector<TreeChange> *m_changes = nullptr;
+};
+
+#endif // TREECOMMANDS_H
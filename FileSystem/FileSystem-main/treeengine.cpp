@@ -0,0 +1,480 @@
+#include "treeengine.h"
+#include "filetypes.h"
+#include "pathpattern.h"
+#include "trace.h"
+#include "counters.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QVector>
+#include <algorithm>
+
+static Counter s_loadMs("engine.load_ms", "引擎上次加载耗时", Counter::Milliseconds);
+static Counter s_saveMs("engine.save_ms", "引擎上次保存耗时", Counter::Milliseconds);
+
+TreeNode *TreeNode::append(std::unique_ptr<TreeNode> node)
+{
+    node->m_parent = this;
+    node->m_row = static_cast<int>(m_children.size());
+    m_children.push_back(std::move(node));
+    return m_children.back().get();
+}
+
+std::unique_ptr<TreeNode> TreeNode::take()
+{
+    if (!m_parent) return nullptr;
+    auto &siblings = m_parent->m_children;
+    auto it = siblings.begin() + m_row;
+    std::unique_ptr<TreeNode> self = std::move(*it);
+    it = siblings.erase(it);
+    // 后面的兄弟节点前移一行
+    for (; it != siblings.end(); ++it) {
+        --(*it)->m_row;
+    }
+    m_parent = nullptr;
+    m_row = -1;
+    return self;
+}
+
+TreeEngine::TreeEngine(int threads, int serialLimit)
+    : m_walker(threads, serialLimit)
+{
+    m_root.type = "system";
+}
+
+void TreeEngine::clear()
+{
+    m_root.m_children.clear();
+    resetUsage();
+}
+
+void TreeEngine::nodeChildren(const TreeNode *node, std::vector<const TreeNode*> &out)
+{
+    for (int i = 0; i < node->childCount(); ++i) {
+        out.push_back(node->child(i));
+    }
+}
+
+TreeNode *TreeEngine::addFolder(TreeNode *parent, const QString &name)
+{
+    auto node = std::make_unique<TreeNode>();
+    node->name = name;
+    node->type = "文件夹";
+    node->icon = "treeItem_Project";
+    return insert(parent, std::move(node));
+}
+
+TreeNode *TreeEngine::addFile(TreeNode *parent, const QString &name, const QString &path)
+{
+    const FileTypeInfo info = fileTypeForSuffix(QFileInfo(name).suffix());
+    auto node = std::make_unique<TreeNode>();
+    node->name = name;
+    node->type = info.type;
+    node->icon = info.iconKey;
+    node->path = path;
+    return insert(parent, std::move(node));
+}
+
+TreeNode *TreeEngine::insert(TreeNode *parent, std::unique_ptr<TreeNode> node)
+{
+    if (!parent || !node || !parent->isFolder()) return nullptr;
+    if (node->name.isEmpty() || hasDuplicateName(parent, node->name)) return nullptr;
+    TreeNode *added = parent->append(std::move(node));
+    if (m_usageValid) {
+        addUsage(parent, buildUsage(added));
+    }
+    return added;
+}
+
+bool TreeEngine::rename(TreeNode *node, const QString &name)
+{
+    if (!node || !node->parent() || name.isEmpty()) return false;
+    if (node->name == name) return true;
+    if (hasDuplicateName(node->parent(), name)) return false;
+    const MemoryUsage before = nodeUsage(node);
+    node->name = name;
+    if (m_usageValid) {
+        const MemoryUsage delta = nodeUsage(node) - before;
+        auto it = m_usage.find(node);
+        if (it != m_usage.end()) *it += delta;
+        addUsage(node->parent(), delta);
+    }
+    return true;
+}
+
+bool TreeEngine::move(TreeNode *node, TreeNode *folder)
+{
+    if (!node || !node->parent() || !folder || !folder->isFolder()) return false;
+    if (folder == node->parent()) return true;
+    // 不能移入自身或自己的后代
+    for (const TreeNode *p = folder; p; p = p->parent()) {
+        if (p == node) return false;
+    }
+    if (hasDuplicateName(folder, node->name)) return false;
+    const MemoryUsage usage = m_usageValid ? memoryUsage(node) : MemoryUsage();
+    addUsage(node->parent(), -usage);
+    folder->append(node->take());
+    addUsage(folder, usage);
+    return true;
+}
+
+void TreeEngine::remove(TreeNode *node)
+{
+    if (node && node->parent()) {
+        if (m_usageValid) {
+            const MemoryUsage usage = memoryUsage(node);
+            dropUsage(node);
+            addUsage(node->parent(), -usage);
+        }
+        node->take();
+    }
+}
+
+bool TreeEngine::hasDuplicateName(const TreeNode *parent, const QString &name)
+{
+    if (!parent) return false;
+    for (int i = 0; i < parent->childCount(); ++i) {
+        if (sameName(parent->child(i)->name, name)) return true;
+    }
+    return false;
+}
+
+static std::unique_ptr<TreeNode> copyNode(const TreeNode *node, QHash<const TreeNode*, TreeNode*> &prepared)
+{
+    auto it = prepared.find(node);
+    if (it != prepared.end()) return std::unique_ptr<TreeNode>(it.value());
+
+    auto copy = std::make_unique<TreeNode>();
+    copy->name = node->name;
+    copy->type = node->type;
+    copy->path = node->path;
+    copy->blob = node->blob;
+    copy->icon = node->icon;
+    for (int i = 0; i < node->childCount(); ++i) {
+        copy->append(copyNode(node->child(i), prepared));
+    }
+    return copy;
+}
+
+std::unique_ptr<TreeNode> TreeEngine::copy(const TreeNode *node) const
+{
+    TRACE_SCOPE("engine.copy");
+    if (!node) return nullptr;
+    // 大子树先按文件夹边界切分并行复制，再顺序拼装上层
+    const std::vector<const TreeNode*> subtrees = m_walker.split(node, nodeChildren, m_walker.threadCount() * 8);
+    const std::vector<TreeNode*> copies = m_walker.map(subtrees, [](const TreeNode *subtree) {
+        QHash<const TreeNode*, TreeNode*> none;
+        return copyNode(subtree, none).release();
+    });
+    QHash<const TreeNode*, TreeNode*> prepared;
+    for (size_t i = 0; i < subtrees.size(); ++i) {
+        prepared.insert(subtrees[i], copies[i]);
+    }
+    return copyNode(node, prepared);
+}
+
+std::vector<TreeNode*> TreeEngine::find(const QString &keyword, const TreeNode *scope) const
+{
+    TRACE_SCOPE("engine.find");
+    if (!scope) scope = &m_root;
+    const std::vector<const TreeNode*> found = m_walker.collect(scope, nodeChildren, [&keyword](const TreeNode *node) {
+        return nameMatches(node->name, keyword);
+    });
+    std::vector<TreeNode*> result;
+    result.reserve(found.size());
+    for (const TreeNode *node : found) {
+        result.push_back(const_cast<TreeNode*>(node));
+    }
+    return result;
+}
+
+std::vector<TreeNode*> TreeEngine::findPath(const QString &query) const
+{
+    TRACE_SCOPE("engine.find_path");
+    std::vector<TreeNode*> result;
+    PathPattern pattern(query);
+    if (!pattern.isValid() || (pattern.scope().isEmpty() && pattern.isLiteral())) return result;
+
+    const TreeNode *scope = pattern.scope().isEmpty() ? &m_root : nodeAt(pattern.scope());
+    if (!scope) return result;
+    if (pattern.isLiteral()) {
+        result.push_back(const_cast<TreeNode*>(scope));
+        return result;
+    }
+
+    struct PathNode
+    {
+        const TreeNode *node = nullptr;
+        quint64 state = 0;
+    };
+    auto children = [&pattern](const PathNode &parent, std::vector<PathNode> &out) {
+        for (int i = 0; i < parent.node->childCount(); ++i) {
+            const TreeNode *child = parent.node->child(i);
+            quint64 state = pattern.advance(parent.state, child->name);
+            if (state) {
+                out.push_back({child, state});
+            }
+        }
+    };
+    const std::vector<PathNode> found = m_walker.collect(PathNode{scope, pattern.start()}, children,
+                                                         [&pattern](const PathNode &node) {
+        return pattern.matches(node.state);
+    });
+    result.reserve(found.size());
+    for (const PathNode &node : found) {
+        result.push_back(const_cast<TreeNode*>(node.node));
+    }
+    return result;
+}
+
+TreeNode *TreeEngine::nodeAt(const QStringList &components) const
+{
+    if (components.isEmpty()) return nullptr;
+    auto descend = [&components](const TreeNode *node, int first) -> TreeNode* {
+        for (int level = first; node && level < components.size(); ++level) {
+            const int row = childRow(node->childCount(), [node](int i) { return node->child(i)->name; },
+                                     components[level]);
+            node = row >= 0 ? node->child(row) : nullptr;
+        }
+        return const_cast<TreeNode*>(node);
+    };
+    if (TreeNode *node = descend(&m_root, 0)) return node;
+    // 允许省略顶层节点（如“我的电脑”）
+    for (int i = 0; i < m_root.childCount(); ++i) {
+        if (TreeNode *node = descend(m_root.child(i), 0)) return node;
+    }
+    return nullptr;
+}
+
+qint64 TreeEngine::count(const TreeNode *scope) const
+{
+    if (!scope) scope = &m_root;
+    std::vector<qint64> counts(m_walker.threadCount(), 0);
+    m_walker.walk(scope, nodeChildren, [&](const TreeNode *node, int worker) {
+        ++counts[worker];
+        return node->hasChildren();
+    });
+    qint64 total = 0;
+    for (qint64 c : counts) {
+        total += c;
+    }
+    return total;
+}
+
+MemoryUsage TreeEngine::nodeUsage(const TreeNode *node)
+{
+    MemoryUsage usage;
+    usage.nodes = 1;
+    // 节点对象和分配器开销，加上父节点子节点表中的一项
+    usage.nodeBytes = qint64(sizeof(TreeNode)) + 16 + qint64(sizeof(std::unique_ptr<TreeNode>));
+    usage.stringBytes = MemoryUsage::sizeOfString(node->name) + MemoryUsage::sizeOfString(node->type);
+    usage.iconBytes = MemoryUsage::sizeOfString(node->icon);
+    usage.pathBytes = MemoryUsage::sizeOfString(node->path) + MemoryUsage::sizeOfString(node->blob);
+    return usage;
+}
+
+MemoryUsage TreeEngine::memoryUsage(const TreeNode *node) const
+{
+    if (!node) node = &m_root;
+    if (!m_usageValid) {
+        m_usage.clear();
+        buildUsage(&m_root);
+        m_usageValid = true;
+    }
+    auto it = m_usage.constFind(node);
+    return it != m_usage.constEnd() ? it.value() : nodeUsage(node);
+}
+
+void TreeEngine::resetUsage()
+{
+    m_usage.clear();
+    m_usageValid = false;
+}
+
+// 计算 node 子树的占用，同时为其中的容器节点登记汇总值
+MemoryUsage TreeEngine::buildUsage(const TreeNode *node) const
+{
+    MemoryUsage usage = nodeUsage(node);
+    if (!node->isFolder() && !node->hasChildren()) return usage;
+    for (int i = 0; i < node->childCount(); ++i) {
+        usage += buildUsage(node->child(i));
+    }
+    m_usage.insert(node, usage);
+    return usage;
+}
+
+void TreeEngine::dropUsage(const TreeNode *node)
+{
+    if (m_usage.remove(node) == 0) return;
+    for (int i = 0; i < node->childCount(); ++i) {
+        dropUsage(node->child(i));
+    }
+}
+
+void TreeEngine::addUsage(const TreeNode *parent, const MemoryUsage &delta)
+{
+    if (!m_usageValid || delta.isZero()) return;
+    for (const TreeNode *p = parent; p; p = p->parent()) {
+        m_usage[p] += delta;
+    }
+}
+
+QString TreeEngine::pathOf(const TreeNode *node)
+{
+    QString path;
+    buildPath(node, path);
+    return path;
+}
+
+void TreeEngine::buildPath(const TreeNode *node, QString &buffer)
+{
+    static const QString separator = QStringLiteral(" / ");
+
+    // 先算总长度，再从尾部向前填充，避免逐级 prepend；不可见根节点不计入
+    qsizetype length = 0;
+    for (const TreeNode *p = node; p && p->parent(); p = p->parent()) {
+        length += p->name.size();
+        if (p != node) length += separator.size();
+    }
+    buffer.resize(length);
+
+    QChar *out = buffer.data() + length;
+    for (const TreeNode *p = node; p && p->parent(); p = p->parent()) {
+        if (p != node) {
+            out -= separator.size();
+            std::copy(separator.constBegin(), separator.constEnd(), out);
+        }
+        out -= p->name.size();
+        std::copy(p->name.constBegin(), p->name.constEnd(), out);
+    }
+}
+
+static QJsonObject saveNode(const TreeNode *node, const QHash<const TreeNode*, QJsonObject> &saved)
+{
+    auto it = saved.constFind(node);
+    if (it != saved.constEnd()) return it.value();
+
+    QJsonObject obj;
+    obj["name"] = node->name;
+    obj["type"] = node->type;
+    // 存储中的文件只保存内容编号，路径随存储根目录变化
+    if (!node->blob.isEmpty()) {
+        obj["blob"] = node->blob;
+    } else if (!node->path.isEmpty()) {
+        obj["path"] = node->path;
+    }
+    if (!node->icon.isEmpty()) {
+        obj["icon"] = node->icon;
+    }
+    if (node->hasChildren()) {
+        QJsonArray children;
+        for (int i = 0; i < node->childCount(); ++i) {
+            children.append(saveNode(node->child(i), saved));
+        }
+        obj["children"] = children;
+    }
+    return obj;
+}
+
+QJsonObject TreeEngine::nodeToJson(const TreeNode *node)
+{
+    return saveNode(node, {});
+}
+
+std::unique_ptr<TreeNode> TreeEngine::nodeFromJson(const QJsonObject &obj)
+{
+    auto node = std::make_unique<TreeNode>();
+    node->name = obj["name"].toString();
+    node->type = obj["type"].toString();
+    node->path = obj["path"].toString();
+    node->blob = obj["blob"].toString();
+    node->icon = obj["icon"].toString();
+    const QJsonArray children = obj["children"].toArray();
+    for (const QJsonValue &child : children) {
+        node->append(nodeFromJson(child.toObject()));
+    }
+    return node;
+}
+
+QJsonObject TreeEngine::toJson() const
+{
+    TRACE_SCOPE("engine.to_json");
+    // 按文件夹边界切分后并行序列化各子树，再顺序拼装上层
+    const std::vector<const TreeNode*> subtrees = m_walker.split(&m_root, nodeChildren, m_walker.threadCount() * 8);
+    const std::vector<QJsonObject> objects = m_walker.map(subtrees, [](const TreeNode *subtree) {
+        return saveNode(subtree, {});
+    });
+    QHash<const TreeNode*, QJsonObject> saved;
+    for (size_t i = 0; i < subtrees.size(); ++i) {
+        saved.insert(subtrees[i], objects[i]);
+    }
+
+    QJsonArray items;
+    for (int i = 0; i < m_root.childCount(); ++i) {
+        items.append(saveNode(m_root.child(i), saved));
+    }
+    QJsonObject root;
+    root["items"] = items;
+    return root;
+}
+
+bool TreeEngine::fromJson(const QJsonObject &root)
+{
+    TRACE_SCOPE("engine.from_json");
+    if (!root["items"].isArray()) return false;
+    clear();
+    const QJsonArray items = root["items"].toArray();
+    for (const QJsonValue &item : items) {
+        m_root.append(nodeFromJson(item.toObject()));
+    }
+    return true;
+}
+
+bool TreeEngine::save(const QString &fileName) const
+{
+    TRACE_SCOPE("engine.save");
+    ScopedDuration duration(s_saveMs);
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning("Couldn't open save file.");
+        return false;
+    }
+    file.write(QJsonDocument(toJson()).toJson());
+    return file.error() == QFileDevice::NoError;
+}
+
+bool TreeEngine::load(const QString &fileName)
+{
+    TRACE_SCOPE("engine.load");
+    ScopedDuration duration(s_loadMs);
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+    if (doc.isNull()) return false;
+    return fromJson(doc.object());
+}
+
+void TreeEngine::createSample()
+{
+    clear();
+    auto computer = std::make_unique<TreeNode>();
+    computer->name = "我的电脑";
+    computer->type = "system";
+    computer->icon = "treeItem_Computer";
+    TreeNode *myComputer = m_root.append(std::move(computer));
+
+    for (const QString &diskName : {QString("C盘"), QString("D盘"), QString("E盘")}) {
+        auto disk = std::make_unique<TreeNode>();
+        disk->name = diskName;
+        disk->type = "驱动器";
+        disk->icon = "treeItem_Disk";
+        TreeNode *myDisk = myComputer->append(std::move(disk));
+        for (int j = 1; j < 3; j++) {
+            TreeNode *folder = addFolder(myDisk, "文件夹" + QString::number(j));
+            addFile(folder, "文件.txt");
+        }
+    }
+}
@@ -0,0 +1,141 @@
+#ifndef TREEENGINE_H
+#define TREEENGINE_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QJsonObject>
+#include <memory>
+#include <vector>
+
+#include "treewalker.h"
+#include "memoryusage.h"
+
+// 树中的一个节点，只保存与界面无关的数据；图标以图标键表示，由界面层换成实际图标
+class TreeNode
+{
+public:
+    QString name;
+    QString type;       // "文件夹"、"驱动器"、"system" 或文件类型
+    QString path;       // 绑定的真实路径
+    QString blob;       // 存储中的内容编号，非空时 path 由存储根目录推出
+    QString icon;       // 图标键，如 "treeItem_txt"
+
+    TreeNode *parent() const { return m_parent; }
+    int childCount() const { return static_cast<int>(m_children.size()); }
+    TreeNode *child(int row) const { return m_children[row].get(); }
+    bool hasChildren() const { return !m_children.empty(); }
+    int row() const { return m_row; }
+
+    // 文件夹、驱动器和“我的电脑”可以包含子节点，其余都是文件
+    bool isFolder() const { return type == "文件夹" || type == "驱动器" || type == "system"; }
+
+    // 追加子节点并接管其所有权，返回该子节点
+    TreeNode *append(std::unique_ptr<TreeNode> node);
+    // 从父节点摘下，所有权交给调用方
+    std::unique_ptr<TreeNode> take();
+
+private:
+    friend class TreeEngine;
+
+    TreeNode *m_parent = nullptr;
+    int m_row = -1;     // 在父节点中的行号，插入和摘下时维护
+    std::vector<std::unique_ptr<TreeNode>> m_children;
+};
+
+// 无界面的树引擎
+// 持有一棵由不可见根节点 root() 开始的树，提供创建、重命名、移动、删除、深度复制、重名检查、
+// 按名称和路径搜索、显示路径拼接以及与 filesystem.json 相同格式的读写。只依赖 Qt Core，
+// 基准测试、命令行工具和本地服务直接使用；界面程序在自己的模型上编辑，只在加载和保存时与之转换，
+// 并共用下面的名称规则。
+// 复制、搜索、计数和保存由 TreeWalker 按文件夹边界并行执行；修改操作不是线程安全的。
+class TreeEngine
+{
+public:
+    explicit TreeEngine(int threads = 0, int serialLimit = TreeWalker::DefaultSerialLimit);
+
+    TreeNode *root() { return &m_root; }
+    const TreeNode *root() const { return &m_root; }
+    const TreeWalker &walker() const { return m_walker; }
+    void clear();
+
+    // 以下修改操作遇到重名、目标不是文件夹等情况时返回 nullptr 或 false，树保持不变
+    TreeNode *addFolder(TreeNode *parent, const QString &name);
+    TreeNode *addFile(TreeNode *parent, const QString &name, const QString &path = QString());
+    TreeNode *insert(TreeNode *parent, std::unique_ptr<TreeNode> node);
+    bool rename(TreeNode *node, const QString &name);
+    bool move(TreeNode *node, TreeNode *folder);
+    void remove(TreeNode *node);
+
+    std::unique_ptr<TreeNode> copy(const TreeNode *node) const;
+    static bool hasDuplicateName(const TreeNode *parent, const QString &name);
+
+    // 名称规则，界面模型上的同类操作也调用这几个函数，两边结果一致：
+    // 重名按完全相同判断（区分大小写）；名称搜索不区分大小写；
+    // 按名称定位子项时大小写完全相同的优先，否则取第一个仅大小写不同的
+    static bool sameName(const QString &a, const QString &b) { return a == b; }
+    static bool nameMatches(const QString &name, const QString &keyword)
+    {
+        return name.contains(keyword, Qt::CaseInsensitive);
+    }
+    // nameAt(i) 返回第 i 个子项的名称，找不到时返回 -1
+    template<typename NameAt>
+    static int childRow(int count, NameAt nameAt, const QString &name);
+
+    // 名称包含 keyword（不区分大小写）的所有后代，按先序排列；scope 为空时搜索整棵树
+    std::vector<TreeNode*> find(const QString &keyword, const TreeNode *scope = nullptr) const;
+    // 路径查询，如 "C盘/文件夹1/**/*.txt"，规则见 PathPattern
+    std::vector<TreeNode*> findPath(const QString &query) const;
+    // 按各级名称查找节点（规则见 childRow），可省略顶层的“我的电脑”
+    TreeNode *nodeAt(const QStringList &components) const;
+    qint64 count(const TreeNode *scope = nullptr) const;
+
+    // 显示路径，各级名称用 " / " 连接
+    static QString pathOf(const TreeNode *node);
+    static void buildPath(const TreeNode *node, QString &buffer);
+
+    // 子树（含自身）的内存占用，node 为空时统计整棵树
+    // 首次查询时计算各文件夹的汇总值，之后随本类的修改操作沿祖先链增量更新；
+    // 绕过本类直接修改节点（TreeNode::append、改名称字段等）后需调用 resetUsage()
+    MemoryUsage memoryUsage(const TreeNode *node = nullptr) const;
+    static MemoryUsage nodeUsage(const TreeNode *node);
+    void resetUsage();
+
+    // filesystem.json 格式：{"items": [节点...]}，节点含 name、type、path 或 blob、icon、children
+    QJsonObject toJson() const;
+    bool fromJson(const QJsonObject &root);
+    bool save(const QString &fileName) const;
+    bool load(const QString &fileName);
+
+    static QJsonObject nodeToJson(const TreeNode *node);
+    static std::unique_ptr<TreeNode> nodeFromJson(const QJsonObject &obj);
+
+    // 首次运行时的示例结构：我的电脑 → C/D/E 盘 → 文件夹1、文件夹2 → 文件.txt
+    void createSample();
+
+private:
+    static void nodeChildren(const TreeNode *node, std::vector<const TreeNode*> &out);
+
+    MemoryUsage buildUsage(const TreeNode *node) const;
+    void dropUsage(const TreeNode *node);
+    void addUsage(const TreeNode *parent, const MemoryUsage &delta);
+
+    TreeNode m_root;
+    TreeWalker m_walker;
+    mutable QHash<const TreeNode*, MemoryUsage> m_usage;    // 有子节点或可以有子节点的节点的子树汇总
+    mutable bool m_usageValid = false;
+};
+
+template<typename NameAt>
+int TreeEngine::childRow(int count, NameAt nameAt, const QString &name)
+{
+    int candidate = -1;
+    for (int i = 0; i < count; ++i) {
+        const QString childName = nameAt(i);
+        if (sameName(childName, name)) return i;
+        if (candidate < 0 && childName.compare(name, Qt::CaseInsensitive) == 0) candidate = i;
+    }
+    return candidate;
+}
+
+#endif // TREEENGINE_H
@@ -0,0 +1,287 @@
+#include "treeprotocol.h"
+#include "treeengine.h"
+#include "treecommands.h"
+#include "pathpattern.h"
+
+#include <QDataStream>
+#include <QIODevice>
+#include <QtEndian>
+
+namespace TreeProtocol {
+
+namespace {
+
+// 协议中的字节序和编码固定，不随 Qt 版本变化
+const QDataStream::Version StreamVersion = QDataStream::Qt_5_12;
+
+void writeString(QDataStream &out, const QString &text)
+{
+    out << text.toUtf8();
+}
+
+QString readString(QDataStream &in)
+{
+    QByteArray bytes;
+    in >> bytes;
+    return QString::fromUtf8(bytes);
+}
+
+QByteArray frame(const QByteArray &body)
+{
+    QByteArray out(4, Qt::Uninitialized);
+    qToBigEndian<quint32>(quint32(body.size()), out.data());
+    return out + body;
+}
+
+struct Usage
+{
+    const char *command;
+    Op op;
+    int minArgs;
+    int maxArgs;
+    const char *usage;
+};
+
+const Usage Usages[] = {
+    {"stat", Stat, 1, 1, "stat 路径"},
+    {"ls", List, 1, 1, "ls 路径"},
+    {"find", Find, 1, 1, "find 关键字|路径模式"},
+    {"count", Count, 0, 1, "count [路径]"},
+    {"mkdir", Mkdir, 1, 1, "mkdir [-p] 路径"},
+    {"touch", Touch, 1, 2, "touch 路径 [真实路径]"},
+    {"mv", Move, 2, 2, "mv 源 目标"},
+    {"cp", Copy, 2, 2, "cp 源 目标"},
+    {"rm", Remove, 1, 1, "rm [-r] 路径"},
+    {"rename", Rename, 2, 2, "rename 路径 新名称"},
+};
+
+Record recordOf(const TreeNode *node)
+{
+    Record record;
+    record.path = TreeCommands::pathOf(node);
+    record.type = node->type;
+    record.realPath = node->path;
+    record.blob = node->blob;
+    record.children = quint32(node->childCount());
+    return record;
+}
+
+Result failed(const QString &message, quint8 status = Failed)
+{
+    Result result;
+    result.status = status;
+    result.message = message;
+    return result;
+}
+
+}
+
+bool isReadOnly(quint8 code)
+{
+    return code >= Stat && code <= Count;
+}
+
+bool Request::isReadOnly() const
+{
+    for (const Operation &op : ops) {
+        if (!TreeProtocol::isReadOnly(op.code)) return false;
+    }
+    return true;
+}
+
+bool parseCommand(const QStringList &words, Operation *op, QString *error)
+{
+    if (words.isEmpty()) {
+        *error = "空命令";
+        return false;
+    }
+    QStringList args = words.mid(1);
+    for (const Usage &usage : Usages) {
+        if (words.first() != QLatin1String(usage.command)) continue;
+        op->code = usage.op;
+        if (usage.op == Mkdir && args.removeAll("-p") > 0) op->code = MkdirParents;
+        if (usage.op == Remove && args.removeAll("-r") > 0) op->code = RemoveRecursive;
+        if (args.size() < usage.minArgs || args.size() > usage.maxArgs) {
+            *error = QString("用法：") + usage.usage;
+            return false;
+        }
+        op->args = args;
+        return true;
+    }
+    *error = "未知命令 " + words.first();
+    return false;
+}
+
+QByteArray encode(const Request &request)
+{
+    QByteArray body;
+    QDataStream out(&body, QIODevice::WriteOnly);
+    out.setVersion(StreamVersion);
+    out << request.id << request.flags << quint16(request.ops.size());
+    for (const Operation &op : request.ops) {
+        out << op.code << quint8(op.args.size());
+        for (const QString &arg : op.args) {
+            writeString(out, arg);
+        }
+    }
+    return frame(body);
+}
+
+QByteArray encode(const Reply &reply)
+{
+    QByteArray body;
+    QDataStream out(&body, QIODevice::WriteOnly);
+    out.setVersion(StreamVersion);
+    out << reply.id << quint16(reply.results.size());
+    for (const Result &result : reply.results) {
+        out << result.status;
+        writeString(out, result.message);
+        out << result.value << quint32(result.records.size());
+        for (const Record &record : result.records) {
+            writeString(out, record.path);
+            writeString(out, record.type);
+            writeString(out, record.realPath);
+            writeString(out, record.blob);
+            out << record.children;
+        }
+    }
+    return frame(body);
+}
+
+bool takeFrame(QByteArray &buffer, QByteArray *frame, bool *tooLarge)
+{
+    *tooLarge = false;
+    if (buffer.size() < 4) return false;
+    const quint32 length = qFromBigEndian<quint32>(buffer.constData());
+    if (length > MaxFrame) {
+        *tooLarge = true;
+        return false;
+    }
+    if (quint32(buffer.size()) - 4 < length) return false;
+    *frame = buffer.mid(4, int(length));
+    buffer.remove(0, 4 + int(length));
+    return true;
+}
+
+bool decode(const QByteArray &frame, Request *request)
+{
+    QDataStream in(frame);
+    in.setVersion(StreamVersion);
+    quint16 count = 0;
+    in >> request->id >> request->flags >> count;
+    request->ops.clear();
+    for (quint16 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        Operation op;
+        quint8 argc = 0;
+        in >> op.code >> argc;
+        for (quint8 j = 0; j < argc && in.status() == QDataStream::Ok; ++j) {
+            op.args.append(readString(in));
+        }
+        request->ops.append(op);
+    }
+    return in.status() == QDataStream::Ok && in.atEnd();
+}
+
+bool decode(const QByteArray &frame, Reply *reply)
+{
+    QDataStream in(frame);
+    in.setVersion(StreamVersion);
+    quint16 count = 0;
+    in >> reply->id >> count;
+    reply->results.clear();
+    for (quint16 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        Result result;
+        quint32 records = 0;
+        in >> result.status;
+        result.message = readString(in);
+        in >> result.value >> records;
+        for (quint32 j = 0; j < records && in.status() == QDataStream::Ok; ++j) {
+            Record record;
+            record.path = readString(in);
+            record.type = readString(in);
+            record.realPath = readString(in);
+            record.blob = readString(in);
+            in >> record.children;
+            result.records.append(record);
+        }
+        reply->results.append(result);
+    }
+    return in.status() == QDataStream::Ok && in.atEnd();
+}
+
+Result read(const TreeEngine &engine, const Operation &op)
+{
+    const QString path = op.args.value(0);
+    const TreeNode *node = nullptr;
+    if (op.code != Find && !(op.code == Count && op.args.isEmpty())) {
+        if (op.args.size() != 1) return failed("参数个数不对", BadRequest);
+        node = engine.nodeAt(PathPattern::splitPath(path));
+        if (!node) return failed("找不到 " + path);
+    }
+
+    Result result;
+    switch (op.code) {
+    case Stat:
+        result.records.append(recordOf(node));
+        result.value = engine.count(node) + 1;
+        break;
+    case List:
+        for (int i = 0; i < node->childCount(); ++i) {
+            result.records.append(recordOf(node->child(i)));
+        }
+        result.value = node->childCount();
+        break;
+    case Find: {
+        if (op.args.size() != 1 || path.isEmpty()) return failed("缺少关键字", BadRequest);
+        const std::vector<TreeNode*> found = path.contains('/') ? engine.findPath(path) : engine.find(path);
+        for (const TreeNode *match : found) {
+            result.records.append(recordOf(match));
+        }
+        result.value = qint64(found.size());
+        break;
+    }
+    case Count:
+        result.value = engine.count(node);
+        break;
+    default:
+        return failed(QString("未知操作 %1").arg(int(op.code)), BadRequest);
+    }
+    return result;
+}
+
+Result write(TreeCommands &commands, const Operation &op)
+{
+    const int expected = (op.code == Move || op.code == Copy || op.code == Rename) ? 2 : 1;
+    if (op.args.size() != expected && !(op.code == Touch && op.args.size() == 2)) {
+        return failed("参数个数不对", BadRequest);
+    }
+    QString error;
+    bool ok = false;
+    switch (op.code) {
+    case Mkdir:
+    case MkdirParents:
+        ok = commands.mkdir(op.args[0], op.code == MkdirParents, &error);
+        break;
+    case Touch:
+        ok = commands.touch(op.args[0], op.args.value(1), &error);
+        break;
+    case Move:
+        ok = commands.move(op.args[0], op.args[1], &error);
+        break;
+    case Copy:
+        ok = commands.copy(op.args[0], op.args[1], &error);
+        break;
+    case Remove:
+    case RemoveRecursive:
+        ok = commands.remove(op.args[0], op.code == RemoveRecursive, &error);
+        break;
+    case Rename:
+        ok = commands.rename(op.args[0], op.args[1], &error);
+        break;
+    default:
+        return failed(QString("未知操作 %1").arg(int(op.code)), BadRequest);
+    }
+    return ok ? Result() : failed(error);
+}
+
+}
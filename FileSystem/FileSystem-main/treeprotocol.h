@@ -0,0 +1,103 @@
+#ifndef TREEPROTOCOL_H
+#define TREEPROTOCOL_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class TreeEngine;
+class TreeCommands;
+
+// 本地服务（TreeService）与客户端之间的二进制协议
+// 每条消息是一帧：quint32 内容长度（大端，不含自身）+ 内容，字符串为 quint32 长度 + UTF-8 字节。
+//   请求：quint32 编号、quint8 标志、quint16 操作数，每个操作为 quint8 操作码、quint8 参数数和各参数
+//   回复：quint32 编号、quint16 结果数，每个结果为 quint8 状态、消息、qint64 数值、quint32 记录数和各节点记录，
+//         节点记录为路径、类型、绑定路径、存储编号和 quint32 子项数
+// 一个请求中的操作按顺序执行，前一个失败时其余的标为 Skipped，除非设置了 ContinueOnError；已执行的修改不回滚。
+// 客户端可以不等回复连续发送多个请求，回复按编号对应，只读请求的回复可能先于之前的请求到达。
+namespace TreeProtocol {
+
+// 路径参数的写法同命令行工具：以 / 分隔，可省略顶层的“我的电脑”
+enum Op : quint8 {
+    // 只读
+    Stat = 1,           // 路径 → 一条记录，数值为子树节点数（含自身）
+    List,               // 路径 → 各子项的记录
+    Find,               // 关键字|路径模式 → 匹配节点的记录
+    Count,              // [路径] → 数值为后代节点数，不给路径时统计整棵树
+    // 修改
+    Mkdir = 16,         // 路径
+    MkdirParents,       // 路径，同时创建缺少的上级
+    Touch,              // 路径 [真实路径]
+    Move,               // 源 目标
+    Copy,               // 源 目标
+    Remove,             // 路径，只能删除文件和空文件夹
+    RemoveRecursive,    // 路径
+    Rename              // 路径 新名称
+};
+
+enum Status : quint8 { Ok, Failed, Skipped, BadRequest };
+
+enum Flag : quint8 { ContinueOnError = 1 };
+
+// 单帧上限，超过时服务端断开连接
+const quint32 MaxFrame = 64 * 1024 * 1024;
+
+struct Operation
+{
+    quint8 code = 0;
+    QStringList args;
+};
+
+struct Request
+{
+    quint32 id = 0;
+    quint8 flags = 0;
+    QVector<Operation> ops;
+
+    bool isReadOnly() const;
+};
+
+struct Record
+{
+    QString path;       // 各级名称用 / 连接，从顶层节点写起
+    QString type;
+    QString realPath;
+    QString blob;
+    quint32 children = 0;
+};
+
+struct Result
+{
+    quint8 status = Ok;
+    QString message;
+    qint64 value = 0;
+    QVector<Record> records;
+};
+
+struct Reply
+{
+    quint32 id = 0;
+    QVector<Result> results;
+};
+
+bool isReadOnly(quint8 code);
+// 命令行写法（与 FileSysCli 相同，如 "mkdir -p a/b"）与操作之间的转换
+bool parseCommand(const QStringList &words, Operation *op, QString *error);
+
+// 编码结果含帧头，可直接写入套接字
+QByteArray encode(const Request &request);
+QByteArray encode(const Reply &reply);
+// 从 buffer 头部取出一帧内容；数据不完整时返回 false 且不改动 buffer，长度超过上限时另置 *tooLarge
+bool takeFrame(QByteArray &buffer, QByteArray *frame, bool *tooLarge);
+bool decode(const QByteArray &frame, Request *request);
+bool decode(const QByteArray &frame, Reply *reply);
+
+// 在树上执行一个只读操作，可在多个线程上对同一棵树同时调用
+Result read(const TreeEngine &engine, const Operation &op);
+// 执行一个修改操作，修改记录由 commands 的 setChanges 收集
+Result write(TreeCommands &commands, const Operation &op);
+
+}
+
+#endif // TREEPROTOCOL_H
@@ -0,0 +1,222 @@
+#include "treeservice.h"
+#include "counters.h"
+#include "stallwatchdog.h"
+#include "trace.h"
+
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QPointer>
+
+static Counter s_requests("service.requests", "本地服务已处理的请求");
+static Counter s_inFlight("service.in_flight", "本地服务进行中的请求");
+static Counter s_snapshotMs("service.snapshot_ms", "上次生成服务快照耗时", Counter::Milliseconds);
+
+// 每个连接在套接字中缓存的未处理数据上限，超过后不再从系统读取，客户端的写入随之阻塞
+static const qint64 ReadBufferSize = 1024 * 1024;
+
+// 按顺序执行请求中的操作，前一个失败后其余的标为跳过，除非请求允许继续
+template<typename RunFn>
+static TreeProtocol::Reply runRequest(const TreeProtocol::Request &request, RunFn run)
+{
+    TreeProtocol::Reply reply;
+    reply.id = request.id;
+    bool failed = false;
+    for (const TreeProtocol::Operation &op : request.ops) {
+        TreeProtocol::Result result;
+        if (failed && !(request.flags & TreeProtocol::ContinueOnError)) {
+            result.status = TreeProtocol::Skipped;
+        } else {
+            result = run(op);
+            failed = failed || result.status != TreeProtocol::Ok;
+        }
+        reply.results.append(result);
+    }
+    return reply;
+}
+
+TreeService::TreeService(SnapshotFn snapshot, ApplyFn apply, QObject *parent)
+    : QObject(parent), m_snapshotFn(std::move(snapshot)), m_applyFn(std::move(apply))
+{
+    m_server = new QLocalServer(this);
+    connect(m_server, &QLocalServer::newConnection, this, &TreeService::accept);
+}
+
+TreeService::~TreeService()
+{
+    close();
+    // 等进行中的读取结束，它们的回复投递到本对象，本对象销毁后自动丢弃
+    m_pool.waitForDone();
+}
+
+bool TreeService::listen(const QString &name, QString *error)
+{
+    close();
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+    if (!m_server->listen(name) && m_server->serverError() == QAbstractSocket::AddressInUseError) {
+        // 连不上说明是上次异常退出留下的套接字文件，删除后重试；连得上则是另一个实例正在使用
+        QLocalSocket probe;
+        probe.connectToServer(name);
+        if (!probe.waitForConnected(500)) {
+            QLocalServer::removeServer(name);
+            m_server->listen(name);
+        }
+    }
+    if (!m_server->isListening()) {
+        *error = m_server->errorString();
+        return false;
+    }
+    return true;
+}
+
+void TreeService::close()
+{
+    m_server->close();
+    // 断开时会同步从表中移除，先取出全部连接
+    const QList<QLocalSocket*> sockets = m_connections.keys();
+    for (QLocalSocket *socket : sockets) {
+        socket->abort();
+    }
+    m_connections.clear();
+}
+
+bool TreeService::isListening() const
+{
+    return m_server->isListening();
+}
+
+QString TreeService::serverName() const
+{
+    return m_server->fullServerName();
+}
+
+void TreeService::invalidate()
+{
+    if (!m_applying) m_snapshot.reset();
+}
+
+void TreeService::accept()
+{
+    while (QLocalSocket *socket = m_server->nextPendingConnection()) {
+        socket->setReadBufferSize(ReadBufferSize);
+        m_connections.insert(socket, Connection());
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket]() { readRequests(socket); });
+        connect(socket, &QLocalSocket::disconnected, this, [this, socket]() {
+            s_inFlight.add(-m_connections.value(socket).inFlight);
+            m_connections.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void TreeService::readRequests(QLocalSocket *socket)
+{
+    for (;;) {
+        auto it = m_connections.find(socket);
+        // 未完成的请求太多时先不读，等回复发出后由 finish 继续
+        if (it == m_connections.end() || it->inFlight >= MaxInFlight) return;
+
+        QByteArray frame;
+        bool tooLarge = false;
+        if (!TreeProtocol::takeFrame(it->buffer, &frame, &tooLarge)) {
+            if (tooLarge) {
+                qWarning("Local service: frame too large, closing connection");
+                socket->abort();
+                return;
+            }
+            if (socket->bytesAvailable() == 0) return;
+            it->buffer += socket->readAll();
+            continue;
+        }
+
+        TreeProtocol::Request request;
+        if (!TreeProtocol::decode(frame, &request)) {
+            qWarning("Local service: malformed request, closing connection");
+            socket->abort();
+            return;
+        }
+        s_requests.add(1);
+        dispatch(socket, request);
+    }
+}
+
+void TreeService::dispatch(QLocalSocket *socket, const TreeProtocol::Request &request)
+{
+    if (!request.isReadOnly()) {
+        // 修改在主线程上立即执行，保证同一连接中之后的请求看到修改结果
+        socket->write(TreeProtocol::encode(execute(request)));
+        return;
+    }
+
+    std::shared_ptr<const TreeEngine> engine = snapshot();
+    ++m_connections[socket].inFlight;
+    s_inFlight.add(1);
+    QPointer<QLocalSocket> target(socket);
+    m_pool.start([this, engine, request, target]() {
+        TRACE_SCOPE("service.read");
+        const TreeProtocol::Reply reply = runRequest(request, [&engine](const TreeProtocol::Operation &op) {
+            return TreeProtocol::read(*engine, op);
+        });
+        const QByteArray bytes = TreeProtocol::encode(reply);
+        QMetaObject::invokeMethod(this, [this, target, bytes]() {
+            if (target) finish(target, bytes);
+        }, Qt::QueuedConnection);
+    });
+}
+
+TreeProtocol::Reply TreeService::execute(const TreeProtocol::Request &request)
+{
+    TRACE_SCOPE("service.write");
+    StallWatchdog::Activity activity(QString("本地服务请求 %1（%2 个操作）").arg(request.id).arg(request.ops.size()));
+    TreeEngine *engine = writableSnapshot();
+    TreeCommands commands(*engine);
+    QVector<TreeChange> changes;
+    commands.setChanges(&changes);
+    return runRequest(request, [&](const TreeProtocol::Operation &op) {
+        if (TreeProtocol::isReadOnly(op.code)) return TreeProtocol::read(*engine, op);
+        changes.clear();
+        const TreeProtocol::Result result = TreeProtocol::write(commands, op);
+        // 修改记录中的节点只在下一条操作前有效，每条操作后立即同步
+        if (!changes.isEmpty()) {
+            m_applying = true;
+            m_applyFn(changes);
+            m_applying = false;
+        }
+        return result;
+    });
+}
+
+void TreeService::finish(QLocalSocket *socket, const QByteArray &reply)
+{
+    auto it = m_connections.find(socket);
+    if (it == m_connections.end()) return;
+    --it->inFlight;
+    s_inFlight.add(-1);
+    socket->write(reply);
+    // 之前因请求过多暂停的读取在这里继续
+    readRequests(socket);
+}
+
+std::shared_ptr<const TreeEngine> TreeService::snapshot()
+{
+    if (!m_snapshot) {
+        TRACE_SCOPE("service.snapshot");
+        ScopedDuration duration(s_snapshotMs);
+        m_snapshot = m_snapshotFn();
+    }
+    return m_snapshot;
+}
+
+TreeEngine *TreeService::writableSnapshot()
+{
+    snapshot();
+    // 新的读取方只在主线程上产生，这里看到只有自己持有时可以直接修改；否则复制一份，读取方继续用旧快照
+    if (m_snapshot.use_count() > 1) {
+        TRACE_SCOPE("service.copy_snapshot");
+        auto copy = std::make_shared<TreeEngine>(m_snapshot->walker().threadCount());
+        for (int i = 0; i < m_snapshot->root()->childCount(); ++i) {
+            copy->root()->append(m_snapshot->copy(m_snapshot->root()->child(i)));
+        }
+        m_snapshot = copy;
+    }
+    return m_snapshot.get();
+}
@@ -0,0 +1,66 @@
+#ifndef TREESERVICE_H
+#define TREESERVICE_H
+
+#include <QObject>
+#include <QHash>
+#include <QThreadPool>
+#include <functional>
+#include <memory>
+
+#include "treeengine.h"
+#include "treecommands.h"
+#include "treeprotocol.h"
+
+class QLocalServer;
+class QLocalSocket;
+
+// 本地服务
+// 在 QLocalServer 上按 TreeProtocol 接收其他程序的批量树操作，界面打开时外部工具也能查询和修改同一棵树。
+// 服务持有界面树的快照（TreeEngine）：只读请求在线程池中针对当时的快照执行，多个请求同时进行互不等待；
+// 含修改的请求在主线程上按到达顺序执行，先修改快照（仍有读取方持有时先复制一份），每条操作的修改随即经
+// apply 回调同步到界面模型。界面自身的修改通过 invalidate() 通知，下一个请求前重新生成快照。
+// 同一连接可以不等回复连续发送请求，未完成的请求达到 MaxInFlight 时暂停读取该连接。
+class TreeService : public QObject
+{
+public:
+    static const int MaxInFlight = 64;
+
+    using SnapshotFn = std::function<std::unique_ptr<TreeEngine>()>;
+    using ApplyFn = std::function<void(const QVector<TreeChange> &changes)>;
+
+    TreeService(SnapshotFn snapshot, ApplyFn apply, QObject *parent = nullptr);
+    ~TreeService();
+
+    // 只允许当前用户连接；同名的残留套接字文件会先被删除
+    bool listen(const QString &name, QString *error);
+    void close();
+    bool isListening() const;
+    QString serverName() const;
+
+    void invalidate();
+
+private:
+    struct Connection
+    {
+        QByteArray buffer;
+        int inFlight = 0;
+    };
+
+    void accept();
+    void readRequests(QLocalSocket *socket);
+    void dispatch(QLocalSocket *socket, const TreeProtocol::Request &request);
+    TreeProtocol::Reply execute(const TreeProtocol::Request &request);
+    void finish(QLocalSocket *socket, const QByteArray &reply);
+    std::shared_ptr<const TreeEngine> snapshot();
+    TreeEngine *writableSnapshot();
+
+    SnapshotFn m_snapshotFn;
+    ApplyFn m_applyFn;
+    QLocalServer *m_server = nullptr;
+    QThreadPool m_pool;
+    QHash<QLocalSocket*, Connection> m_connections;
+    std::shared_ptr<TreeEngine> m_snapshot;
+    bool m_applying = false;        // 正在把修改同步到界面，期间的模型变化不使快照失效
+};
+
+#endif // TREESERVICE_H
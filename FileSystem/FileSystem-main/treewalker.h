@@ -0,0 +1,377 @@
+#ifndef TREEWALKER_H
+#define TREEWALKER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 工作窃取式并行树遍历
+// 以文件夹为任务单位切分：每个线程优先处理自己队列尾部的任务，空闲时从其他线程队列头部窃取。
+// 节点类型和获取子节点的方式由调用方提供，不依赖具体的模型实现。
+class TreeWalker
+{
+public:
+    // 节点数在此以内的遍历直接在调用线程上完成：启动和同步线程的开销大于分摊后的收益。
+    // 默认值按线程启动开销与单节点访问开销估算，用 FileSysBench --calibrate 在实际机器上测量交叉点。
+    static const int DefaultSerialLimit = 16384;
+
+    explicit TreeWalker(int threads = 0, int serialLimit = DefaultSerialLimit)
+    {
+        setThreadCount(threads);
+        setSerialLimit(serialLimit);
+    }
+
+    int threadCount() const { return m_threads; }
+
+    // threads <= 0 时使用硬件线程数
+    void setThreadCount(int threads)
+    {
+        int hardware = static_cast<int>(std::thread::hardware_concurrency());
+        m_threads = threads > 0 ? threads : std::max(1, hardware);
+    }
+
+    int serialLimit() const { return m_serialLimit; }
+
+    // nodes < 0 时使用默认值，0 表示总是并行
+    void setSerialLimit(int nodes)
+    {
+        m_serialLimit = nodes >= 0 ? nodes : DefaultSerialLimit;
+    }
+
+    // 遍历 root 的所有后代（不含 root 本身）
+    // children(node, out) 把 node 的子节点追加到 out；
+    // visit(node, worker) 返回 true 表示继续深入该节点，worker 为 [0, threadCount()) 的线程编号，
+    // 可用于写入线程局部的结果。visit 会在多个线程上并发调用。
+    // 先在调用线程上访问至多 serialLimit() 个节点，树较小时不会启动其他线程。
+    template<typename Node, typename ChildrenFn, typename VisitFn>
+    void walk(Node root, ChildrenFn children, VisitFn visit) const
+    {
+        std::vector<Node> folders(1, root);
+        std::vector<Node> buffer;
+        const long limit = serialBudget();
+        for (long visited = 0; !folders.empty() && (limit < 0 || visited < limit); ) {
+            const Node node = folders.back();
+            folders.pop_back();
+            buffer.clear();
+            children(node, buffer);
+            for (const Node &child : buffer) {
+                if (visit(child, 0)) folders.push_back(child);
+            }
+            visited += static_cast<long>(buffer.size());
+        }
+        if (folders.empty()) return;
+
+        std::vector<TaskQueue<Node>> queues(m_threads);
+        std::atomic<long> pending(static_cast<long>(folders.size()));
+        queues[0].items.assign(folders.begin(), folders.end());
+
+        auto worker = [&](int id) {
+            std::vector<Node> kids;
+            Node node;
+            for (;;) {
+                if (!take(queues, id, node)) {
+                    if (pending.load(std::memory_order_acquire) == 0) return;
+                    std::this_thread::yield();
+                    continue;
+                }
+                kids.clear();
+                children(node, kids);
+                for (const Node &child : kids) {
+                    if (visit(child, id)) {
+                        pending.fetch_add(1, std::memory_order_relaxed);
+                        queues[id].push(child);
+                    }
+                }
+                pending.fetch_sub(1, std::memory_order_acq_rel);
+            }
+        };
+        run(worker, m_threads);
+    }
+
+    // 按先序收集 root 的后代（不含 root）中 match(node) 为真的节点；descend(node) 为假时不进入其子树。
+    // 结果顺序与递归遍历一致，调用方不必再排序。match 和 descend 会并发调用，且可能对同一节点调用多次。
+    template<typename Node, typename ChildrenFn, typename MatchFn, typename DescendFn>
+    std::vector<Node> collect(Node root, ChildrenFn children, MatchFn match, DescendFn descend) const
+    {
+        std::vector<Node> result;
+        std::vector<Node> stack = childStack(root, children);
+        preorder(stack, children, descend, [&](const Node &node) {
+            if (match(node)) result.push_back(node);
+            return true;
+        }, serialBudget());
+        if (stack.empty()) return result;
+
+        // 剩余部分切成按先序排列的任务并行处理，按任务顺序拼接即为先序
+        const std::vector<Task<Node>> tasks = orderedTasks(stack, children, descend, static_cast<std::size_t>(m_threads) * 8);
+        const std::vector<std::vector<Node>> parts = map(tasks, [&](const Task<Node> &task) {
+            std::vector<Node> found;
+            auto gather = [&](const Node &node) {
+                if (match(node)) found.push_back(node);
+                return true;
+            };
+            if (task.subtree) {
+                std::vector<Node> subtree(1, task.node);
+                preorder(subtree, children, descend, gather, -1);
+            } else {
+                gather(task.node);
+            }
+            return found;
+        });
+        for (const std::vector<Node> &part : parts) {
+            result.insert(result.end(), part.begin(), part.end());
+        }
+        return result;
+    }
+
+    template<typename Node, typename ChildrenFn, typename MatchFn>
+    std::vector<Node> collect(Node root, ChildrenFn children, MatchFn match) const
+    {
+        return collect(root, children, match, [](const Node &) { return true; });
+    }
+
+    // 按先序查找 root 的第一个 match(node) 为真的后代，找到时写入 found 并返回 true。
+    // 找到后位于其后的任务立即停止，位于其前的任务继续，保证结果与递归遍历的第一个匹配相同。
+    template<typename Node, typename ChildrenFn, typename MatchFn>
+    bool first(Node root, ChildrenFn children, MatchFn match, Node &found) const
+    {
+        auto all = [](const Node &) { return true; };
+        bool hit = false;
+        std::vector<Node> stack = childStack(root, children);
+        preorder(stack, children, all, [&](const Node &node) {
+            if (!match(node)) return true;
+            found = node;
+            hit = true;
+            return false;
+        }, serialBudget());
+        if (hit || stack.empty()) return hit;
+
+        const std::vector<Task<Node>> tasks = orderedTasks(stack, children, all, static_cast<std::size_t>(m_threads) * 8);
+        // 已找到匹配的最靠前任务序号，所有线程共享
+        std::atomic<std::size_t> bound(tasks.size());
+        std::vector<Node> hits(tasks.size());
+        std::vector<std::size_t> order(tasks.size());
+        for (std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+
+        // 返回 int 而不是 bool：map 的结果若是 std::vector<bool>，并发写入相邻元素会冲突
+        map(order, [&](std::size_t i) {
+            if (i > bound.load(std::memory_order_relaxed)) return 0;
+            bool matched = false;
+            auto visit = [&](const Node &node) {
+                if (i > bound.load(std::memory_order_relaxed)) return false;
+                if (!match(node)) return true;
+                hits[i] = node;
+                matched = true;
+                return false;
+            };
+            if (tasks[i].subtree) {
+                std::vector<Node> subtree(1, tasks[i].node);
+                preorder(subtree, children, all, visit, -1);
+            } else {
+                visit(tasks[i].node);
+            }
+            if (matched) {
+                std::size_t current = bound.load();
+                while (i < current && !bound.compare_exchange_weak(current, i)) {}
+            }
+            return matched ? 1 : 0;
+        });
+
+        const std::size_t best = bound.load();
+        if (best >= tasks.size()) return false;
+        found = hits[best];
+        return true;
+    }
+
+    // 对 items 中每一项并行执行 fn，结果按输入顺序返回
+    template<typename T, typename Fn>
+    auto map(const std::vector<T> &items, Fn fn) const -> std::vector<decltype(fn(items.front()))>
+    {
+        std::vector<decltype(fn(items.front()))> results(items.size());
+        std::atomic<std::size_t> next(0);
+        auto worker = [&](int) {
+            for (std::size_t i = next.fetch_add(1); i < items.size(); i = next.fetch_add(1)) {
+                results[i] = fn(items[i]);
+            }
+        };
+        run(worker, static_cast<int>(std::min<std::size_t>(m_threads, items.size())));
+        return results;
+    }
+
+    // 按文件夹边界把 root 广度优先展开为至少 minTasks 棵互不相交的子树，供需要保持结构的操作并行处理。
+    // 被展开的上层节点不在返回值中，由调用方顺序处理；单线程或树不超过 serialLimit() 个节点时返回空。
+    template<typename Node, typename ChildrenFn>
+    std::vector<Node> split(Node root, ChildrenFn children, std::size_t minTasks) const
+    {
+        std::vector<Node> frontier;
+        if (m_threads < 2 || isSmall(root, children)) return frontier;
+
+        children(root, frontier);
+        std::vector<Node> next;
+        std::vector<Node> buffer;
+        while (frontier.size() < minTasks) {
+            bool expanded = false;
+            next.clear();
+            for (const Node &node : frontier) {
+                buffer.clear();
+                children(node, buffer);
+                if (buffer.empty()) {
+                    next.push_back(node);
+                } else {
+                    next.insert(next.end(), buffer.begin(), buffer.end());
+                    expanded = true;
+                }
+            }
+            if (!expanded) return std::vector<Node>();
+            frontier.swap(next);
+        }
+        return frontier;
+    }
+
+private:
+    // collect/first 的任务：subtree 为假时只访问节点本身，其子节点已展开为后面的任务
+    template<typename Node>
+    struct Task
+    {
+        Node node;
+        bool subtree;
+    };
+
+    // 调用线程顺序访问的节点数，负数表示不限
+    long serialBudget() const
+    {
+        return m_threads > 1 ? m_serialLimit : -1;
+    }
+
+    template<typename Node, typename ChildrenFn>
+    static std::vector<Node> childStack(const Node &root, ChildrenFn &children)
+    {
+        std::vector<Node> stack;
+        children(root, stack);
+        std::reverse(stack.begin(), stack.end());
+        return stack;
+    }
+
+    // 从栈顶起按先序访问，visit 返回 false 时停止；最多访问 limit 个节点，负数不限。
+    // 返回时栈中是尚未访问的节点，从栈顶依次取出仍是先序。
+    template<typename Node, typename ChildrenFn, typename DescendFn, typename VisitFn>
+    static void preorder(std::vector<Node> &stack, ChildrenFn &children, DescendFn &descend, VisitFn &&visit, long limit)
+    {
+        std::vector<Node> buffer;
+        for (long visited = 0; !stack.empty() && visited != limit; ++visited) {
+            const Node node = stack.back();
+            stack.pop_back();
+            if (!visit(node)) return;
+            if (!descend(node)) continue;
+            buffer.clear();
+            children(node, buffer);
+            stack.insert(stack.end(), buffer.rbegin(), buffer.rend());
+        }
+    }
+
+    // 把未访问的节点展开为至少 minTasks 个按先序排列的任务，展开的上层节点作为单节点任务留在原位
+    template<typename Node, typename ChildrenFn, typename DescendFn>
+    static std::vector<Task<Node>> orderedTasks(const std::vector<Node> &stack, ChildrenFn &children, DescendFn &descend, std::size_t minTasks)
+    {
+        std::vector<Task<Node>> tasks;
+        for (auto it = stack.rbegin(); it != stack.rend(); ++it) {
+            tasks.push_back({*it, true});
+        }
+        std::vector<Task<Node>> next;
+        std::vector<Node> buffer;
+        for (std::size_t subtrees = tasks.size(); subtrees < minTasks; ) {
+            bool expanded = false;
+            next.clear();
+            subtrees = 0;
+            for (const Task<Node> &task : tasks) {
+                buffer.clear();
+                if (task.subtree && descend(task.node)) children(task.node, buffer);
+                if (buffer.empty()) {
+                    next.push_back(task);
+                    subtrees += task.subtree ? 1 : 0;
+                    continue;
+                }
+                next.push_back({task.node, false});
+                for (const Node &child : buffer) {
+                    next.push_back({child, true});
+                }
+                subtrees += buffer.size();
+                expanded = true;
+            }
+            tasks.swap(next);
+            if (!expanded) break;
+        }
+        return tasks;
+    }
+
+    // 子树节点数是否不超过 serialLimit()，最多数到上限
+    template<typename Node, typename ChildrenFn>
+    bool isSmall(const Node &root, ChildrenFn &children) const
+    {
+        auto all = [](const Node &) { return true; };
+        std::vector<Node> stack = childStack(root, children);
+        preorder(stack, children, all, all, m_serialLimit);
+        return stack.empty();
+    }
+
+    template<typename Node>
+    struct TaskQueue
+    {
+        std::mutex mutex;
+        std::deque<Node> items;
+
+        void push(const Node &node)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            items.push_back(node);
+        }
+    };
+
+    // 先取自己队列的尾部（深度优先，局部性好），再从其他队列头部窃取（粒度更大）
+    template<typename Node>
+    static bool take(std::vector<TaskQueue<Node>> &queues, int id, Node &node)
+    {
+        {
+            TaskQueue<Node> &own = queues[id];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.items.empty()) {
+                node = own.items.back();
+                own.items.pop_back();
+                return true;
+            }
+        }
+        const int count = static_cast<int>(queues.size());
+        for (int k = 1; k < count; ++k) {
+            TaskQueue<Node> &victim = queues[(id + k) % count];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.items.empty()) {
+                node = victim.items.front();
+                victim.items.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 调用线程作为 0 号工作线程参与执行
+    template<typename Worker>
+    static void run(Worker &worker, int threads)
+    {
+        std::vector<std::thread> pool;
+        for (int i = 1; i < threads; ++i) {
+            pool.emplace_back(worker, i);
+        }
+        if (threads > 0) worker(0);
+        for (std::thread &thread : pool) {
+            thread.join();
+        }
+    }
+
+    int m_threads = 1;
+    int m_serialLimit = DefaultSerialLimit;
+};
+
+#endif // TREEWALKER_H
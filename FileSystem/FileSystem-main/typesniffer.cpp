@@ -0,0 +1,134 @@
+#include "typesniffer.h"
+#include "treewalker.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+
+static const quint32 CacheMagic = 0x46535459;   // "FSTY"
+static const quint32 CacheVersion = 2;    // 2：zip 按中央目录区分 Office 文档，旧结果作废
+static const int BatchSize = 4096;
+
+TypeSniffer::TypeSniffer(QObject *parent)
+    : QObject(parent), m_job(this)
+{
+}
+
+TypeSniffer::~TypeSniffer()
+{
+    cancel();
+}
+
+void TypeSniffer::start(const QStringList &files, const QStringList &suffixes, int threads)
+{
+    m_job.start([this, files, suffixes, threads]() -> BackgroundJob::Done {
+        if (!m_loaded) {
+            if (!loadCache()) m_cache.clear();
+            m_loaded = true;
+        }
+
+        struct Scan
+        {
+            bool valid = false;
+            bool read = false;
+            CacheEntry entry;
+        };
+
+        TreeWalker walker(threads);
+        int readFiles = 0;
+        bool changed = false;
+        for (int begin = 0; begin < files.size() && !m_job.isCancelled(); begin += BatchSize) {
+            std::vector<int> batch;
+            for (int i = begin; i < files.size() && i < begin + BatchSize; ++i) {
+                batch.push_back(i);
+            }
+
+            // 工作线程只读缓存，新结果在本批结束后统一写回
+            const QHash<FileStamp::Key, CacheEntry> &cache = m_cache;
+            const std::vector<Scan> scans = walker.map(batch, [&](int file) {
+                Scan scan;
+                if (m_job.isCancelled()) return scan;
+                if (!FileStamp::read(files[file], scan.entry.stamp)) return scan;
+                scan.valid = true;
+                scan.entry.suffix = suffixes.value(file).toLower();
+
+                auto it = cache.constFind(scan.entry.stamp.key);
+                if (it != cache.constEnd() && it->stamp.sameVersion(scan.entry.stamp) && it->suffix == scan.entry.suffix) {
+                    scan.entry.info = it->info;
+                    return scan;
+                }
+
+                QFile f(files[file]);
+                if (f.open(QIODevice::ReadOnly)) {
+                    scan.entry.info = fileTypeForFile(f, scan.entry.suffix, HeadSize);
+                    scan.read = true;
+                }
+                return scan;
+            });
+
+            QVector<SniffResult> results;
+            results.reserve(int(batch.size()));
+            for (size_t i = 0; i < batch.size(); ++i) {
+                const Scan &scan = scans[i];
+                if (!scan.valid) continue;
+                if (scan.read) {
+                    m_cache.insert(scan.entry.stamp.key, scan.entry);
+                    ++readFiles;
+                    changed = true;
+                }
+                results.append(SniffResult{batch[i], scan.entry.info});
+            }
+            m_job.post([this, results]() { emit typesFound(results); });
+        }
+
+        if (changed) {
+            saveCache();
+        }
+        const int scanned = files.size();
+        return [this, scanned, readFiles]() { emit finished(scanned, readFiles); };
+    });
+}
+
+bool TypeSniffer::loadCache()
+{
+    if (m_cacheFile.isEmpty()) return false;
+    QFile file(m_cacheFile);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if (magic != CacheMagic || version != CacheVersion) return false;
+
+    qint32 count = 0;
+    in >> count;
+    m_cache.clear();
+    m_cache.reserve(count);
+    for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        CacheEntry entry;
+        in >> entry.stamp.key.device >> entry.stamp.key.inode >> entry.stamp.modified >> entry.stamp.size
+           >> entry.suffix >> entry.info.type >> entry.info.iconKey;
+        m_cache.insert(entry.stamp.key, entry);
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+bool TypeSniffer::saveCache() const
+{
+    if (m_cacheFile.isEmpty()) return false;
+    QSaveFile file(m_cacheFile);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning("Couldn't open file type cache.");
+        return false;
+    }
+
+    QDataStream out(&file);
+    out << CacheMagic << CacheVersion;
+    out << qint32(m_cache.size());
+    for (auto it = m_cache.constBegin(); it != m_cache.constEnd(); ++it) {
+        out << it->stamp.key.device << it->stamp.key.inode << it->stamp.modified << it->stamp.size
+            << it->suffix << it->info.type << it->info.iconKey;
+    }
+    return file.commit();
+}
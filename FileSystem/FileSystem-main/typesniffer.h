@@ -0,0 +1,64 @@
+#ifndef TYPESNIFFER_H
+#define TYPESNIFFER_H
+
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <atomic>
+
+#include "backgroundjob.h"
+#include "filetypes.h"
+#include "filestamp.h"
+
+// 按内容识别出的文件类型：file 为文件在识别列表中的序号；无法按内容判断时 type 为空，由调用方退回按后缀识别
+struct SniffResult
+{
+    int file = -1;
+    FileTypeInfo info;
+};
+
+// 按文件开头的特征字节并行识别绑定文件的类型
+// 每批若干文件交给 TreeWalker 并行读取前 4 KiB，识别结果按批在主线程上通过 typesFound 发出。
+// 结果按 (设备, inode) 缓存并持久化，修改时间、大小和后缀都未变的文件不再读取。
+class TypeSniffer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TypeSniffer(QObject *parent = nullptr);
+    ~TypeSniffer();
+
+    // 缓存文件，首次识别时在后台线程加载
+    void setCacheFile(const QString &path) { m_cacheFile = path; m_loaded = false; }
+
+    // suffixes 为各文件节点名称的后缀：存储区中的文件没有后缀，识别旧版 Office 文档时以节点名称为准
+    void start(const QStringList &files, const QStringList &suffixes, int threads);
+    void cancel() { m_job.cancel(); }
+    bool isRunning() const { return m_job.isRunning(); }
+
+    static const int HeadSize = 4096;
+
+signals:
+    void typesFound(const QVector<SniffResult> &results);
+    void finished(int scannedFiles, int readFiles);
+
+private:
+    struct CacheEntry
+    {
+        FileStamp stamp;
+        QString suffix;         // 旧版 Office 文档要靠后缀区分，后缀变了也要重新识别
+        FileTypeInfo info;
+    };
+
+    bool loadCache();
+    bool saveCache() const;
+
+    BackgroundJob m_job;
+    QString m_cacheFile;
+    // 以下只在后台线程中访问，同一时刻至多一个识别线程
+    bool m_loaded = false;
+    QHash<FileStamp::Key, CacheEntry> m_cache;
+};
+
+#endif // TYPESNIFFER_H
@@ -1,9 +1,42 @@
 #include "widget.h"
 #include "ui_widget.h"
 
+#include <algorithm>
+#include <functional>
+
+static Counter s_loadMs("ui.load_ms", "上次加载耗时", Counter::Milliseconds);
+static Counter s_saveMs("ui.save_ms", "上次保存耗时", Counter::Milliseconds);
+static Counter s_searchMs("ui.search_ms", "上次搜索耗时", Counter::Milliseconds);
+
+// 遍历时获取第0列子项（第1列是类型，没有子项）
+static void itemChildren(QStandardItem *item, std::vector<QStandardItem*> &out)
+{
+    for (int i = 0; i < item->rowCount(); ++i) {
+        out.push_back(item->child(i, 0));
+    }
+}
+
+// QStandardItem 只能在界面线程访问，界面上的搜索、计数、复制等遍历都是单线程的，不随 FILESYS_THREADS 扩展；
+// 需要并行的工作先转成 TreeEngine 或普通数据再交给工作线程
+static const TreeWalker s_itemWalker(1);
+
+// 按先序收集 item 及其后代中 match 为真的项
+template<typename MatchFn>
+static std::vector<QStandardItem*> collectItems(QStandardItem *item, MatchFn match)
+{
+    std::vector<QStandardItem*> items;
+    if (match(item)) items.push_back(item);
+    const std::vector<QStandardItem*> found = s_itemWalker.collect(item, itemChildren, match);
+    items.insert(items.end(), found.begin(), found.end());
+    return items;
+}
+
 
 Widget::Widget(QWidget *parent)
-    : QWidget(parent), ui(new Ui::Widget)
+    : QWidget(parent), ui(new Ui::Widget),
+      m_walker(qEnvironmentVariableIntValue("FILESYS_THREADS"),
+               qEnvironmentVariableIsSet("FILESYS_SERIAL_LIMIT") ? qEnvironmentVariableIntValue("FILESYS_SERIAL_LIMIT") : -1),
+      m_store(qEnvironmentVariable("FILESYS_STORE", QDir::currentPath() + "/store"))
 {
     ui->setupUi(this);
     ui->copyName->setVisible(false);
@@ -11,12 +44,62 @@ Widget::Widget(QWidget *parent)
     connect(ui->nextButton, &QPushButton::clicked, this, &Widget::gotoNextResult);
     connect(ui->prevButton, &QPushButton::clicked, this, &Widget::gotoPrevResult);
 
-    // 启用拖放
+    m_contentSearch = new ContentSearch(this);
+    m_contentSearch->setIndexFile("contentindex.dat");
+
+    m_importer = new DirectoryImporter(this);
+    connect(m_importer, &DirectoryImporter::finished, this, &Widget::importFinished);
+
+    m_diskWatcher = new DiskWatcher(this);
+    connect(m_diskWatcher, &DiskWatcher::changed, this, &Widget::applyDiskChanges);
+
+    m_fileIo = new FileIoQueue(this);
+    connect(m_fileIo, &FileIoQueue::finished, this, &Widget::fileOperationsFinished);
+    connect(m_contentSearch, &ContentSearch::matchesFound, this, &Widget::addContentMatches);
+    connect(m_contentSearch, &ContentSearch::finished, this, &Widget::contentSearchFinished);
+
+    m_typeSniffer = new TypeSniffer(this);
+    m_typeSniffer->setCacheFile("typecache.dat");
+    connect(m_typeSniffer, &TypeSniffer::typesFound, this, &Widget::applySniffedTypes);
+    connect(m_typeSniffer, &TypeSniffer::finished, this, &Widget::typeDetectionFinished);
+
+    m_duplicateFinder = new DuplicateFinder(this);
+    m_duplicateFinder->setCacheFile("hashcache.dat");
+    connect(m_duplicateFinder, &DuplicateFinder::finished, this, &Widget::duplicatesFound);
+
+    // 事件循环延迟一直统计，诊断面板（F12）打开时才显示
+    m_loopMonitor = new EventLoopMonitor(this);
+    m_loopMonitor->start();
+    // 设置 FILESYS_STALL_MS 时，事件循环阻塞超过该毫秒数就在 stalls 目录写出报告；未设置或为 0 时不启动，
+    // 跟踪保持关闭
+    m_stallWatchdog = new StallWatchdog(m_loopMonitor, "stalls", this);
+    m_stallWatchdog->start(qEnvironmentVariableIntValue("FILESYS_STALL_MS"));
+    new QShortcut(QKeySequence(Qt::Key_F12), this, this, &Widget::show_diagnostics);
+
+    // 启用拖放：视图直接在模型中移动节点，只能放入文件夹和驱动器，由 SortModel 判断
     ui->treeView->setDragEnabled(true);
     ui->treeView->setAcceptDrops(true);
     ui->treeView->setDropIndicatorShown(true);
     ui->treeView->setDragDropMode(QAbstractItemView::InternalMove);
     ui->treeView->setSelectionMode(QAbstractItemView::SingleSelection);
+
+    // 视图通过排序模型显示，点击表头按列排序，底层模型的行序不变；初始为原始顺序
+    m_sortModel = new SortModel(&m_folderStats, &m_metadataColumns, this);
+    ui->treeView->setModel(m_sortModel);
+    ui->treeView->header()->setSortIndicator(-1, Qt::AscendingOrder);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 1, 0)
+    ui->treeView->header()->setSortIndicatorClearable(true);   // 第三次点击表头恢复原始顺序
+#endif
+    ui->treeView->setSortingEnabled(true);
+
+    // 键盘导航时同步更新路径，路径来自缓存，不重复拼接；点到汇总列时当前项回到名称列
+    connect(ui->treeView->selectionModel(), &QItemSelectionModel::currentChanged, this, [this](const QModelIndex &current) {
+        if (current.column() >= FolderStats::SizeColumn) {
+            ui->treeView->setCurrentIndex(current.sibling(current.row(), 0));
+            return;
+        }
+        ui->label->setText(show_path());
+    });
     // 图标映射初始化，添加校验
     QStringList iconKeys = {"treeItem_Computer", "treeItem_Disk", "treeItem_Project",
                             "treeItem_Unknownfile", "treeItem_txt", "treeItem_gif",
@@ -35,23 +118,51 @@ Widget::Widget(QWidget *parent)
         m_publicIconMap[iconKeys[i]] = icon;
     }
 
+    // 设置 FILESYS_SERVICE=服务名 时启用本地服务，外部工具（如 FileSysCli --server）可以查询和修改这棵树
+    if (qEnvironmentVariableIsSet("FILESYS_SERVICE")) {
+        m_treeService = new TreeService([this]() {
+            // 快照上的读取按请求在服务的线程池中并发执行，每个请求内单线程遍历
+            auto engine = std::make_unique<TreeEngine>(1);
+            fillEngine(*engine);
+            return engine;
+        }, [this](const QVector<TreeChange> &changes) {
+            applyTreeChanges(changes);
+        }, this);
+    }
+
     // 加载文件系统或初始化模型
     if (!QFile::exists("filesystem.json") || !loadFromJson("filesystem.json")) {
         initModel();
     }
+    watchImportedFolders();
+    commitWorkingFiles();
+
+    if (m_treeService) {
+        QString error;
+        if (!m_treeService->listen(qEnvironmentVariable("FILESYS_SERVICE"), &error)) {
+            qWarning("Failed to start local service: %s", qPrintable(error));
+        }
+    }
 
     ui->treeView->setContextMenuPolicy(Qt::CustomContextMenu);
 }
 
 Widget::~Widget()
 {
-    saveToJson("filesystem.json");
+    {
+        StallWatchdog::Activity activity("退出时保存");
+        saveToJson("filesystem.json");
+    }
+    setCopiedItem(nullptr);
+    // 看门狗读取监测器的心跳，先于子对象中的监测器停止
+    delete m_stallWatchdog;
+    delete treeModel();  // 释放旧模型
     delete ui;
-    delete ui->treeView->model();  // 释放旧模型
 }
 
 QStandardItem* Widget::deepCopyItem(QStandardItem* item)
 {
+    // clone 和 appendRow 只能在界面线程进行
     QStandardItem* newItem = item->clone();
     for (int i = 0; i < item->rowCount(); ++i) {
         QList<QStandardItem*> row;
@@ -65,18 +176,42 @@ QStandardItem* Widget::deepCopyItem(QStandardItem* item)
 
 void Widget::copy_file()
 {
-    QModelIndex currentIndex = ui->treeView->currentIndex();
-    QStandardItemModel *model = static_cast<QStandardItemModel*>(ui->treeView->model());
-    copiedItem = deepCopyItem(model->itemFromIndex(currentIndex));
+    QModelIndex currentIndex = currentSourceIndex();
+    QStandardItemModel *model = treeModel();
+    setCopiedItem(deepCopyItem(model->itemFromIndex(currentIndex)));
     ui->copyName->setText(model->itemFromIndex(currentIndex)->text());
 }
 
+void Widget::setCopiedItem(QStandardItem* item)
+{
+    // 旧副本是存储内容的一个引用，替换后释放；不再被任何节点引用的内容随之删除
+    QStandardItem* old = copiedItem;
+    copiedItem = item;
+    if (!old) return;
+    QStringList stored;
+    boundFiles(old, &stored);
+    delete old;
+    if (!stored.isEmpty()) {
+        removeBoundFiles(stored);
+    }
+}
+
 void Widget::paste_file()
+{
+    pasteItem(false);
+}
+
+void Widget::paste_file_copy()
+{
+    pasteItem(true);
+}
+
+void Widget::pasteItem(bool copyFiles)
 {
     if (!copiedItem) return;
 
-    QStandardItemModel *model = static_cast<QStandardItemModel*>(ui->treeView->model());
-    QModelIndex currentIndex = ui->treeView->currentIndex();
+    QStandardItemModel *model = treeModel();
+    QModelIndex currentIndex = currentSourceIndex();
 
     if (!isDropTargetValid(currentIndex)) {
         QMessageBox::warning(this, "无效操作", "只能粘贴到文件夹中！");
@@ -91,183 +226,510 @@ void Widget::paste_file()
         return;
     }
 
+    TRACE_SCOPE("paste");
+    StallWatchdog::Activity activity(QString("粘贴 %1 到 %2").arg(name, currentItem->text()));
     QStandardItem *newItem = deepCopyItem(copiedItem);
     QString newType = newItem->data(Qt::UserRole + 1).toString();
     QStandardItem *newTypeItem = new QStandardItem(newType);
     newTypeItem->setData(newType, Qt::UserRole + 1);
     currentItem->appendRow({newItem, newTypeItem});
-    ui->treeView->setCurrentIndex(newItem->index());
+    detachWorkingCopies(newItem);
+    if (copyFiles) {
+        copyBoundFiles(newItem);
+    }
+    setCurrentSourceIndex(newItem->index());
+}
+
+void Widget::copyBoundFiles(QStandardItem* item)
+{
+    // 直接绑定磁盘路径的文件复制到存储的工作区，副本从此与原文件无关；存储中的内容本就共享，不需复制
+    const std::vector<QStandardItem*> found = collectItems(item, [](QStandardItem *node) {
+        return !node->data(Qt::UserRole + 2).toString().isEmpty()
+               && node->data(Qt::UserRole + 3).toString().isEmpty();
+    });
+
+    int copies = 0;
+    for (QStandardItem *node : found) {
+        // 导入的文件夹副本不再对应磁盘目录
+        if (node->data(Qt::UserRole + 1).toString() == "文件夹") {
+            node->setData(QVariant(), Qt::UserRole + 2);
+            continue;
+        }
+        QString source = node->data(Qt::UserRole + 2).toString();
+        bindBlob(node, BlobStore::newWorkingId());
+        quint64 id = m_fileIo->copy(source, node->data(Qt::UserRole + 2).toString());
+        m_pendingIo.insert(id, QPersistentModelIndex(node->index()));
+        ++copies;
+    }
+    if (copies == 0) return;
+
+    // 复制在后台进行，这里定时读取已复制的字节数显示吞吐量
+    if (!m_copyTimer) {
+        m_copyTimer = new QTimer(this);
+        connect(m_copyTimer, &QTimer::timeout, this, &Widget::updateCopyProgress);
+    }
+    if (!m_copyTimer->isActive()) {
+        m_copyStartBytes = m_fileIo->copiedBytes();
+        m_copyClock.start();
+        m_copyTimer->start(250);
+    }
+}
+
+void Widget::updateCopyProgress()
+{
+    const double megabytes = (m_fileIo->copiedBytes() - m_copyStartBytes) / (1024.0 * 1024.0);
+    const double seconds = qMax<qint64>(m_copyClock.elapsed(), 1) / 1000.0;
+    if (m_fileIo->pending() > 0) {
+        ui->label->setText(QString("正在复制文件... 已复制 %1 MB（%2 MB/s）")
+                               .arg(megabytes, 0, 'f', 1).arg(megabytes / seconds, 0, 'f', 1));
+        return;
+    }
+    m_copyTimer->stop();
+    ui->label->setText(QString("复制完成：%1 MB，用时 %2 秒，平均 %3 MB/s")
+                           .arg(megabytes, 0, 'f', 1).arg(seconds, 0, 'f', 2).arg(megabytes / seconds, 0, 'f', 1));
 }
 
 void Widget::delete_project()
 {
-    QModelIndex currentIndex = ui->treeView->currentIndex();
+    QModelIndex currentIndex = currentSourceIndex();
     if (!currentIndex.parent().isValid()) return;  // 避免删除根节点
-    QStandardItemModel* model = static_cast<QStandardItemModel*>(ui->treeView->model());
+    QStandardItemModel* model = treeModel();
     QStandardItem* currentItem = model->itemFromIndex(currentIndex.parent());
+
+    // 子树中绑定了磁盘文件的节点，询问是否一并删除磁盘文件；存储中的内容不再被引用时总是删除
+    QStringList stored;
+    QStringList files = boundFiles(model->itemFromIndex(currentIndex.sibling(currentIndex.row(), 0)), &stored);
+    bool removeFiles = false;
+    if (!files.isEmpty()) {
+        QMessageBox::StandardButton answer = QMessageBox::question(this, "删除",
+            QString("是否同时删除磁盘上对应的 %1 个文件？").arg(files.size()),
+            QMessageBox::Yes | QMessageBox::No | QMessageBox::Cancel, QMessageBox::No);
+        if (answer == QMessageBox::Cancel) return;
+        removeFiles = (answer == QMessageBox::Yes);
+    }
+
     currentItem->removeRow(currentIndex.row());
+    unwatchRemovedFolders();
+
+    if (removeFiles) {
+        stored += files;
+    }
+    if (!stored.isEmpty()) {
+        removeBoundFiles(stored);
+    }
 }
 
-void Widget::delete_file()
+QStringList Widget::boundFiles(QStandardItem* item, QStringList* stored)
 {
-    delete_project();
+    auto isBoundFile = [](QStandardItem *node) {
+        QString type = node->data(Qt::UserRole + 1).toString();
+        return type != "文件夹" && type != "驱动器" && type != "system"
+               && !node->data(Qt::UserRole + 2).toString().isEmpty();
+    };
+
+    QStringList files;
+    if (!item) return files;
+    for (QStandardItem *node : collectItems(item, isBoundFile)) {
+        bool inStore = !node->data(Qt::UserRole + 3).toString().isEmpty();
+        if (!inStore) {
+            files.append(node->data(Qt::UserRole + 2).toString());
+        } else if (stored) {
+            stored->append(node->data(Qt::UserRole + 2).toString());
+        }
+    }
+    return files;
 }
 
-QJsonObject Widget::saveItem(QStandardItem *item)
+void Widget::removeBoundFiles(const QStringList& files)
 {
-    QJsonObject obj;
-    obj["name"] = item->text();
-    obj["type"] = item->data(Qt::UserRole + 1).toString();
-
-    // 保存路径（用于文件双击打开）
-    QString path = item->data(Qt::UserRole + 2).toString();
-    if (!path.isEmpty()) {
-        obj["path"] = path;
+    // 粘贴出的副本与原节点绑定同一个文件，仍被其他节点引用的文件不删除
+    // 复制到剪贴板的副本也算引用：其中的存储内容要保留到粘贴时，磁盘上的文件则按用户的选择删除
+    const QSet<QString> candidates(files.cbegin(), files.cend());
+    QStandardItemModel* model = treeModel();
+    QSet<QString> stillUsed;
+    s_itemWalker.walk(model->invisibleRootItem(), itemChildren, [&](QStandardItem *child, int) {
+        QString path = child->data(Qt::UserRole + 2).toString();
+        if (!path.isEmpty() && candidates.contains(path)) {
+            stillUsed.insert(path);
+        }
+        return child->hasChildren();
+    });
+    if (copiedItem) {
+        for (QStandardItem *node : collectItems(copiedItem, [](QStandardItem *node) {
+                 return !node->data(Qt::UserRole + 3).toString().isEmpty();
+             })) {
+            stillUsed.insert(node->data(Qt::UserRole + 2).toString());
+        }
     }
-
-    // 保存图标 key
-    for (auto it = m_publicIconMap.constBegin(); it != m_publicIconMap.constEnd(); ++it) {
-        if (it.value().cacheKey() == item->icon().cacheKey()) {
-            obj["icon"] = it.key();
-            break;
+    for (const QString &path : candidates) {
+        if (!stillUsed.contains(path)) {
+            m_fileIo->remove(path);
         }
     }
+}
 
-    // 保存子项（仅第0列递归）
-    if (item->rowCount() > 0) {
-        QJsonArray children;
-        for (int i = 0; i < item->rowCount(); ++i) {
-            children.append(saveItem(item->child(i, 0)));
+void Widget::fileOperationsFinished(const QVector<FileOperation> &results)
+{
+    QStandardItemModel* model = treeModel();
+    QStringList removeErrors;
+    QHash<QString, QString> storedIds;
+    for (const FileOperation &op : results) {
+        QStandardItem* item = model->itemFromIndex(m_pendingIo.take(op.id));
+        const bool openAfter = m_openAfterIo.remove(op.id);
+        if (op.ok) {
+            if (op.kind == FileOperation::Copy && openAfter) {
+                openPath(op.target);
+            } else if (op.kind == FileOperation::Store) {
+                storedIds.insert(m_store.idForPath(op.path), op.target);
+            }
+            continue;
         }
-        obj["children"] = children;
+
+        qWarning("File operation failed on %s: %s", qPrintable(op.path), qPrintable(op.error));
+        switch (op.kind) {
+        case FileOperation::Create:
+            // 文件没有建成，解除绑定，双击时提示未绑定路径
+            if (item) {
+                bindBlob(item, QString());
+                markFileError(item, QString("创建磁盘文件失败：%1").arg(op.error));
+            }
+            break;
+        case FileOperation::Rename:
+            // 恢复原来的名称和路径
+            if (item) {
+                if (item->data(Qt::UserRole + 2).toString() == op.target) {
+                    item->setData(op.path, Qt::UserRole + 2);
+                    if (item->text() == QFileInfo(op.target).fileName()) {
+                        item->setText(QFileInfo(op.path).fileName());
+                    }
+                }
+                markFileError(item, QString("重命名磁盘文件失败：%1").arg(op.error));
+            }
+            break;
+        case FileOperation::Remove:
+            // 节点已经删除，只能在状态栏报告
+            removeErrors.append(QString("%1（%2）").arg(op.path, op.error));
+            break;
+        case FileOperation::Copy:
+            // 检出失败，恢复引用原来的内容
+            if (item) {
+                if (item->data(Qt::UserRole + 2).toString() == op.target) {
+                    QString oldId = m_store.idForPath(op.path);
+                    if (oldId.isEmpty()) {
+                        item->setData(op.path, Qt::UserRole + 2);
+                    } else {
+                        bindBlob(item, oldId);
+                    }
+                }
+                markFileError(item, QString("复制磁盘文件失败：%1").arg(op.error));
+            }
+            break;
+        case FileOperation::Store:
+            // 工作副本保持原样，下次启动再试
+            break;
+        }
+    }
+    if (!removeErrors.isEmpty()) {
+        ui->label->setText(QString("有 %1 个磁盘文件删除失败：%2").arg(removeErrors.size()).arg(removeErrors.first()));
+    }
+    if (!storedIds.isEmpty()) {
+        rebindStoredFiles(storedIds);
     }
+}
 
-    return obj;
+void Widget::bindBlob(QStandardItem* item, const QString& id)
+{
+    if (id.isEmpty()) {
+        item->setData(QVariant(), Qt::UserRole + 3);
+        item->setData(QVariant(), Qt::UserRole + 2);
+        return;
+    }
+    item->setData(id, Qt::UserRole + 3);
+    item->setData(m_store.pathFor(id), Qt::UserRole + 2);
 }
 
-QList<QStandardItem*> Widget::loadItem(const QJsonObject &obj)
+std::vector<QStandardItem*> Widget::workingCopies(QStandardItem* item)
 {
-    QString name = obj["name"].toString();
-    QString type = obj["type"].toString();
-    QString iconName = obj["icon"].toString();
-    QString path = obj["path"].toString();  // 从 JSON 中读取路径字段
+    auto isWorking = [](QStandardItem *node) {
+        return BlobStore::isWorking(node->data(Qt::UserRole + 3).toString());
+    };
+    return collectItems(item, isWorking);
+}
 
-    QStandardItem *item = new QStandardItem(name);
-    item->setData(type, Qt::UserRole + 1);
+void Widget::detachWorkingCopies(QStandardItem* item)
+{
+    // 工作副本可能正在被编辑，粘贴时另复制一份；存储中的内容直接共享
+    for (QStandardItem *node : workingCopies(item)) {
+        QString source = node->data(Qt::UserRole + 2).toString();
+        bindBlob(node, BlobStore::newWorkingId());
+        quint64 id = m_fileIo->copy(source, node->data(Qt::UserRole + 2).toString());
+        m_pendingIo.insert(id, QPersistentModelIndex(node->index()));
+    }
+}
 
-    // 恢复路径数据（用于双击打开）
-    if (!path.isEmpty()) {
-        item->setData(path, Qt::UserRole + 2);
+void Widget::commitWorkingFiles()
+{
+    // 上次检出的工作副本在后台重新计算哈希存回，完成后改为引用存储中的内容
+    QStandardItemModel* model = treeModel();
+    QSet<QString> working;
+    for (QStandardItem *node : workingCopies(model->invisibleRootItem())) {
+        working.insert(node->data(Qt::UserRole + 3).toString());
+    }
+    for (const QString &id : working) {
+        m_fileIo->store(m_store.pathFor(id), m_store.root());
     }
+}
 
-    if (!iconName.isEmpty() && m_publicIconMap.contains(iconName)) {
-        item->setIcon(m_publicIconMap[iconName]);
+void Widget::rebindStoredFiles(const QHash<QString, QString>& storedIds)
+{
+    QStandardItemModel* model = treeModel();
+    for (QStandardItem *node : workingCopies(model->invisibleRootItem())) {
+        auto it = storedIds.constFind(node->data(Qt::UserRole + 3).toString());
+        if (it != storedIds.constEnd()) {
+            bindBlob(node, it.value());
+        }
     }
+}
 
-    QStandardItem *typeItem = new QStandardItem(type);
-    typeItem->setData(type, Qt::UserRole + 1);
+bool Widget::checkoutForEditing(QStandardItem* item)
+{
+    // 存储中的内容不可修改，先检出独立副本，复制完成后再打开
+    QString id = item->data(Qt::UserRole + 3).toString();
+    if (id.isEmpty() || BlobStore::isWorking(id)) return false;
+
+    QString source = m_store.pathFor(id);
+    bindBlob(item, BlobStore::newWorkingId());
+    quint64 op = m_fileIo->copy(source, item->data(Qt::UserRole + 2).toString());
+    m_pendingIo.insert(op, QPersistentModelIndex(item->index()));
+    m_openAfterIo.insert(op);
+    return true;
+}
 
-    // 加载子项（仅第0列递归）
-    if (obj.contains("children")) {
-        QJsonArray children = obj["children"].toArray();
-        for (const QJsonValue &child : children) {
-            QList<QStandardItem*> childRow = loadItem(child.toObject());
-            item->appendRow(childRow);
-        }
+void Widget::openPath(const QString& filePath)
+{
+    bool ok = QDesktopServices::openUrl(QUrl::fromLocalFile(filePath));
+    if (!ok) {
+        QMessageBox::warning(this, "打开失败", QString("无法打开文件：\n%1").arg(filePath));
     }
+}
 
-    return { item, typeItem };
+void Widget::markFileError(QStandardItem* item, const QString& message)
+{
+    item->setForeground(QBrush(Qt::red));
+    item->setToolTip(message);
 }
 
-void Widget::saveToJson(const QString &filename)
+void Widget::delete_file()
 {
-    QFile file(filename);
-    if (!file.open(QIODevice::WriteOnly)) {
-        qWarning("Couldn't open save file.");
-        return;
+    delete_project();
+}
+
+std::unique_ptr<TreeNode> Widget::nodeFromItem(QStandardItem *item, const QHash<qint64, QString> &iconKeys) const
+{
+    auto node = std::make_unique<TreeNode>();
+    node->name = item->text();
+    node->type = item->data(Qt::UserRole + 1).toString();
+    node->blob = item->data(Qt::UserRole + 3).toString();
+    if (node->blob.isEmpty()) {
+        node->path = item->data(Qt::UserRole + 2).toString();
     }
+    // 图标换成图标键
+    node->icon = iconKeys.value(item->icon().cacheKey());
+    // 只有第0列有子项
+    for (int i = 0; i < item->rowCount(); ++i) {
+        node->append(nodeFromItem(item->child(i, 0), iconKeys));
+    }
+    return node;
+}
 
-    QJsonObject root;
-    QJsonArray items;
-    QStandardItemModel *model = static_cast<QStandardItemModel*>(ui->treeView->model());
+QStandardItem* Widget::itemFromNode(const TreeNode *node) const
+{
+    QStandardItem *item = new QStandardItem(node->name);
+    item->setData(node->type, Qt::UserRole + 1);
+    // 存储中的文件只记录内容编号，路径随存储根目录变化
+    if (!node->blob.isEmpty()) {
+        item->setData(node->blob, Qt::UserRole + 3);
+        item->setData(m_store.pathFor(node->blob), Qt::UserRole + 2);
+    } else if (!node->path.isEmpty()) {
+        item->setData(node->path, Qt::UserRole + 2);
+    }
+    if (!node->icon.isEmpty() && m_publicIconMap.contains(node->icon)) {
+        item->setIcon(m_publicIconMap[node->icon]);
+    }
+    for (int i = 0; i < node->childCount(); ++i) {
+        const TreeNode *child = node->child(i);
+        QStandardItem *typeItem = new QStandardItem(child->type);
+        typeItem->setData(child->type, Qt::UserRole + 1);
+        item->appendRow({itemFromNode(child), typeItem});
+    }
+    return item;
+}
 
+void Widget::saveToJson(const QString &filename)
+{
+    TRACE_SCOPE("save");
+    ScopedDuration duration(s_saveMs);
+    StallWatchdog::Activity activity("保存 " + filename);
+    // 界面树先转换为引擎节点，由引擎按 filesystem.json 格式写出
+    TreeEngine engine(m_walker.threadCount(), m_walker.serialLimit());
+    fillEngine(engine);
+    engine.save(filename);
+}
+
+// 界面树转换为引擎节点；读取 QStandardItem 只能在界面线程，之后的保存、统计等由引擎并行处理
+void Widget::fillEngine(TreeEngine &engine)
+{
+    QStandardItemModel *model = treeModel();
+    QHash<qint64, QString> iconKeys;
+    for (auto icon = m_publicIconMap.constBegin(); icon != m_publicIconMap.constEnd(); ++icon) {
+        iconKeys.insert(icon.value().cacheKey(), icon.key());
+    }
     for (int i = 0; i < model->rowCount(); ++i) {
-        items.append(saveItem(model->item(i, 0)));
+        engine.root()->append(nodeFromItem(model->item(i, 0), iconKeys));
     }
-
-    root["items"] = items;
-    file.write(QJsonDocument(root).toJson());
-    file.close();
 }
 
 bool Widget::loadFromJson(const QString &filename)
 {
-    QFile file(filename);
-    if (!file.open(QIODevice::ReadOnly)) return false;
+    TRACE_SCOPE("load");
+    ScopedDuration duration(s_loadMs);
+    StallWatchdog::Activity activity("加载 " + filename);
+    TreeEngine engine(m_walker.threadCount(), m_walker.serialLimit());
+    if (!engine.load(filename)) return false;
+    showTree(engine);
+    return true;
+}
 
-    QByteArray data = file.readAll();
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    if (doc.isNull()) return false;
+void Widget::initModel()
+{
+    TreeEngine engine(m_walker.threadCount(), m_walker.serialLimit());
+    engine.createSample();
+    showTree(engine);
+    ui->treeView->update();
+}
 
-    delete ui->treeView->model();
+void Widget::showTree(const TreeEngine &engine)
+{
+    TRACE_SCOPE("show_tree");
+    delete treeModel();
     QStandardItemModel *model = new QStandardItemModel(ui->treeView);
-    model->setHorizontalHeaderLabels(QStringList() << "名称" << "类型");
-
-    QJsonArray items = doc.object()["items"].toArray();
-    for (const QJsonValue &val : items) {
-        QList<QStandardItem*> rowItems = loadItem(val.toObject());
-        model->appendRow(rowItems);
+    model->setHorizontalHeaderLabels(QStringList() << "名称" << "类型" << "大小" << "文件数" << "修改时间" << "权限");
+
+    // 引擎已在工作线程上完成解析，QStandardItem 在界面线程上创建
+    for (int i = 0; i < engine.root()->childCount(); ++i) {
+        const TreeNode *node = engine.root()->child(i);
+        QStandardItem *typeItem = new QStandardItem(node->type);
+        typeItem->setData(node->type, Qt::UserRole + 1);
+        model->appendRow({itemFromNode(node), typeItem});
     }
 
-    ui->treeView->setModel(model);
+    setTreeModel(model);
+}
+
+void Widget::setTreeModel(QStandardItemModel *model)
+{
+    m_sortModel->setSourceModel(model);
     ui->treeView->header()->resizeSection(0, 300);
-    return true;
+    m_pathIndex.setModel(model);
+    m_folderStats.setModel(model, m_walker.threadCount());
+    m_metadataColumns.setView(ui->treeView, model, m_walker.threadCount());
+    m_modelCounters.setModel(model);
+
+    if (m_treeService) {
+        // 服务快照只含名称、类型、绑定和图标，后台统计的大小等数据变化时不必重建
+        m_treeService->invalidate();
+        auto invalidate = [this]() { m_treeService->invalidate(); };
+        connect(model, &QAbstractItemModel::rowsInserted, m_treeService, invalidate);
+        connect(model, &QAbstractItemModel::rowsRemoved, m_treeService, invalidate);
+        connect(model, &QAbstractItemModel::rowsMoved, m_treeService, invalidate);
+        connect(model, &QAbstractItemModel::modelReset, m_treeService, invalidate);
+        connect(model, &QAbstractItemModel::dataChanged, m_treeService,
+                [this](const QModelIndex &, const QModelIndex &, const QVector<int> &roles) {
+            static const QVector<int> snapshotRoles = {Qt::DisplayRole, Qt::EditRole, Qt::DecorationRole,
+                                                       Qt::UserRole + 1, Qt::UserRole + 2, Qt::UserRole + 3};
+            bool relevant = roles.isEmpty();
+            for (int role : roles) {
+                relevant = relevant || snapshotRoles.contains(role);
+            }
+            if (relevant) m_treeService->invalidate();
+        });
+    }
 }
 
+// 按各级名称查找节点，规则与 TreeEngine::nodeAt 相同，空路径为不可见根节点
+static QStandardItem *itemAtPath(QStandardItemModel *model, const QStringList &components)
+{
+    QStandardItem *item = model->invisibleRootItem();
+    for (const QString &name : components) {
+        const int row = TreeEngine::childRow(item->rowCount(), [item](int i) { return item->child(i, 0)->text(); },
+                                             name);
+        if (row < 0) return nullptr;
+        item = item->child(row, 0);
+    }
+    return item;
+}
 
-void Widget::initModel()
+// 本地服务在快照上执行的修改同步到界面模型，只改树结构，不动磁盘上的绑定文件
+void Widget::applyTreeChanges(const QVector<TreeChange> &changes)
 {
-    QStandardItemModel* model = new QStandardItemModel(ui->treeView);
-    model->setHorizontalHeaderLabels(QStringList() << "名称" << "类型");
-
-    QVector<QString> myDisks = {"C盘", "D盘", "E盘"};
-
-    QStandardItem* myComputer = new QStandardItem(m_publicIconMap["treeItem_Computer"], "我的电脑");
-    myComputer->setData("system", Qt::UserRole + 1);
-    QStandardItem* myComputerType = new QStandardItem("system");
-    myComputerType->setData("system", Qt::UserRole + 1);
-    model->appendRow({myComputer, myComputerType});
-
-    for (int i = 0; i < myDisks.size(); i++) {
-        QStandardItem* myDisk = new QStandardItem(m_publicIconMap["treeItem_Disk"], myDisks[i]);
-        myDisk->setData("驱动器", Qt::UserRole + 1);
-        QStandardItem* myDiskType = new QStandardItem("驱动器");
-        myDiskType->setData("驱动器", Qt::UserRole + 1);
-        myComputer->appendRow({myDisk, myDiskType});
-
-        for (int j = 1; j < 3; j++) {
-            QStandardItem* myProject = new QStandardItem(m_publicIconMap["treeItem_Project"], "文件夹" + QString::number(j));
-            myProject->setData("文件夹", Qt::UserRole + 1);
-            QStandardItem* myProjectType = new QStandardItem("文件夹");
-            myProjectType->setData("文件夹", Qt::UserRole + 1);
-            myDisk->appendRow({myProject, myProjectType});
-
-            QString fileName = "文件.txt";
-            QStringList strList = fileName.split(".");
-            QString fileType = (strList.size() < 2 || strList[1] != "txt") ? "未知文件" : "txt文件";
-            QIcon fileIcon = (fileType == "未知文件") ? m_publicIconMap["treeItem_Unknownfile"] : m_publicIconMap["treeItem_txt"];
-
-            QStandardItem* myFile = new QStandardItem(fileIcon, fileName);
-            myFile->setData(fileType, Qt::UserRole + 1);
-            QStandardItem* myFileType = new QStandardItem(fileType);
-            myFileType->setData(fileType, Qt::UserRole + 1);
-            myProject->appendRow({myFile, myFileType});
+    QStandardItemModel *model = treeModel();
+    bool detached = false;
+    for (const TreeChange &change : changes) {
+        QStandardItem *item = itemAtPath(model, change.path);
+        QStandardItem *target = change.kind == TreeChange::Move ? itemAtPath(model, change.target) : item;
+        if (!item || !target) {
+            // 快照由界面树生成，两边不一致时只能放弃这条修改，下次请求前重建快照
+            qWarning("Local service: %s not found in the view", qPrintable(change.path.join('/')));
+            m_treeService->invalidate();
+            continue;
+        }
+        QStandardItem *parent = item->parent() ? item->parent() : model->invisibleRootItem();
+        switch (change.kind) {
+        case TreeChange::Insert: {
+            QStandardItem *typeItem = new QStandardItem(change.node->type);
+            typeItem->setData(change.node->type, Qt::UserRole + 1);
+            item->appendRow({itemFromNode(change.node), typeItem});
+            break;
+        }
+        case TreeChange::Remove:
+            parent->removeRow(item->row());
+            detached = true;
+            break;
+        case TreeChange::Move:
+            item->setText(change.name);
+            if (target != parent) {
+                target->appendRow(parent->takeRow(item->row()));
+                detached = true;
+            }
+            break;
         }
     }
+    // 移出模型的节点失去持久索引，移动的导入目录重新监视
+    if (detached) {
+        const int watched = m_watchedRoots.size();
+        unwatchRemovedFolders();
+        if (m_watchedRoots.size() != watched) watchImportedFolders();
+    }
+}
 
-    ui->treeView->setModel(model);
-    ui->treeView->header()->resizeSection(0, 300);
-    ui->treeView->update();
+QStandardItemModel* Widget::treeModel() const
+{
+    return static_cast<QStandardItemModel*>(m_sortModel->sourceModel());
+}
+
+QModelIndex Widget::currentSourceIndex() const
+{
+    return m_sortModel->mapToSource(ui->treeView->currentIndex());
+}
+
+QModelIndex Widget::sourceIndexAt(const QPoint &pos) const
+{
+    return m_sortModel->mapToSource(ui->treeView->indexAt(pos));
+}
+
+void Widget::setCurrentSourceIndex(const QModelIndex &index)
+{
+    ui->treeView->setCurrentIndex(m_sortModel->mapFromSource(index));
 }
 
 
@@ -279,31 +741,23 @@ void Widget::on_treeView_clicked(const QModelIndex &index)
 
 QString Widget::show_path()
 {
-    QModelIndex currentIndex = ui->treeView->currentIndex();
+    QModelIndex currentIndex = currentSourceIndex();
     if (!currentIndex.isValid()) return "";
 
-    QStringList pathList;
-
     // 只从第0列取名称（第1列是类型）
-    QModelIndex index = currentIndex.sibling(currentIndex.row(), 0);
-    while (index.isValid()) {
-        QString name = ui->treeView->model()->data(index, Qt::DisplayRole).toString();
-        pathList.prepend(name);
-        index = index.parent();
-    }
-
-    QString fullPath = pathList.join(" / ");
-    return fullPath;
+    QStandardItemModel* model = treeModel();
+    QStandardItem* item = model->itemFromIndex(currentIndex.sibling(currentIndex.row(), 0));
+    return m_pathIndex.displayPath(item);
 }
 
 
 void Widget::on_treeView_customContextMenuRequested(const QPoint &pos)
 {
-    QModelIndex currentIndex = ui->treeView->indexAt(pos);
+    QModelIndex currentIndex = sourceIndexAt(pos);
     if (!currentIndex.isValid()) return;
 
     // 直接从模型中获取类型信息
-    QVariant typeData = ui->treeView->model()->data(currentIndex.sibling(currentIndex.row(), 1), Qt::DisplayRole);
+    QVariant typeData = treeModel()->data(currentIndex.sibling(currentIndex.row(), 1), Qt::DisplayRole);
     QString currentInfo = typeData.isValid() ? typeData.toString() : "";
 
     if (currentInfo.isEmpty() || currentInfo == "system") {
@@ -329,13 +783,18 @@ void Widget::on_treeView_customContextMenuRequested(const QPoint &pos)
         newFileMenu->addAction("压缩文件 (.zip)", this, [=]() { new_file_with_type("zip"); });
 
         menu.addMenu(newFileMenu);  // 添加到主菜单中
+        menu.addAction("导入文件夹...", this, &Widget::import_folder);
+        menu.addAction("按内容识别类型", this, &Widget::detect_types);
+        menu.addAction("查找重复文件", this, &Widget::find_duplicates);
 
         menu.addAction("删除", this, &Widget::delete_project);
 
         QAction* pasteAction = menu.addAction("粘贴", this, &Widget::paste_file);
+        QAction* pasteCopyAction = menu.addAction("粘贴并复制文件", this, &Widget::paste_file_copy);
         menu.addAction("重命名", this, &Widget::rename_item);
 
         pasteAction->setEnabled(!ui->copyName->text().isEmpty());
+        pasteCopyAction->setEnabled(!ui->copyName->text().isEmpty());
 
     } else {
         menu.addAction("新建文件夹", this, &Widget::new_project);
@@ -350,14 +809,26 @@ void Widget::on_treeView_customContextMenuRequested(const QPoint &pos)
         newFileMenu->addAction("Excel文档 (.xls)", this, [=]() { new_file_with_type("xls"); });
         newFileMenu->addAction("压缩文件 (.zip)", this, [=]() { new_file_with_type("zip"); });
         menu.addMenu(newFileMenu);
+        menu.addAction("导入文件夹...", this, &Widget::import_folder);
+        menu.addAction("按内容识别类型", this, &Widget::detect_types);
+        menu.addAction("查找重复文件", this, &Widget::find_duplicates);
 
         menu.addAction("删除", this, &Widget::delete_file);
         menu.addAction("复制", this, &Widget::copy_file);
 
         QAction* pasteAction = menu.addAction("粘贴", this, &Widget::paste_file);
+        QAction* pasteCopyAction = menu.addAction("粘贴并复制文件", this, &Widget::paste_file_copy);
         menu.addAction("重命名", this, &Widget::rename_item);
 
         pasteAction->setEnabled(!ui->copyName->text().isEmpty());
+        pasteCopyAction->setEnabled(!ui->copyName->text().isEmpty());
+    }
+
+    menu.addSeparator();
+    menu.addAction("内存占用", this, &Widget::show_memory_usage);
+    menu.addAction("诊断面板", this, &Widget::show_diagnostics);
+    if (Trace::isEnabled()) {
+        menu.addAction("导出性能跟踪...", this, &Widget::export_trace);
     }
 
     menu.exec(ui->treeView->viewport()->mapToGlobal(pos));
@@ -370,8 +841,8 @@ void Widget::new_project()
     QString time = QString::number(timestamp);
     QString folderName = "新建文件夹" + time;
 
-    QStandardItemModel* model = static_cast<QStandardItemModel*>(ui->treeView->model());
-    QModelIndex currentIndex = ui->treeView->currentIndex();
+    QStandardItemModel* model = treeModel();
+    QModelIndex currentIndex = currentSourceIndex();
     QStandardItem* currentItem = model->itemFromIndex(currentIndex);
 
     // 如果当前不是文件夹，添加到其父项
@@ -389,7 +860,7 @@ void Widget::new_project()
     QStandardItem* typeItem = new QStandardItem("文件夹");
     typeItem->setData("文件夹", Qt::UserRole + 1);
     currentItem->appendRow({myProject, typeItem});
-    ui->treeView->setCurrentIndex(myProject->index());
+    setCurrentSourceIndex(myProject->index());
 }
 
 void Widget::new_file()
@@ -398,8 +869,8 @@ void Widget::new_file()
     QString time = QString::number(timestamp);
     QString fileName = "新建文件" + time + ".txt";  // 默认是 txt，可改为其他扩展名测试
 
-    QStandardItemModel* model = static_cast<QStandardItemModel*>(ui->treeView->model());
-    QModelIndex currentIndex = ui->treeView->currentIndex();
+    QStandardItemModel* model = treeModel();
+    QModelIndex currentIndex = currentSourceIndex();
     QStandardItem* currentItem = model->itemFromIndex(currentIndex);
 
     // 如果当前项不是文件夹，则添加到其父项
@@ -412,40 +883,10 @@ void Widget::new_file()
         return;
     }
 
-    // 根据后缀判断文件类型
-    QStringList strList = fileName.split(".");
-    QString suffix = (strList.size() >= 2) ? strList[1].toLower() : "";
-    QString fileType;
-    QString iconKey;
-
-    if (suffix == "txt") {
-        fileType = "txt文件";
-        iconKey = "treeItem_txt";
-    } else if (suffix == "pdf") {
-        fileType = "pdf文档";
-        iconKey = "treeItem_pdf";
-    } else if (suffix == "png") {
-        fileType = "png文件";
-        iconKey = "treeItem_png";
-    } else if (suffix == "doc") {
-        fileType = "Word文档";
-        iconKey = "treeItem_doc";
-    } else if (suffix == "gif") {
-        fileType = "gif文件";
-        iconKey = "treeItem_gif";
-    } else if (suffix == "ppt") {
-        fileType = "ppt文档";
-        iconKey = "treeItem_ppt";
-    } else if (suffix == "xls") {
-        fileType = "xls文档";
-        iconKey = "treeItem_xls";
-    } else if (suffix == "zip") {
-        fileType = "zip文件";
-        iconKey = "treeItem_zip";
-    }else {
-        fileType = "未知文件";
-        iconKey = "treeItem_Unknownfile";
-    }
+    // 根据最后一个后缀判断文件类型，"a.tar.gz" 按 "gz" 识别
+    FileTypeInfo typeInfo = fileTypeForSuffix(QFileInfo(fileName).suffix());
+    QString fileType = typeInfo.type;
+    QString iconKey = typeInfo.iconKey;
 
     QIcon fileIcon = m_publicIconMap.value(iconKey, m_publicIconMap["treeItem_Unknownfile"]);
 
@@ -454,171 +895,375 @@ void Widget::new_file()
     QStandardItem* typeItem = new QStandardItem(fileType);
     typeItem->setData(fileType, Qt::UserRole + 1);
     currentItem->appendRow({myFile, typeItem});
-    ui->treeView->setCurrentIndex(myFile->index());
+    setCurrentSourceIndex(myFile->index());
 }
 
 
 
-void Widget::dragEnterEvent(QDragEnterEvent *event)
+bool Widget::isDropTargetValid(const QModelIndex &index)
 {
-    if (event->mimeData()->hasFormat("application/x-qstandarditemmodeldatalist")) {
-        event->acceptProposedAction();
-    } else {
-        event->ignore();
-    }
+    if (!index.isValid()) return false;
+    QString type = treeModel()->data(index.sibling(index.row(), 1), Qt::DisplayRole).toString();
+    return (type == "文件夹");
 }
 
-void Widget::dragMoveEvent(QDragMoveEvent *event)
-{
-    if (event->mimeData()->hasFormat("application/x-qstandarditemmodeldatalist")) {
-        event->acceptProposedAction();
-    } else {
-        event->ignore();
+bool Widget::hasDuplicateName(QStandardItem *parent, const QString &name) {
+    if (!parent) return false;
+    for (int i = 0; i < parent->rowCount(); ++i) {
+        if (TreeEngine::sameName(parent->child(i, 0)->text(), name)) {
+            return true;
+        }
     }
+    return false;
 }
 
-void Widget::dropEvent(QDropEvent *event)
+void Widget::searchFile()
 {
-    if (!event->mimeData()->hasFormat("application/x-qstandarditemmodeldatalist")) {
-        event->ignore();
+    QString keyword = ui->searchEdit->text().trimmed();
+    if (keyword.isEmpty()) return;
+
+    searchResults.clear();
+    resultDetails.clear();
+    currentResultIndex = -1;
+    m_contentSearch->cancel();
+
+    if (ui->contentCheck->isChecked()) {
+        startContentSearch(keyword);
         return;
     }
-    QModelIndex dropIndex = ui->treeView->indexAt(event->position().toPoint());
-    if (!dropIndex.isValid()) {
-        event->ignore();
-        return;
+
+    QStandardItemModel* model = treeModel();
+    {
+        TRACE_SCOPE("search");
+        StallWatchdog::Activity activity("搜索 " + keyword);
+        ScopedDuration duration(s_searchMs);
+        // 含 "/" 时按路径查询，如 "C盘/文件夹1/**/*.txt"
+        if (keyword.contains('/')) {
+            collectPathMatches(keyword);
+        } else {
+            collectMatchingItems(model->invisibleRootItem(), keyword);
+        }
     }
 
-    // 判断拖放目标是否为“文件夹”类型
-    QString dropType = ui->treeView->model()->data(dropIndex.sibling(dropIndex.row(), 1)).toString();
-    if (dropType != "文件夹") {
-        // 拖到文件上，拒绝
-        event->ignore();
+    if (searchResults.isEmpty()) {
+        int total = countItems(model->invisibleRootItem());
+        QMessageBox::information(this, "未找到", QString("在 %1 个项目中未找到匹配的文件或文件夹！").arg(total));
         return;
     }
 
-    QStandardItemModel *model = static_cast<QStandardItemModel*>(ui->treeView->model());
-    QStandardItem *dropItem = model->itemFromIndex(dropIndex);
+    currentResultIndex = 0;
+    focusOnCurrentResult();
+}
 
-    if (!copiedItem) {
-        event->ignore();
-        return;
-    }
+QModelIndex Widget::findItemByName(QStandardItem* parent, const QString& name)
+{
+    // 找到第一个匹配项即停止
+    QStandardItem *found = nullptr;
+    s_itemWalker.first(parent, itemChildren, [&name](QStandardItem *child) {
+        return TreeEngine::nameMatches(child->text(), name);
+    }, found);
+    return found ? found->index() : QModelIndex();
+}
 
-    // 防止把一个项拖入它自己
-    QModelIndex dragIndex = ui->treeView->currentIndex();
-    if (dragIndex == dropIndex || dragIndex.parent() == dropIndex) {
-        event->ignore();
-        return;
+void Widget::collectMatchingItems(QStandardItem* parent, const QString& keyword)
+{
+    for (QStandardItem *item : matchingItems(parent, keyword)) {
+        searchResults.append(item->index());
     }
+}
 
-    // 拷贝拖拽项并插入
-    QStandardItem *newItem = deepCopyItem(copiedItem);
-    QString newType = newItem->data(Qt::UserRole + 1).toString();
-    QStandardItem *newTypeItem = new QStandardItem(newType);
-    newTypeItem->setData(newType, Qt::UserRole + 1);
+std::vector<QStandardItem*> Widget::matchingItems(QStandardItem* parent, const QString& keyword)
+{
+    return s_itemWalker.collect(parent, itemChildren, [&keyword](QStandardItem *child) {
+        return TreeEngine::nameMatches(child->text(), keyword);
+    });
+}
 
-    dropItem->appendRow({newItem, newTypeItem});
-    ui->treeView->setCurrentIndex(newItem->index());
+void Widget::collectPathMatches(const QString& query)
+{
+    PathPattern pattern(query);
+    if (!pattern.isValid() || (pattern.scope().isEmpty() && pattern.isLiteral())) return;
+
+    // 先通过路径索引定位搜索范围，只遍历范围内仍可能匹配的分支
+    QStandardItem *scope = m_pathIndex.find(pattern.scope());
+    if (!scope) {
+        if (!pattern.scope().isEmpty()) return;
+        scope = treeModel()->invisibleRootItem();
+    }
+    if (pattern.isLiteral()) {
+        searchResults.append(scope->index());
+        return;
+    }
 
-    event->acceptProposedAction();
+    struct PathNode
+    {
+        QStandardItem *item = nullptr;
+        quint64 state = 0;
+    };
+    auto children = [&pattern](const PathNode &node, std::vector<PathNode> &out) {
+        for (int i = 0; i < node.item->rowCount(); ++i) {
+            QStandardItem *child = node.item->child(i, 0);
+            quint64 state = pattern.advance(node.state, child->text());
+            if (state) {
+                out.push_back({child, state});
+            }
+        }
+    };
+    const std::vector<PathNode> found = s_itemWalker.collect(PathNode{scope, pattern.start()}, children,
+                                                             [&pattern](const PathNode &node) {
+        return pattern.matches(node.state);
+    });
+    for (const PathNode &node : found) {
+        searchResults.append(node.item->index());
+    }
 }
 
-void Widget::startDrag(QPoint pos)
+int Widget::countItems(QStandardItem* parent)
 {
-    QModelIndex index = ui->treeView->indexAt(pos);
-    if (!index.isValid()) return;
+    int total = 0;
+    s_itemWalker.walk(parent, itemChildren, [&total](QStandardItem *child, int) {
+        ++total;
+        return child->hasChildren();
+    });
+    return total;
+}
 
-    QStandardItemModel *model = static_cast<QStandardItemModel*>(ui->treeView->model());
-    copiedItem = model->itemFromIndex(index);
+void Widget::startContentSearch(const QString& keyword)
+{
+    // 收集所有绑定了真实路径的文件，按树中顺序排列
+    QStandardItemModel* model = treeModel();
+    const std::vector<QStandardItem*> items = s_itemWalker.collect(model->invisibleRootItem(), itemChildren,
+                                                                   [](QStandardItem *child) {
+        return !child->data(Qt::UserRole + 2).toString().isEmpty()
+               && child->data(Qt::UserRole + 1).toString() != "文件夹";
+    });
+
+    QStringList files;
+    m_contentFiles.clear();
+    for (QStandardItem *item : items) {
+        files.append(item->data(Qt::UserRole + 2).toString());
+        m_contentFiles.append(QPersistentModelIndex(item->index()));
+    }
+    m_contentSearch->start(files, keyword, m_walker.threadCount());
+}
 
-    QDrag *drag = new QDrag(this);
-    QMimeData *mimeData = new QMimeData;
+void Widget::addContentMatches(const QVector<ContentMatch> &matches)
+{
+    // 结果边搜边显示，第一批到达时立即定位
+    for (const ContentMatch &match : matches) {
+        QModelIndex index = m_contentFiles.value(match.file);
+        if (!index.isValid()) continue;
+        searchResults.append(index);
+        resultDetails.append(QString("第 %1 行，偏移 %2：%3").arg(match.line).arg(match.offset).arg(match.text));
+    }
+    if (currentResultIndex < 0 && !searchResults.isEmpty()) {
+        currentResultIndex = 0;
+        focusOnCurrentResult();
+    }
+}
 
-    // 使用自定义数据格式
-    mimeData->setData("application/x-qstandarditemmodeldatalist", QByteArray());
-    drag->setMimeData(mimeData);
+void Widget::contentSearchFinished(int scannedFiles, int matchCount)
+{
+    if (matchCount == 0) {
+        QMessageBox::information(this, "未找到", QString("在 %1 个绑定文件中未找到匹配的内容！").arg(scannedFiles));
+    }
+}
 
-    // 设置拖拽时的预览图像
-    QPixmap pixmap(ui->treeView->visualRect(index).size());
-    pixmap.fill(Qt::transparent);
-    QPainter painter(&pixmap);
-    painter.drawText(pixmap.rect(), Qt::AlignCenter, model->itemFromIndex(index)->text());
-    drag->setPixmap(pixmap);
-    drag->setHotSpot(QPoint(pixmap.width()/2, pixmap.height()/2));
+void Widget::detect_types()
+{
+    // 识别当前节点及其子树中所有绑定了真实路径的文件
+    QStandardItem* root = treeModel()->itemFromIndex(currentSourceIndex());
+    if (!root) return;
+    auto isBoundFile = [](QStandardItem *item) {
+        return FolderStats::isFile(item) && !item->data(Qt::UserRole + 2).toString().isEmpty();
+    };
+
+    QStringList files;
+    QStringList suffixes;
+    m_sniffFiles.clear();
+    for (QStandardItem *item : collectItems(root, isBoundFile)) {
+        files.append(item->data(Qt::UserRole + 2).toString());
+        suffixes.append(QFileInfo(item->text()).suffix());
+        m_sniffFiles.append(QPersistentModelIndex(item->index()));
+    }
+    if (files.isEmpty()) {
+        QMessageBox::information(this, "识别类型", "当前节点下没有绑定真实文件！");
+        return;
+    }
+    m_sniffedCount = 0;
+    ui->label->setText(QString("正在按内容识别 %1 个文件的类型...").arg(files.size()));
+    m_typeSniffer->start(files, suffixes, m_walker.threadCount());
+}
 
-    drag->exec(Qt::MoveAction);
+void Widget::applySniffedTypes(const QVector<SniffResult> &results)
+{
+    for (const SniffResult &result : results) {
+        QStandardItem* item = treeModel()->itemFromIndex(m_sniffFiles.value(result.file));
+        if (!item) continue;
+        // 内容无法判断时退回按节点名称的后缀识别
+        FileTypeInfo info = result.info.type.isEmpty() ? fileTypeForSuffix(QFileInfo(item->text()).suffix()) : result.info;
+        if (item->data(Qt::UserRole + 1).toString() == info.type) continue;
+
+        item->setData(info.type, Qt::UserRole + 1);
+        item->setIcon(m_publicIconMap.value(info.iconKey, m_publicIconMap["treeItem_Unknownfile"]));
+        QStandardItem* parent = item->parent() ? item->parent() : treeModel()->invisibleRootItem();
+        if (QStandardItem* typeItem = parent->child(item->row(), 1)) {
+            typeItem->setText(info.type);
+            typeItem->setData(info.type, Qt::UserRole + 1);
+        }
+        ++m_sniffedCount;
+    }
 }
 
-bool Widget::isDropTargetValid(const QModelIndex &index)
+void Widget::typeDetectionFinished(int scannedFiles, int readFiles)
 {
-    if (!index.isValid()) return false;
-    QString type = ui->treeView->model()->data(index.sibling(index.row(), 1), Qt::DisplayRole).toString();
-    return (type == "文件夹");
+    m_sniffFiles.clear();
+    ui->label->setText(QString("已识别 %1 个文件（读取 %2 个，其余来自缓存），%3 个文件的类型有变化")
+                           .arg(scannedFiles).arg(readFiles).arg(m_sniffedCount));
 }
 
-bool Widget::hasDuplicateName(QStandardItem *parent, const QString &name) {
-    if (!parent) return false;
-    for (int i = 0; i < parent->rowCount(); ++i) {
-        if (parent->child(i, 0)->text() == name) {
-            return true;
+void Widget::find_duplicates()
+{
+    // 收集整棵树中绑定的文件；多个节点绑定同一路径（如共享存储内容）时只查找一次
+    const std::vector<QStandardItem*> items = s_itemWalker.collect(treeModel()->invisibleRootItem(), itemChildren,
+                                                                   [](QStandardItem *child) {
+        return FolderStats::isFile(child) && !child->data(Qt::UserRole + 2).toString().isEmpty();
+    });
+
+    QStringList files;
+    QHash<QString, int> fileIndex;
+    m_duplicateNodes.clear();
+    for (QStandardItem *item : items) {
+        const QString path = item->data(Qt::UserRole + 2).toString();
+        auto it = fileIndex.constFind(path);
+        if (it == fileIndex.constEnd()) {
+            it = fileIndex.insert(path, files.size());
+            files.append(path);
+            m_duplicateNodes.append({});
         }
+        m_duplicateNodes[it.value()].append(QPersistentModelIndex(item->index()));
     }
-    return false;
+    if (files.isEmpty()) {
+        QMessageBox::information(this, "查找重复文件", "树中没有绑定真实文件！");
+        return;
+    }
+    m_duplicateFiles = files;
+    ui->label->setText(QString("正在比较 %1 个文件的内容...").arg(files.size()));
+    m_duplicateFinder->start(files, m_walker.threadCount());
 }
 
-void Widget::searchFile()
+void Widget::duplicatesFound(const QVector<DuplicateGroup> &groups, int scannedFiles, int hashedFiles, qint64 hashedBytes)
 {
-    QString keyword = ui->searchEdit->text().trimmed();
-    if (keyword.isEmpty()) return;
+    // 清除上次的标记
+    for (const QPersistentModelIndex &index : std::as_const(m_duplicateMarks)) {
+        if (QStandardItem* item = treeModel()->itemFromIndex(index)) {
+            item->setData(QVariant(), Qt::BackgroundRole);
+        }
+    }
+    m_duplicateMarks.clear();
 
     searchResults.clear();
+    resultDetails.clear();
     currentResultIndex = -1;
 
-    QStandardItemModel* model = static_cast<QStandardItemModel*>(ui->treeView->model());
-    collectMatchingItems(model->invisibleRootItem(), keyword);
+    // 每组的节点按顺序加入搜索结果，可用“上一个 / 下一个”逐个查看；相邻两组用不同底色区分
+    const QBrush tints[] = {QBrush(QColor(255, 243, 205)), QBrush(QColor(214, 234, 248))};
+    qint64 wasted = 0;
+    for (int g = 0; g < groups.size(); ++g) {
+        const DuplicateGroup &group = groups[g];
+        wasted += group.size * (group.files.size() - 1);
+        for (int file : group.files) {
+            for (const QPersistentModelIndex &index : m_duplicateNodes.value(file)) {
+                QStandardItem* item = treeModel()->itemFromIndex(index);
+                if (!item) continue;
+                item->setBackground(tints[g % 2]);
+                m_duplicateMarks.append(index);
+                searchResults.append(index);
+                resultDetails.append(QString("重复组 %1/%2（%3 个文件，各 %4）：%5")
+                                         .arg(g + 1).arg(groups.size()).arg(group.files.size())
+                                         .arg(FolderStats::formatSize(group.size), m_duplicateFiles.value(file)));
+            }
+        }
+    }
+    m_duplicateNodes.clear();
+    m_duplicateFiles.clear();
 
     if (searchResults.isEmpty()) {
-        QMessageBox::information(this, "未找到", "未找到匹配的文件或文件夹！");
+        ui->label->setText(show_path());
+        QMessageBox::information(this, "查找重复文件",
+                                 QString("在 %1 个绑定文件中未找到内容相同的文件（本次读取 %2 个文件，共 %3）。")
+                                     .arg(scannedFiles).arg(hashedFiles).arg(FolderStats::formatSize(hashedBytes)));
         return;
     }
-
+    QMessageBox::information(this, "查找重复文件",
+                             QString("在 %1 个绑定文件中找到 %2 组重复文件，可节省 %3（本次读取 %4 个文件，共 %5）。")
+                                 .arg(scannedFiles).arg(groups.size()).arg(FolderStats::formatSize(wasted))
+                                 .arg(hashedFiles).arg(FolderStats::formatSize(hashedBytes)));
     currentResultIndex = 0;
     focusOnCurrentResult();
 }
 
-QModelIndex Widget::findItemByName(QStandardItem* parent, const QString& name)
+void Widget::export_trace()
 {
-    for (int i = 0; i < parent->rowCount(); ++i) {
-        QStandardItem* child = parent->child(i, 0);  // 第0列是名称
-        if (child->text().contains(name, Qt::CaseInsensitive)) {
-            return child->index();
-        }
-        QModelIndex found = findItemByName(child, name);
-        if (found.isValid()) {
-            return found;
-        }
+    QString fileName = QFileDialog::getSaveFileName(this, "导出性能跟踪", "trace.json", "Chrome 跟踪文件 (*.json)");
+    if (fileName.isEmpty()) return;
+    if (!Trace::writeChromeJson(fileName)) {
+        QMessageBox::warning(this, "导出失败", QString("无法写入文件：\n%1").arg(fileName));
     }
-    return QModelIndex();
 }
 
-void Widget::collectMatchingItems(QStandardItem* parent, const QString& keyword)
+void Widget::show_diagnostics()
 {
-    for (int i = 0; i < parent->rowCount(); ++i) {
-        QStandardItem* child = parent->child(i, 0);  // 只看第0列
-        if (child->text().contains(keyword, Qt::CaseInsensitive)) {
-            searchResults.append(child->index());
+    if (!m_diagnostics) {
+        m_diagnostics = new DiagnosticsPanel(this);
+    }
+    m_diagnostics->setVisible(!m_diagnostics->isVisible());
+}
+
+void Widget::show_memory_usage()
+{
+    QStandardItem *item = treeModel()->itemFromIndex(currentSourceIndex());
+    if (!item) return;
+
+    // 汇总值由 m_modelCounters 增量维护，这里只读取，不遍历子树
+    const MemoryUsage usage = m_modelCounters.usage(item);
+    QString text = QString("%1\n\n节点数：%2\n合计：%3\n  节点开销：%4\n  文字：%5\n  图标：%6\n  路径：%7")
+        .arg(show_path())
+        .arg(usage.nodes)
+        .arg(FolderStats::formatSize(usage.total()))
+        .arg(FolderStats::formatSize(usage.nodeBytes))
+        .arg(FolderStats::formatSize(usage.stringBytes))
+        .arg(FolderStats::formatSize(usage.iconBytes))
+        .arg(FolderStats::formatSize(usage.pathBytes));
+
+    // 列出占用最多的几个子项，便于定位需要精简的数据
+    std::vector<std::pair<qint64, QStandardItem*>> children;
+    for (int i = 0; i < item->rowCount(); ++i) {
+        if (QStandardItem *child = item->child(i, 0)) {
+            children.emplace_back(m_modelCounters.usage(child).total(), child);
         }
-        collectMatchingItems(child, keyword);  // 递归查找
     }
+    const size_t shown = std::min<size_t>(5, children.size());
+    std::partial_sort(children.begin(), children.begin() + shown, children.end(),
+                      [](const auto &a, const auto &b) { return a.first > b.first; });
+    if (shown > 0) {
+        text += "\n\n占用最多的子项：";
+        for (size_t i = 0; i < shown; ++i) {
+            text += QString("\n  %1  %2").arg(children[i].second->text(), FolderStats::formatSize(children[i].first));
+        }
+    }
+    QMessageBox::information(this, "内存占用", text);
 }
 
 void Widget::focusOnCurrentResult()
 {
     if (currentResultIndex < 0 || currentResultIndex >= searchResults.size()) return;
     QModelIndex index = searchResults[currentResultIndex];
-    ui->treeView->setCurrentIndex(index);
-    ui->treeView->scrollTo(index);
+    setCurrentSourceIndex(index);
+    ui->treeView->scrollTo(m_sortModel->mapFromSource(index));
+    if (currentResultIndex < resultDetails.size()) {
+        ui->label->setText(show_path() + "  " + resultDetails[currentResultIndex]);
+    }
 }
 
 void Widget::gotoNextResult()
@@ -642,8 +1287,8 @@ void Widget::new_file_with_type(const QString& suffix)
     QString time = QString::number(timestamp);
     QString fileName = "新建文件" + time + "." + suffix;
 
-    QStandardItemModel* model = static_cast<QStandardItemModel*>(ui->treeView->model());
-    QModelIndex currentIndex = ui->treeView->currentIndex();
+    QStandardItemModel* model = treeModel();
+    QModelIndex currentIndex = currentSourceIndex();
     QStandardItem* currentItem = model->itemFromIndex(currentIndex);
 
     if (currentItem->data(Qt::UserRole + 1).toString() != "文件夹") {
@@ -658,68 +1303,32 @@ void Widget::new_file_with_type(const QString& suffix)
     }
 
     // 后缀类型识别
-    QString fileType;
-    QString iconKey;
-    QString lowerSuffix = suffix.toLower();
-
-    if (lowerSuffix == "txt") {
-        fileType = "txt文件";
-        iconKey = "treeItem_txt";
-    } else if (lowerSuffix == "pdf") {
-        fileType = "pdf文件";
-        iconKey = "treeItem_pdf";
-    } else if (lowerSuffix == "png") {
-        fileType = "png文件";
-        iconKey = "treeItem_png";
-    } else if (lowerSuffix == "doc") {
-        fileType = "doc文档";
-        iconKey = "treeItem_doc";
-    } else if (lowerSuffix == "gif") {
-        fileType = "gif文件";
-        iconKey = "treeItem_gif";
-    } else if (lowerSuffix == "ppt") {
-        fileType = "ppt文档";
-        iconKey = "treeItem_ppt";
-    } else if (lowerSuffix == "xls") {
-        fileType = "xls文档";
-        iconKey = "treeItem_xls";
-    } else if (lowerSuffix == "zip") {
-        fileType = "zip文件";
-        iconKey = "treeItem_zip";
-    } else {
-        fileType = "未知文件";
-        iconKey = "treeItem_Unknownfile";
-    }
+    FileTypeInfo typeInfo = fileTypeForSuffix(suffix);
+    QString fileType = typeInfo.type;
+    QString iconKey = typeInfo.iconKey;
 
     QIcon fileIcon = m_publicIconMap.value(iconKey, m_publicIconMap["treeItem_Unknownfile"]);
 
-    // 实际文件路径（你可以改路径）
-    QString filePath = QDir::currentPath() + "/" + fileName;
-
-    // 如果文件不存在，则创建空文件
-    QFile file(filePath);
-    if (!file.exists()) {
-        if (file.open(QIODevice::WriteOnly)) {
-            file.close();
-        }
-    }
-
-    // 创建项目节点
+    // 创建项目节点，内容放在后备存储中，新建的空文件都引用同一份空内容
     QStandardItem* myFile = new QStandardItem(fileIcon, fileName);
     myFile->setData(fileType, Qt::UserRole + 1);
-    myFile->setData(filePath, Qt::UserRole + 2);
+    bindBlob(myFile, BlobStore::emptyId());
+    QString filePath = myFile->data(Qt::UserRole + 2).toString();
     QStandardItem* typeItem = new QStandardItem(fileType);
     typeItem->setData(fileType, Qt::UserRole + 1);
     currentItem->appendRow({myFile, typeItem});
-    ui->treeView->setCurrentIndex(myFile->index());
+    setCurrentSourceIndex(myFile->index());
+
+    // 空文件在后台创建，失败时再标记到节点上
+    m_pendingIo.insert(m_fileIo->create(filePath), QPersistentModelIndex(myFile->index()));
 }
 
 void Widget::rename_item()
 {
-    QModelIndex currentIndex = ui->treeView->currentIndex();
+    QModelIndex currentIndex = currentSourceIndex();
     if (!currentIndex.isValid()) return;
 
-    QStandardItemModel* model = static_cast<QStandardItemModel*>(ui->treeView->model());
+    QStandardItemModel* model = treeModel();
     QStandardItem* currentItem = model->itemFromIndex(currentIndex.sibling(currentIndex.row(), 0));  // 只取第0列名称
     QStandardItem* parentItem = model->itemFromIndex(currentIndex.parent());
 
@@ -739,10 +1348,215 @@ void Widget::rename_item()
     }
 
     currentItem->setText(newName);
+
+    // 绑定了同名磁盘文件的节点同时重命名磁盘文件，失败时恢复
+    QString type = currentItem->data(Qt::UserRole + 1).toString();
+    QString path = currentItem->data(Qt::UserRole + 2).toString();
+    if (type == "文件夹" || path.isEmpty() || QFileInfo(path).fileName() != oldName) return;
+
+    QString target = QFileInfo(path).path() + "/" + newName;
+    currentItem->setData(target, Qt::UserRole + 2);
+    m_pendingIo.insert(m_fileIo->rename(path, target), QPersistentModelIndex(currentItem->index()));
+}
+
+QStandardItem* Widget::folderForNewItem()
+{
+    QStandardItemModel* model = treeModel();
+    QModelIndex currentIndex = currentSourceIndex();
+    QStandardItem* currentItem = model->itemFromIndex(currentIndex.sibling(currentIndex.row(), 0));
+    if (!currentItem) return nullptr;
+
+    // 当前是文件时导入到其父项
+    QString type = currentItem->data(Qt::UserRole + 1).toString();
+    if (type != "文件夹" && type != "驱动器") {
+        currentItem = currentItem->parent();
+    }
+    return currentItem;
 }
 
-void Widget::on_treeView_doubleClicked(const QModelIndex &index)
+void Widget::import_folder()
 {
+    QStandardItem* targetItem = folderForNewItem();
+    if (!targetItem || m_importer->isRunning()) return;
+
+    QString dirPath = QFileDialog::getExistingDirectory(this, "选择要导入的文件夹");
+    if (dirPath.isEmpty()) return;
+
+    QString name = QFileInfo(dirPath).fileName();
+    if (hasDuplicateName(targetItem, name.isEmpty() ? dirPath : name)) {
+        QMessageBox::warning(this, "命名冲突", "当前文件夹下已存在同名文件夹！");
+        return;
+    }
+
+    m_importTarget = QPersistentModelIndex(targetItem->index());
+    m_importer->start(dirPath, m_publicIconMap, m_walker.threadCount());
+
+    // 扫描在后台进行，这里只定时读取计数更新进度
+    m_importProgress = new QProgressDialog("正在扫描文件夹...", "取消", 0, 0, this);
+    m_importProgress->setWindowModality(Qt::WindowModal);
+    m_importProgress->setMinimumDuration(300);
+    connect(m_importProgress, &QProgressDialog::canceled, m_importer, &DirectoryImporter::cancel);
+    connect(m_importProgress, &QProgressDialog::canceled, this, [this]() {
+        importFinished({}, 0);
+    });
+
+    m_importTimer = new QTimer(this);
+    connect(m_importTimer, &QTimer::timeout, this, [this]() {
+        m_importProgress->setLabelText(QString("正在扫描文件夹... 已发现 %1 项").arg(m_importer->scanned()));
+    });
+    m_importTimer->start(100);
+}
+
+void Widget::importFinished(QList<QStandardItem*> root, qint64 entries)
+{
+    if (m_importTimer) {
+        m_importTimer->deleteLater();
+        m_importTimer = nullptr;
+    }
+    if (m_importProgress) {
+        m_importProgress->deleteLater();
+        m_importProgress = nullptr;
+    }
+    if (root.isEmpty()) return;
+
+    QStandardItemModel* model = treeModel();
+    QStandardItem* targetItem = model->itemFromIndex(m_importTarget);
+    if (!targetItem || hasDuplicateName(targetItem, root[0]->text())) {
+        qDeleteAll(root);
+        return;
+    }
+
+    // 整棵子树在后台建好，这里只挂接一次
+    targetItem->appendRow(root);
+    watchFolder(root[0]);
+    setCurrentSourceIndex(root[0]->index());
+    ui->label->setText(show_path() + QString("  （已导入 %1 项）").arg(entries));
+}
+
+void Widget::watchFolder(QStandardItem* item)
+{
+    QString path = item->data(Qt::UserRole + 2).toString();
+    if (path.isEmpty() || m_watchedRoots.contains(path)) return;
+    m_watchedRoots.insert(path, QPersistentModelIndex(item->index()));
+    m_diskWatcher->addTree(path);
+}
+
+void Widget::watchImportedFolders()
+{
+    // 导入的根目录：绑定了路径、但父项没有绑定路径的文件夹
+    // 系统、驱动器和普通文件夹都没有绑定路径，一律向下查找；遇到绑定路径的节点即停止，不再深入
+    QStandardItemModel* model = treeModel();
+    auto isBound = [](QStandardItem *child) {
+        return !child->data(Qt::UserRole + 2).toString().isEmpty();
+    };
+    const std::vector<QStandardItem*> roots = s_itemWalker.collect(model->invisibleRootItem(), itemChildren,
+        [&](QStandardItem *child) {
+            return isBound(child) && child->data(Qt::UserRole + 1).toString() == "文件夹";
+        },
+        [&](QStandardItem *child) { return !isBound(child); });
+    for (QStandardItem *item : roots) {
+        watchFolder(item);
+    }
+}
+
+void Widget::unwatchRemovedFolders()
+{
+    for (auto it = m_watchedRoots.begin(); it != m_watchedRoots.end();) {
+        if (it.value().isValid()) {
+            ++it;
+            continue;
+        }
+        m_diskWatcher->removeTree(it.key());
+        it = m_watchedRoots.erase(it);
+    }
+}
+
+QStandardItem* Widget::itemForDiskPath(const QString& path)
+{
+    QStandardItemModel* model = treeModel();
+    for (auto it = m_watchedRoots.constBegin(); it != m_watchedRoots.constEnd(); ++it) {
+        const QString &root = it.key();
+        if (path != root && !path.startsWith(root + '/')) continue;
+
+        QStandardItem* item = model->itemFromIndex(it.value());
+        const QStringList names = path.mid(root.size()).split('/', Qt::SkipEmptyParts);
+        for (const QString &name : names) {
+            if (!item) break;
+            QStandardItem* next = nullptr;
+            for (int i = 0; i < item->rowCount(); ++i) {
+                if (item->child(i, 0)->text() == name) {
+                    next = item->child(i, 0);
+                    break;
+                }
+            }
+            item = next;
+        }
+        if (item) return item;
+    }
+    return nullptr;
+}
+
+void Widget::applyDiskChanges(const QVector<DiskChange> &changes)
+{
+    // 按所在目录分组，每个目录只定位一次、只建一次名称表；QMap 有序，上层目录先处理
+    QMap<QString, QVector<const DiskChange*>> byFolder;
+    for (const DiskChange &change : changes) {
+        byFolder[change.path.left(change.path.lastIndexOf('/'))].append(&change);
+    }
+
+    for (auto it = byFolder.constBegin(); it != byFolder.constEnd(); ++it) {
+        QStandardItem* folder = itemForDiskPath(it.key());
+        if (!folder) continue;
+
+        QHash<QString, int> rows;
+        for (int i = 0; i < folder->rowCount(); ++i) {
+            rows.insert(folder->child(i, 0)->text(), i);
+        }
+
+        QVector<int> removed;
+        QList<QList<QStandardItem*>> created;
+        for (const DiskChange *change : it.value()) {
+            const QString name = change->path.mid(change->path.lastIndexOf('/') + 1);
+            auto row = rows.constFind(name);
+            const bool exists = row != rows.constEnd() && row.value() >= 0;
+            if (change->kind == DiskChange::Removed) {
+                if (exists) removed.append(row.value());
+            } else if (!exists) {
+                if (change->kind == DiskChange::Created && row == rows.constEnd()) {
+                    created.append(DirectoryImporter::makeRow(change->path, change->dir, m_publicIconMap));
+                    rows.insert(name, -1);
+                }
+            } else {
+                QStandardItem* item = folder->child(row.value(), 0);
+                const bool isDir = item->data(Qt::UserRole + 1).toString() == "文件夹";
+                if (change->kind == DiskChange::Created && (change->replaced || isDir != change->dir)) {
+                    // 删除后以同名（可能换了类型）重新建立：整行替换
+                    removed.append(row.value());
+                    created.append(DirectoryImporter::makeRow(change->path, change->dir, m_publicIconMap));
+                    rows.insert(name, -1);
+                } else if (!isDir) {
+                    // 内容被修改，或被覆盖写入（如保存时先写临时文件再改名）
+                    m_folderStats.refresh(item);
+                    m_metadataColumns.refresh(item);
+                }
+            }
+        }
+
+        // 从后往前删除，保证行号不失效
+        std::sort(removed.begin(), removed.end(), std::greater<int>());
+        for (int row : removed) {
+            folder->removeRow(row);
+        }
+        for (const QList<QStandardItem*> &row : created) {
+            folder->appendRow(row);
+        }
+    }
+    unwatchRemovedFolders();
+}
+
+void Widget::on_treeView_doubleClicked(const QModelIndex &viewIndex)
+{
+    QModelIndex index = m_sortModel->mapToSource(viewIndex);
     QString type = index.sibling(index.row(), 1).data(Qt::DisplayRole).toString();
     if (type == "文件夹" || type == "驱动器" || type == "system")
         return;
@@ -753,10 +1567,9 @@ void Widget::on_treeView_doubleClicked(const QModelIndex &index)
         return;
     }
 
-    bool ok = QDesktopServices::openUrl(QUrl::fromLocalFile(filePath));
-    if (!ok) {
-        QMessageBox::warning(this, "打开失败", QString("无法打开文件：\n%1").arg(filePath));
-    }
+    QStandardItemModel* model = treeModel();
+    if (checkoutForEditing(model->itemFromIndex(index.sibling(index.row(), 0)))) return;
+    openPath(filePath);
 }
 
 void Widget::openFile(const QModelIndex &index)
@@ -778,8 +1591,7 @@ void Widget::openFile(const QModelIndex &index)
     }
 
     // 尝试用系统默认程序打开
-    bool ok = QDesktopServices::openUrl(QUrl::fromLocalFile(filePath));
-    if (!ok) {
-        QMessageBox::warning(this, "打开失败", QString("无法打开文件：\n%1").arg(filePath));
-    }
+    QStandardItemModel* model = treeModel();
+    if (checkoutForEditing(model->itemFromIndex(index.sibling(index.row(), 0)))) return;
+    openPath(filePath);
 }
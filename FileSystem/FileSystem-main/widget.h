@@ -23,6 +23,36 @@
 #include <QUrl>
 #include <QMessageBox>
 #include <QDir>
+#include <QFileDialog>
+#include <QProgressDialog>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
+#include <QShortcut>
+#include <vector>
+
+#include "treewalker.h"
+#include "treeengine.h"
+#include "trace.h"
+#include "counters.h"
+#include "modelcounters.h"
+#include "eventloopmonitor.h"
+#include "diagnosticspanel.h"
+#include "stallwatchdog.h"
+#include "treeservice.h"
+#include "pathindex.h"
+#include "contentsearch.h"
+#include "directoryimporter.h"
+#include "diskwatcher.h"
+#include "fileioqueue.h"
+#include "blobstore.h"
+#include "folderstats.h"
+#include "metadatacolumns.h"
+#include "sortmodel.h"
+#include "filetypes.h"
+#include "typesniffer.h"
+#include "duplicatefinder.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class Widget; }
@@ -36,11 +66,6 @@ public:
     Widget(QWidget *parent = nullptr);
     ~Widget();
 
-protected:
-    void dragEnterEvent(QDragEnterEvent *event) override;
-    void dragMoveEvent(QDragMoveEvent *event) override;
-    void dropEvent(QDropEvent *event) override;
-
 private slots:
     void on_treeView_clicked(const QModelIndex &index);
     void on_treeView_customContextMenuRequested(const QPoint &pos);
@@ -50,33 +75,113 @@ private slots:
     void delete_file();
     void copy_file();
     void paste_file();
+    void paste_file_copy();
     QString show_path();
     void searchFile();
+    void startContentSearch(const QString& keyword);
+    void addContentMatches(const QVector<ContentMatch> &matches);
+    void contentSearchFinished(int scannedFiles, int matchCount);
+    void detect_types();
+    void applySniffedTypes(const QVector<SniffResult> &results);
+    void typeDetectionFinished(int scannedFiles, int readFiles);
+    void find_duplicates();
+    void export_trace();
+    void show_diagnostics();
+    void show_memory_usage();
+    void duplicatesFound(const QVector<DuplicateGroup> &groups, int scannedFiles, int hashedFiles, qint64 hashedBytes);
     void gotoNextResult();
     void gotoPrevResult();
     void rename_item();
+    void import_folder();
+    void importFinished(QList<QStandardItem*> root, qint64 entries);
     void openFile(const QModelIndex &index);
-    void on_treeView_doubleClicked(const QModelIndex &index);
+    void on_treeView_doubleClicked(const QModelIndex &viewIndex);
 
 private:
     Ui::Widget *ui;
-    QStandardItem *copiedItem = nullptr;
+    QStandardItem *copiedItem = nullptr;      // 复制的子树副本，不在模型中；它引用的存储内容不会被删除
     QMap<QString, QIcon> m_publicIconMap;
+    TreeWalker m_walker;
+    BlobStore m_store;
     QStandardItem* deepCopyItem(QStandardItem* item);
-    void startDrag(QPoint pos);
+    void setCopiedItem(QStandardItem* item);
     QModelIndex findItemByName(QStandardItem* parent, const QString& name);
+    std::vector<QStandardItem*> matchingItems(QStandardItem* parent, const QString& keyword);
+    int countItems(QStandardItem* parent);
 
     void initModel();
+    void setTreeModel(QStandardItemModel *model);
+    // 视图显示的是排序模型，以下几个函数在视图索引与底层模型索引之间转换
+    QStandardItemModel* treeModel() const;
+    QModelIndex currentSourceIndex() const;
+    QModelIndex sourceIndexAt(const QPoint &pos) const;
+    void setCurrentSourceIndex(const QModelIndex &index);
     void saveToJson(const QString &filename);
+    void fillEngine(TreeEngine &engine);
     bool loadFromJson(const QString &filename);
-    QJsonObject saveItem(QStandardItem *item);
-    QList<QStandardItem*> loadItem(const QJsonObject &obj);
+    // 界面节点与树引擎节点之间的转换，prepared 中是已并行转换好的子树
+    std::unique_ptr<TreeNode> nodeFromItem(QStandardItem *item, const QHash<qint64, QString> &iconKeys) const;
+    QStandardItem* itemFromNode(const TreeNode *node) const;
+    void showTree(const TreeEngine &engine);
     bool isDropTargetValid(const QModelIndex &index);
     bool hasDuplicateName(QStandardItem *parent, const QString &name);
     QList<QModelIndex> searchResults;
+    QStringList resultDetails;    // 内容搜索时每个结果对应的行号和内容
     int currentResultIndex = -1;
+    ContentSearch *m_contentSearch = nullptr;
+    QVector<QPersistentModelIndex> m_contentFiles;
+    TypeSniffer *m_typeSniffer = nullptr;
+    QVector<QPersistentModelIndex> m_sniffFiles;            // 正在识别类型的文件节点，与识别列表同序
+    int m_sniffedCount = 0;
+    DuplicateFinder *m_duplicateFinder = nullptr;
+    QStringList m_duplicateFiles;                           // 正在查找的文件路径
+    QVector<QVector<QPersistentModelIndex>> m_duplicateNodes;   // 与 m_duplicateFiles 同序，绑定该路径的节点
+    QVector<QPersistentModelIndex> m_duplicateMarks;        // 上次标出底色的节点
+    DirectoryImporter *m_importer = nullptr;
+    QPersistentModelIndex m_importTarget;
+    QProgressDialog *m_importProgress = nullptr;
+    QTimer *m_importTimer = nullptr;
+    QStandardItem* folderForNewItem();
+    DiskWatcher *m_diskWatcher = nullptr;
+    QHash<QString, QPersistentModelIndex> m_watchedRoots;   // 导入的真实目录 → 对应的文件夹节点
+    void watchFolder(QStandardItem* item);
+    void watchImportedFolders();
+    void unwatchRemovedFolders();
+    QStandardItem* itemForDiskPath(const QString& path);
+    void applyDiskChanges(const QVector<DiskChange> &changes);
+    FileIoQueue *m_fileIo = nullptr;
+    QHash<quint64, QPersistentModelIndex> m_pendingIo;      // 进行中的磁盘操作 → 对应节点
+    QSet<quint64> m_openAfterIo;                            // 完成后需要打开文件的检出操作
+    QStringList boundFiles(QStandardItem* item, QStringList* stored = nullptr);
+    void removeBoundFiles(const QStringList& files);
+    void fileOperationsFinished(const QVector<FileOperation> &results);
+    void markFileError(QStandardItem* item, const QString& message);
+    void bindBlob(QStandardItem* item, const QString& id);
+    std::vector<QStandardItem*> workingCopies(QStandardItem* item);
+    void detachWorkingCopies(QStandardItem* item);
+    void commitWorkingFiles();
+    void rebindStoredFiles(const QHash<QString, QString>& storedIds);
+    bool checkoutForEditing(QStandardItem* item);
+    void openPath(const QString& filePath);
+    void pasteItem(bool copyFiles);
+    void copyBoundFiles(QStandardItem* item);
+    void updateCopyProgress();
+    QTimer *m_copyTimer = nullptr;
+    QElapsedTimer m_copyClock;
+    qint64 m_copyStartBytes = 0;
     void focusOnCurrentResult();
     void collectMatchingItems(QStandardItem* parent, const QString& keyword);
+    void collectPathMatches(const QString& query);
+    PathIndex m_pathIndex;
+    FolderStats m_folderStats;
+    MetadataColumns m_metadataColumns;
+    ModelCounters m_modelCounters;
+    EventLoopMonitor *m_loopMonitor = nullptr;
+    StallWatchdog *m_stallWatchdog = nullptr;
+    TreeService *m_treeService = nullptr;
+    void applyTreeChanges(const QVector<TreeChange> &changes);
+    DiagnosticsPanel *m_diagnostics = nullptr;
+    SortModel *m_sortModel = nullptr;
     void new_file_with_type(const QString& suffix);
 };
 #endif // WIDGET_H